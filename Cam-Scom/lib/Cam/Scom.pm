@@ -1412,6 +1412,7 @@ sub write
 		    {
 			##  Replace write buffer with kill msg
 			##  and set close-on-flush.
+			$this->_release_passed_fds ($fh);
 			$fh->{write_buf} = [$fh->{write_buf_killmsg}];
 			$fh->{write_buf_size} =
 			  length ($fh->{write_buf_killmsg});
@@ -1519,6 +1520,58 @@ sub write
     return (1, "");
 };
 
+=head2 ->write_fd ($filehandle, $data, $passfd)
+
+Like ->write() for a stream, but also passes the open file
+descriptor $passfd to the peer as SCM_RIGHTS ancillary data
+attached to the first byte of $data.  $filehandle must be a
+registered ">" or "+" Unix domain socket and $data must not be
+empty.  The descriptor is queued in order with previously
+written data and is closed here once it has been sent, or when
+the filehandle is stopped before it could be sent, so the
+caller must not close it.  Returns ($ok, $msg) where $ok is
+true on success, false on failure.  On failure, $msg is an
+error message and $passfd has not been closed.
+
+=cut
+
+sub write_fd
+{
+    my Cam::Scom $this = shift (@_);
+    my ($fhandle) = shift (@_);
+    my ($data) = shift (@_);
+    my ($passfd) = shift (@_);
+    my Cam::Scom::Fh $fh;
+    my ($fhname, $index);
+
+    ##  Get the Cam::Scom::Fh object
+    $fhname = _fh_to_name ($fhandle);
+    defined ($index = $this->{fhname_to_index}{$fhname})
+      || return (0, "Filehandle \"$fhname\" not registered");
+    $fh = $this->{fhs}[$index];
+
+    ##  Is filehandle stopped or close-on-flush?
+    if ((! $fh->{write_open}) || ($fh->{close_on_flush}))
+    {
+	return (0, "Filehandle \"$fhname\" not open for writing");
+    };
+    $fh->{messaging}
+      && return (0, "Filehandle \"$fhname\" is not a stream");
+    length ($data)
+      || return (0, "No data to carry descriptor on \"$fhname\"");
+
+    ##  Queue the data and descriptor together so that
+    ##  _flush() sends them with one sendmsg()
+    push (@{$fh->{write_buf}}, [$data, $passfd]);
+    $fh->{write_buf_size} += length ($data);
+    vec ($this->{write_mask}, $fh->{fd}, 1) = 1;
+
+    ##  Try to flush it now
+    $this->_flush (0, 0);
+
+    return (1, "");
+};
+
 =head2 ->expect ($receive_pipe, $to_receive, $timeout)
 
 Blocks until  the entire   input on   registered $receive_pipe
@@ -2062,6 +2115,30 @@ sub c_connect
     return (1, "");
 };
 
+=head2 c_sendfd(fd,data,passfd)
+
+Returns ($ok, $msg, $sent) from the system call sendmsg(2),
+sending $data on the Unix domain socket $fd with the file
+descriptor $passfd attached as SCM_RIGHTS ancillary data.
+$ok is true on success.  $msg is an error message on failure.
+$sent is the number of bytes of $data written.  The receiver
+gets its own copy of $passfd along with the first byte of
+$data, so the caller may close $passfd once this returns.
+
+=cut
+
+sub c_sendfd
+{
+    my ($fd) = shift;
+    my ($data) = shift;
+    my ($passfd) = shift;
+    my ($r);
+
+    $r = Cam::Scom::_c_sendfd ($fd, $data, $passfd);
+    ($r == -1) && return (0, "$!");
+    return (1, "", $r);
+};
+
 sub _child_safe_die
 {
     my (@msg) = @_;
@@ -2251,7 +2328,7 @@ sub _flush
 	$activity, $buf, $r, $list, $errno, $messaging, $spec_select);
     my ($fd_to_fh, $reads_returned, $writes_returned, $spec_mask);
     my ($fhs) = $this->{fhs};
-    my ($fh_has_event);
+    my ($fh_has_event, $passfd);
 
     defined ($timeout) && ($timeout == -1) && ($timeout = undef);
     $fd_to_fh = $this->{fd_to_fh};
@@ -2655,16 +2732,33 @@ sub _flush
 		$list = $fh->{write_buf};
 		$index = $fh->{write_buf_size};
 		$buf = shift (@$list);
-		while ((($r = length ($buf)) < Blocksize) &&
-		       ($r < $index))
+		if (ref ($buf))
 		{
-		    $buf .= shift (@$list);
+		    ##  Data carrying a descriptor from ->write_fd(),
+		    ##  sent on its own so the descriptor stays with it
+		    ($buf, $passfd) = @$buf;
+		    $r = Cam::Scom::_c_sendfd ($fh->{fd}, $buf, $passfd);
+		    ($r == -1) && ($r = undef);
+		}
+		else
+		{
+		    $passfd = undef;
+		    while ((($r = length ($buf)) < Blocksize) &&
+			   ($r < $index) && (! ref ($list->[0])))
+		    {
+			$buf .= shift (@$list);
+		    };
+		    $r = POSIX::write ($fh->{fd}, $buf, length ($buf));
 		};
-		$r = POSIX::write ($fh->{fd}, $buf, length ($buf));
 		if (! defined ($r))
 		{
 		    ##  Pipe got an error
 		    $errno = $! + 0;
+		    if (defined ($passfd))
+		    {
+			##  Keep the descriptor queued for another try
+			unshift (@$list, [$buf, $passfd]);
+		    };
 		    if (($errno != EAGAIN) && ($errno != EINTR))
 		    {
 			if (vec ($spec_mask, $fh->{fd}, 1))
@@ -2678,6 +2772,7 @@ sub _flush
 		{
 		    ##  A successful write of $r bytes to filehandle $fh.
 		    $fh->{write_buf_size} -= $r;
+		    defined ($passfd) && POSIX::close ($passfd);
 
 		    ##  Log it.
 		    if (defined ($this->{log_dir}) && $r)
@@ -2757,6 +2852,25 @@ sub _flush
 ##    print ::STDOUT ("_flush exited\n");
 };
 
+##  ->_release_passed_fds ($fh)
+##    -- Closes any descriptors still queued by ->write_fd() on
+##       Cam::Scom::Fh $fh, leaving their data queued as plain bytes
+sub _release_passed_fds
+{
+    my Cam::Scom $this = shift (@_);
+    my Cam::Scom::Fh $fh = shift (@_);
+    my ($entry);
+
+    foreach $entry (@{$fh->{write_buf}})
+    {
+	if (ref ($entry))
+	{
+	    POSIX::close ($entry->[1]);
+	    $entry = $entry->[0];
+	};
+    };
+};
+
 ##  &_is_fd_used ($fd)
 ##    Returns true if $fd is an in-use file descriptor
 sub _is_fd_used
@@ -3015,6 +3129,7 @@ sub _stop_pipe
 
     defined ($fh->{term}) || ($fh->{term} = $err_number);
     $this->{fh_has_event}{$fh->{fh}} = 1;
+    $this->_release_passed_fds ($fh);
     $fh->{read_open} = 0;
     $fd = $fh->{fd};
     vec ($this->{read_mask}, $fd, 1) = 0;
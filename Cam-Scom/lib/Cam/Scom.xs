@@ -23,6 +23,8 @@
 #include <sys/select.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <string.h>
 
 MODULE = Cam::Scom  PACKAGE = Cam::Scom
 
@@ -246,3 +248,45 @@ _c_connect (fdarg, addrarg)
     r = connect (fd, addr, (socklen_t) addrlen);
     XPUSHs (sv_2mortal (newSViv (r)));
 
+void
+_c_sendfd (fdarg, dataarg, passfdarg)
+    SV *fdarg
+    SV *dataarg
+    SV *passfdarg
+  INIT:
+
+  /*  Provides sendmsg(2) with an SCM_RIGHTS descriptor to perl  */
+  /*  Use as:  $r = _c_sendfd ($fd, $data, $passfd);  */
+
+    int r;
+    int fd;
+    int passfd;
+    char *data;
+    STRLEN datalen;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    union
+    {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+  PPCODE:
+    fd = SvIV(fdarg);
+    data = SvPV(dataarg, datalen);
+    passfd = SvIV(passfdarg);
+    iov.iov_base = data;
+    iov.iov_len = datalen;
+    memset (&msg, 0, sizeof(msg));
+    memset (&control, 0, sizeof(control));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy (CMSG_DATA(cmsg), &passfd, sizeof(int));
+    r = sendmsg (fd, &msg, 0);
+    XPUSHs (sv_2mortal (newSViv (r)));
@@ -18,7 +18,9 @@
 ##  You should have received a copy of the GNU General Public License
 ##  along with Cam-Scom; if not, see <http://www.gnu.org/licenses/>.
 
-use Fcntl qw(O_NDELAY F_GETFL F_SETFL);
+use Fcntl qw(O_NDELAY F_GETFL F_SETFL O_RDONLY);
+use Socket qw(AF_UNIX SOCK_STREAM PF_UNSPEC);
+use POSIX ();
 use Test::More qw( no_plan );
 use Cam::Scom;
 
@@ -84,10 +86,32 @@ sub check_fcntl_in_c
     unlink ("/tmp/scomaccel_test.remove_me");
 };
 
+sub check_sendfd_in_c
+{
+    my ($ok, $msg, $fd0, $fd1, $passfd, $sent, $buf, $r);
+
+    ($ok, $msg, $fd0, $fd1) =
+      Cam::Scom::c_socketpair (AF_UNIX, SOCK_STREAM, PF_UNSPEC);
+    is ($ok, 1, "c_socketpair() success");
+    $passfd = POSIX::open ("/dev/null", O_RDONLY);
+    is (defined ($passfd), 1, "open() of descriptor to pass");
+    ($ok, $msg, $sent) = Cam::Scom::c_sendfd ($fd0, "fd\n", $passfd);
+    is ($ok, 1, "c_sendfd() success");
+    is ($sent, 3, "c_sendfd() sent all data");
+    $r = POSIX::read ($fd1, $buf, 16);
+    is ($buf, "fd\n", "data sent with descriptor arrives");
+    ($ok, $msg) = Cam::Scom::c_sendfd ($fd0, "x", -1);
+    is ($ok, 0, "c_sendfd() fails for bad descriptor");
+    POSIX::close ($passfd);
+    POSIX::close ($fd0);
+    POSIX::close ($fd1);
+};
+
 sub main
 {
     check_mask_to_array_in_c();
     check_fcntl_in_c();
+    check_sendfd_in_c();
 };
 
 main();
@@ -60,6 +60,8 @@ A keyseq is data defining a valid sequence of keys:
                     {"keys"}         -- string of valid key choices (if max==1)
                     {"fullmatch"}    -- regex matching whole pattern
                     {"prematch"}     -- regex matching prefix (only for max>1)
+                    {"prefixmatch"}  -- regex matching an incomplete
+                                        variable-length input (if defined)
 	            {"tags"}{<key>}  -- tag for each key (if defined)
                     {"lentype"}      -- either "fixed" or "variable" length
                     {"min"}          -- minimum length
@@ -232,6 +234,12 @@ sub check_keyseq_match
 	    };
 	};
     };
+    ##  Look for prefix match of a pattern that is more than a repeat
+    if ((! $is_suffix) && defined ($keyset->{"prefixmatch"}) &&
+	($input =~ $keyset->{"prefixmatch"}))
+    {
+	return (0, undef);
+    };
     $last_chance && return (-1, undef);
     $is_suffix || return (-1, undef);
     $failed_end_match || return (-1, undef);
@@ -648,7 +656,8 @@ sub parse_srgsdtmf_grammar
     my ($result) = {};
 
     ##  Handle all builtin: cases
-    if ($grammar =~ /^builtin:[^\/]*\/(boolean|digits)\??(.*)/)
+    if ($grammar =~
+	/^builtin:[^\/]*\/(boolean|digits|number|currency|date|time)\??(.*)/)
     {
 	##  It's a builtin
 	$builtin_type = $1;
@@ -676,8 +685,8 @@ sub parse_srgsdtmf_grammar
 	    $keyseq = {"min_total" => 1,
 		       "max_total" => 1,
 		       "has-variable" => 0,
-		       "keyset" => ["fullmatch" => qr/^[0-9\*#]$/s,
-				    {"tags" => {"0" => "false",
+		       "keyset" => [{"fullmatch" => qr/^[0-9\*#]$/s,
+				     "tags" => {"0" => "false",
 						"1" => "true",
 						"2" => "false",
 						"3" => "false",
@@ -687,28 +696,80 @@ sub parse_srgsdtmf_grammar
 						"7" => "false",
 						"8" => "false",
 						"9" => "false",
-						"\\*" => "false",
+						"*" => "false",
 						"#" => "false"},
 				     "lentype" => "fixed",
 				     "min" => 1,
 				     "max" => 1,
 				    }],
 		      };
+	    ##  A given yes key replaces 1, as in VXIrec
 	    if (defined ($builtin_arg_map->{"y"}) &&
 		($builtin_arg_map->{"y"} =~ /^[0-9\*#]$/so))
 	    {
+		$keyseq->{"keyset"}[0]{"tags"}{"1"} = "false";
 		$keyseq->{"keyset"}[0]{"tags"}{$builtin_arg_map->{"y"}}
 		  = "true";
 	    };
 	    if (defined ($builtin_arg_map->{"n"}) &&
 		($builtin_arg_map->{"n"} =~ /^[0-9\*#]$/so))
 	    {
-		$keyseq->{"keyset"}[0]{"tags"}{$builtin_args->{"n"}}
+		$keyseq->{"keyset"}[0]{"tags"}{$builtin_arg_map->{"n"}}
 		  = "false";
 	    };
 	    return (1, "", {"type" => "rule",
 			    "keyseq" => [$keyseq]});
 	}
+	elsif (($builtin_type eq "number") || ($builtin_type eq "currency"))
+	{
+	    ##  Digits with "*" as a decimal point, optional "#".
+	    ##  The value is left to VXIrec, which gets it from the keys.
+	    $keyseq = {"min_total" => 1,
+		       "max_total" => $SRGSDTMF::MaxVarDigits,
+		       "has-variable" => 1,
+		       "keyset" =>
+		       [
+			{
+			 "fullmatch" => qr/^[0-9]+(\*[0-9]+)?#?$/s,
+			 "maxmatch" => qr/^[0-9]+(\*[0-9]+)?#$/s,
+			 "prefixmatch" => qr/^[0-9]+\*$/s,
+			 "tags" => {},
+			 "lentype" => "variable",
+			 "min" => 1,
+			 "max" => $SRGSDTMF::MaxVarDigits,
+			},
+		       ],
+		      };
+	    return (1, "", {"type" => "rule",
+			    "keyseq" => [$keyseq]});
+	}
+	elsif (($builtin_type eq "date") || ($builtin_type eq "time"))
+	{
+	    ##  yyyymmdd or hhmm, the value left to VXIrec
+	    $keyset = {"tags" => {},
+		       "lentype" => "fixed"};
+	    if ($builtin_type eq "date")
+	    {
+		$keyset->{"fullmatch"} =
+		  qr/^[0-9]{4}(0[1-9]|1[0-2])(0[1-9]|[12][0-9]|3[01])$/s;
+		$keyset->{"prematch"} =
+		  qr/^([0-9]{0,4}|[0-9]{4}[01]|[0-9]{4}(0[1-9]|1[0-2])[0-3]?)$/s;
+		$keyset->{"min"} = $keyset->{"max"} = 8;
+	    }
+	    else
+	    {
+		$keyset->{"fullmatch"} = qr/^([01][0-9]|2[0-3])[0-5][0-9]$/s;
+		$keyset->{"prematch"} =
+		  qr/^([0-2]?|[01][0-9]|2[0-3]|([01][0-9]|2[0-3])[0-5])$/s;
+		$keyset->{"min"} = $keyset->{"max"} = 4;
+	    };
+	    $keyseq = {"min_total" => $keyset->{"min"},
+		       "max_total" => $keyset->{"max"},
+		       "has-variable" => 0,
+		       "keyset" => [$keyset]};
+	    return (1, "", {"type" => "rule",
+			    "keyseq" => [$keyseq]});
+	}
 	else  ##  builtin type is digits
 	{
 	    $min = 1;
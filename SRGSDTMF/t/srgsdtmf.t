@@ -20,7 +20,7 @@
 ##  You should have received a copy of the GNU General Public License
 ##  along with SRGSDTMF; if not, see <http://www.gnu.org/licenses/>.
 
-use Test::More tests => 59;
+use Test::More tests => 67;
 
 use SRGSDTMF;
 
@@ -430,3 +430,19 @@ is (sjoin (",", SRGSDTMF::check_rules_match
 is (((($ok, $msg, $_) = SRGSDTMF::parse_srgsdtmf_grammar($trouble_gram)))[0],
     1,
     "check parse of once-trouble grammar");
+
+##  Builtins that VXIrec gives values to
+foreach (["builtin:dtmf/boolean", "1", "2,true"],
+	 ["builtin:dtmf/boolean?y=7;n=1", "1", "2,false"],
+	 ["builtin:dtmf/boolean?y=7", "1", "2,false"],
+	 ["builtin:dtmf/boolean?y=7", "7", "2,true"],
+	 ["builtin:dtmf/number", "3*", "0,"],
+	 ["builtin:dtmf/number", "3*14#", "2,"],
+	 ["builtin:dtmf/date", "20071301", "-1,"],
+	 ["builtin:dtmf/time", "1745", "2,"])
+{
+    my ($builtin, $input, $expected) = @$_;
+    my ($rule) = (SRGSDTMF::parse_srgsdtmf_grammar ($builtin))[2];
+    is (sjoin (",", (SRGSDTMF::check_rules_match ($input, $rule))[0,1]),
+	$expected, "check_rules_match ($input, $builtin)");
+};
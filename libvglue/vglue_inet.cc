@@ -21,18 +21,176 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <cerrno>
+#include <strings.h>
+#include <ctime>
+#include <pthread.h>
 #include <vglue_ipc.h>
+#include <vglue_msg.h>
 #include <vglue_tostring.h>
 #include <vglue_inet.h>
 #include <string>
 #include <cstring>
 #include <cstdlib>
 #include <sstream>
+#include <map>
 
 #include <VXIinet.h>
 
 /*  voiceglue inet (HTTP fetch) routines  */
 
+/*
+ *  Freshness cache of HttpGet replies, shared by all threads.  voiceglue
+ *  reports when it last fetched or revalidated a URL and until when it
+ *  would serve its cached copy without revalidating it, so until then
+ *  the same local path can be used without asking it again.  Entries
+ *  are keyed by URL alone, so only calls without cookies use them,
+ *  and voiceglue only reports replies to requests that carried none
+ *  and set none.
+ */
+#define VOICEGLUE_HTTP_FRESH_MAX_ENTRIES 4096
+
+struct voiceglue_http_fresh_entry
+{
+    std::string path;
+    std::string content_type;
+    time_t validated;
+    time_t expires;
+};
+
+typedef std::map<std::string, voiceglue_http_fresh_entry>
+    voiceglue_http_fresh_map;
+static pthread_mutex_t voiceglue_http_fresh_mutex = PTHREAD_MUTEX_INITIALIZER;
+static voiceglue_http_fresh_map voiceglue_http_fresh;
+
+/*!
+**  Records the freshness of a URL reported by voiceglue
+**  @param url IN: The URL fetched
+**  @param entry IN: Its local path, content-type and freshness
+*/
+static void voiceglue_http_fresh_record (const std::string &url,
+					 const voiceglue_http_fresh_entry &entry)
+{
+    time_t now = time (NULL);
+    pthread_mutex_lock (&voiceglue_http_fresh_mutex);
+    if ((voiceglue_http_fresh.size() >= VOICEGLUE_HTTP_FRESH_MAX_ENTRIES) &&
+	(voiceglue_http_fresh.find (url) == voiceglue_http_fresh.end()))
+    {
+	//  Make room, first by dropping expired entries, else the
+	//  entry expiring soonest
+	voiceglue_http_fresh_map::iterator it = voiceglue_http_fresh.begin();
+	voiceglue_http_fresh_map::iterator soonest = it;
+	while (it != voiceglue_http_fresh.end())
+	{
+	    if (it->second.expires < now)
+	    {
+		voiceglue_http_fresh.erase (it++);
+		continue;
+	    };
+	    if (it->second.expires < soonest->second.expires)
+	    {
+		soonest = it;
+	    };
+	    ++it;
+	};
+	if (voiceglue_http_fresh.size() >= VOICEGLUE_HTTP_FRESH_MAX_ENTRIES)
+	{
+	    voiceglue_http_fresh.erase (soonest);
+	};
+    };
+    voiceglue_http_fresh[url] = entry;
+    pthread_mutex_unlock (&voiceglue_http_fresh_mutex);
+};
+
+/*!
+**  Looks up a URL voiceglue recently reported fresh
+**  @param url IN: The URL to fetch with GET and no arguments
+**  @param maxage IN: Maximum age in seconds of the copy, -1 for any
+**  @param maxstale IN: Seconds the copy may be past its expiry, -1 for 0
+**  @param path OUT: local path to the content
+**  @param content_type OUT: content-type of the content
+**  @return 1 if the local copy can be used, 0 if voiceglue must be asked
+**  or this thread's call has cookies
+*/
+int voiceglue_http_fresh_lookup (const VXIchar *url,
+				 long maxage,
+				 long maxstale,
+				 std::string &path,
+				 std::string &content_type)
+{
+    std::string key = VXIchar_to_Std_String (url);
+    time_t now = time (NULL);
+    int fresh = 0;
+
+    //  A request with cookies must reach voiceglue
+    if (voiceglue_ipc_call_has_cookies())
+    {
+	return 0;
+    };
+
+    pthread_mutex_lock (&voiceglue_http_fresh_mutex);
+    voiceglue_http_fresh_map::iterator it = voiceglue_http_fresh.find (key);
+    if ((it != voiceglue_http_fresh.end()) &&
+	((maxage < 0) || (now - it->second.validated <= maxage)) &&
+	(now < it->second.expires + ((maxstale > 0) ? maxstale : 0)))
+    {
+	path = it->second.path;
+	content_type = it->second.content_type;
+	fresh = 1;
+    };
+    pthread_mutex_unlock (&voiceglue_http_fresh_mutex);
+
+    //  voiceglue may have removed it before its invalidation arrived
+    struct stat statinfo;
+    if (fresh && (::stat (path.c_str(), &statinfo) == -1))
+    {
+	voiceglue_http_fresh_invalidate (path);
+	fresh = 0;
+    };
+
+    if (voiceglue_loglevel() >= LOG_DEBUG)
+    {
+	std::ostringstream logstring;
+	logstring << "voiceglue_http_fresh_lookup(" << key << ") "
+		  << (fresh ? "hit " : "miss") << (fresh ? path : "");
+	voiceglue_log ((char) LOG_DEBUG, logstring);
+    };
+
+    return fresh;
+};
+
+/*!
+**  Forgets URLs whose content was at a local path voiceglue has
+**  replaced or removed
+**  @param path IN: The local path
+*/
+void voiceglue_http_fresh_invalidate (const std::string &path)
+{
+    int evicted = 0;
+    pthread_mutex_lock (&voiceglue_http_fresh_mutex);
+    voiceglue_http_fresh_map::iterator it = voiceglue_http_fresh.begin();
+    while (it != voiceglue_http_fresh.end())
+    {
+	if (it->second.path == path)
+	{
+	    voiceglue_http_fresh.erase (it++);
+	    ++evicted;
+	}
+	else
+	{
+	    ++it;
+	};
+    };
+    pthread_mutex_unlock (&voiceglue_http_fresh_mutex);
+
+    if (voiceglue_loglevel() >= LOG_DEBUG)
+    {
+	std::ostringstream logstring;
+	logstring << "voiceglue_http_fresh_invalidate(" << path
+		  << ") evicted " << evicted;
+	voiceglue_log ((char) LOG_DEBUG, logstring);
+    };
+};
+
 /*
  *  Support for urlencoding
  */
@@ -163,24 +321,29 @@ UrlEncodeString(const std::string & decoded) {
 **  @param parsevxml IN: whether a VXML parse should be obtained
 **  @param path OUT: local path to fetched content
 **  @param content_type OUT: content-type of fetched content
-**  @param parse_tree_addr OUT: VXML document's parse tree addr, or "" for none*/
-void voiceglue_http_get (const VXIchar *method,
-			 const VXIchar *url,
-			 const VXIMap *postdata_map,
-			 int parsevxml,
-			 std::string &path,
-    			 std::string &content_type,
-			 std::string &parse_tree_addr)
+**  @param parse_tree_addr OUT: VXML document's parse tree addr, or "" for none
+**  @return 1 if voiceglue reported the reply fresh, so that it would
+**  serve it unchanged to the same request, 0 otherwise
+**  Replies to GETs without arguments, parse or cookies may also carry
+**  the times the content was validated and expires, these are recorded
+**  for voiceglue_http_fresh_lookup()*/
+static int voiceglue_http_fetch (const VXIchar *method,
+				 const VXIchar *url,
+				 const VXIMap *postdata_map,
+				 int parsevxml,
+				 std::string &path,
+				 std::string &content_type,
+				 std::string &parse_tree_addr)
 {
-  std::string method_utf8 = VXIchar_to_Std_String (method);
-  std::string url_utf8 = VXIchar_to_Std_String (url);
-
-  //  Convert postdata_map to URL string
-  std::string postdata_utf8 = "\"\"";
+  //  Send the request, with postdata_map as a URL-encoded string
+  voiceglue_msg &ipc_msg_out = voiceglue_msg_builder();
+  ipc_msg_out.begin ("HttpGet")
+      .add_quoted (method)
+      .add_quoted (url)
+      .space();
+  int items_shown = 0;
   if (postdata_map != NULL)
   {
-      std::ostringstream postdata_utf8_stream;
-      int items_shown = 0;
       const VXIchar *key = NULL;
       const VXIValue *gvalue = NULL;
       VXIMapIterator *it =
@@ -190,46 +353,34 @@ void voiceglue_http_get (const VXIchar *method,
       {
 	  if (items_shown++)
 	  {
-	      postdata_utf8_stream << "&";
+	      ipc_msg_out.add ("&", 1);
 	  };
-	  postdata_utf8_stream
-	      << UrlEncodeString(VXIchar_to_Std_String (key)) << "="
-	      << UrlEncodeString(VXIValue_to_Std_String (gvalue));
+	  ipc_msg_out.open_urlencode().add (key).close_urlencode()
+	      .add ("=", 1)
+	      .open_urlencode().add (gvalue).close_urlencode();
 	  ret = VXIMapGetNextProperty(it, &key, &gvalue);
       }
       VXIMapIteratorDestroy(&it);
-      postdata_utf8 = postdata_utf8_stream.str();
-      if (postdata_utf8.length() == 0)
-      {
-	  postdata_utf8 = "\"\"";
-      };
   };
+  if (items_shown == 0)
+  {
+      ipc_msg_out.add ("\"\"", 2);
+  };
+  ipc_msg_out.space().add ((long) parsevxml);
 
   if (voiceglue_loglevel() >= LOG_DEBUG)
   {
       std::ostringstream logstring;
-      logstring << "voiceglue_http_get called with method=" << method_utf8
-		<< " url=" << url_utf8
-		<< " postdata="
-		<< postdata_utf8
-		<< " (encoded from map: "
+      logstring << "voiceglue_http_get called with method="
+		<< VXIchar_to_Std_String (method)
+		<< " url=" << VXIchar_to_Std_String (url)
+		<< " postdata map: "
 		<< VXIValue_to_Std_String((const VXIValue *)postdata_map)
-		<< ") parsevxml=" << parsevxml;
+		<< " parsevxml=" << parsevxml;
       voiceglue_log ((char) LOG_DEBUG, logstring);
   };
 
-  std::ostringstream ipc_msg_out;
-  ipc_msg_out
-      << "HttpGet "
-      << voiceglue_escape_SATC_string (method_utf8)
-      << " "
-      << voiceglue_escape_SATC_string (url_utf8)
-      << " "
-      << postdata_utf8
-      << " "
-      << parsevxml
-      << "\n";
-  voiceglue_sendipcmsg (ipc_msg_out);
+  ipc_msg_out.send();
 
   std::string ipc_msg_in;
   ipc_msg_in = voiceglue_getipcmsg();
@@ -265,5 +416,193 @@ void voiceglue_http_get (const VXIchar *method,
       parse_tree_addr = "";
   };
 
-  return;
+  //  Split off freshness, as "<validated> <expires>" after the tree addr
+  long validated = 0, expires = 0;
+  int has_freshness = 0;
+  space_pos = parse_tree_addr.find (" ");
+  if (space_pos > 0)
+  {
+      std::istringstream freshness (parse_tree_addr.substr (space_pos+1));
+      parse_tree_addr = parse_tree_addr.substr (0, space_pos);
+      has_freshness = (freshness >> validated >> expires) ? 1 : 0;
+  };
+  if ((! parsevxml) && (! voiceglue_ipc_call_has_cookies()) &&
+      ((postdata_map == NULL) || (VXIMapNumProperties (postdata_map) == 0)) &&
+      (strcasecmp (VXIchar_to_Std_String (method).c_str(), "GET") == 0))
+  {
+      if (has_freshness)
+      {
+	  voiceglue_http_fresh_entry entry;
+	  entry.path = path;
+	  entry.content_type = content_type;
+	  entry.validated = (time_t) validated;
+	  entry.expires = (time_t) expires;
+	  voiceglue_http_fresh_record (VXIchar_to_Std_String (url), entry);
+      }
+      else
+      {
+	  //  No longer cacheable, or not fetched
+	  pthread_mutex_lock (&voiceglue_http_fresh_mutex);
+	  voiceglue_http_fresh.erase (VXIchar_to_Std_String (url));
+	  pthread_mutex_unlock (&voiceglue_http_fresh_mutex);
+      };
+  };
+
+  return has_freshness;
+};
+
+/*!
+**  Gets a filename of a downloaded URL, see voiceglue_http_fetch()
+*/
+void voiceglue_http_get (const VXIchar *method,
+			 const VXIchar *url,
+			 const VXIMap *postdata_map,
+			 int parsevxml,
+			 std::string &path,
+    			 std::string &content_type,
+			 std::string &parse_tree_addr)
+{
+    voiceglue_http_fetch (method, url, postdata_map, parsevxml,
+			  path, content_type, parse_tree_addr);
+};
+
+/*
+ *  HttpGets in progress, shared by all threads.  Threads asking for a
+ *  URL already being fetched by another wait for its reply instead of
+ *  sending the same request to voiceglue.  voiceglue also keys its
+ *  cache by the call's cookies and fetches uncacheable items once per
+ *  request, so only calls without cookies share fetches, and a reply
+ *  is only handed to waiters when voiceglue reported it fresh.
+ */
+struct voiceglue_http_flight
+{
+    int done;
+    int shareable;
+    int waiters;
+    std::string path;
+    std::string content_type;
+    pthread_cond_t cond;
+};
+
+typedef std::map<std::string, voiceglue_http_flight *>
+    voiceglue_http_flight_map;
+static pthread_mutex_t voiceglue_http_flight_mutex = PTHREAD_MUTEX_INITIALIZER;
+static voiceglue_http_flight_map voiceglue_http_flights;
+
+/*!
+**  Gets a filename of a downloaded URL with GET, sharing the fetch with
+**  other threads requesting the same URL and arguments at the same time
+**  when this thread's call has no cookies
+**  @param url IN: The URL to download
+**  @param postdata_map IN: arguments to pass via HTTP
+**  @param wait_ms IN: Milliseconds to wait for another thread's fetch
+**                     before fetching independently
+**  @param path OUT: local path to fetched content
+**  @param content_type OUT: content-type of fetched content
+*/
+void voiceglue_http_get_shared (const VXIchar *url,
+				const VXIMap *postdata_map,
+				long wait_ms,
+				std::string &path,
+				std::string &content_type)
+{
+    std::string parse_tree_addr;
+    if (voiceglue_ipc_call_has_cookies())
+    {
+	voiceglue_http_fetch (L"GET", url, postdata_map, 0,
+			      path, content_type, parse_tree_addr);
+	return;
+    };
+
+    std::string key = VXIchar_to_Std_String (url);
+    if ((postdata_map != NULL) && (VXIMapNumProperties (postdata_map) > 0))
+    {
+	key += " ";
+	key += VXIValue_to_Std_String ((const VXIValue *) postdata_map);
+    };
+
+    pthread_mutex_lock (&voiceglue_http_flight_mutex);
+    voiceglue_http_flight_map::iterator it = voiceglue_http_flights.find (key);
+    if (it == voiceglue_http_flights.end())
+    {
+	//  Lead the fetch
+	voiceglue_http_flight *flight = new voiceglue_http_flight;
+	flight->done = 0;
+	flight->shareable = 0;
+	flight->waiters = 0;
+	pthread_cond_init (&flight->cond, NULL);
+	voiceglue_http_flights[key] = flight;
+	pthread_mutex_unlock (&voiceglue_http_flight_mutex);
+
+	int shareable = voiceglue_http_fetch (L"GET", url, postdata_map, 0,
+					      path, content_type,
+					      parse_tree_addr);
+
+	pthread_mutex_lock (&voiceglue_http_flight_mutex);
+	voiceglue_http_flights.erase (key);
+	flight->shareable = shareable;
+	flight->path = path;
+	flight->content_type = content_type;
+	flight->done = 1;
+	pthread_cond_broadcast (&flight->cond);
+	if (flight->waiters == 0)
+	{
+	    pthread_cond_destroy (&flight->cond);
+	    delete flight;
+	};
+	pthread_mutex_unlock (&voiceglue_http_flight_mutex);
+	return;
+    };
+
+    //  Wait for the thread already fetching it
+    voiceglue_http_flight *flight = it->second;
+    struct timespec deadline;
+    clock_gettime (CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += wait_ms / 1000;
+    deadline.tv_nsec += (wait_ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000)
+    {
+	deadline.tv_sec += 1;
+	deadline.tv_nsec -= 1000000000;
+    };
+    ++flight->waiters;
+    while (! flight->done)
+    {
+	if (pthread_cond_timedwait (&flight->cond,
+				    &voiceglue_http_flight_mutex,
+				    &deadline) == ETIMEDOUT)
+	{
+	    break;
+	};
+    };
+    int shared = flight->done && flight->shareable;
+    if (shared)
+    {
+	path = flight->path;
+	content_type = flight->content_type;
+    };
+    int flight_done = flight->done;
+    if ((--flight->waiters == 0) && flight->done)
+    {
+	pthread_cond_destroy (&flight->cond);
+	delete flight;
+    };
+    pthread_mutex_unlock (&voiceglue_http_flight_mutex);
+
+    if (voiceglue_loglevel() >= LOG_DEBUG)
+    {
+	std::ostringstream logstring;
+	logstring << "voiceglue_http_get_shared(" << key << ") "
+		  << (shared ? "shared fetch returns " :
+		      (flight_done ? "shared fetch not shareable" :
+		       "timed out waiting for shared fetch"))
+		  << path;
+	voiceglue_log ((char) LOG_DEBUG, logstring);
+    };
+
+    if (! shared)
+    {
+	voiceglue_http_fetch (L"GET", url, postdata_map, 0,
+			      path, content_type, parse_tree_addr);
+    };
 };
@@ -35,4 +35,18 @@ void voiceglue_http_get (const VXIchar *method,
 			 std::string &content_type,
 			 std::string &parse_tree_addr);
 
+void voiceglue_http_get_shared (const VXIchar *url,
+				const VXIMap *postdata_map,
+				long wait_ms,
+				std::string &path,
+				std::string &content_type);
+
+int voiceglue_http_fresh_lookup (const VXIchar *url,
+				 long maxage,
+				 long maxstale,
+				 std::string &path,
+				 std::string &content_type);
+
+void voiceglue_http_fresh_invalidate (const std::string &path);
+
 #endif /* include guard VGLUE_INET_H */
@@ -24,11 +24,16 @@
 #include <pthread.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <sched.h>
 #include <map>
 #include <sstream>
 #include <VXItrd.h>
 
 #include <vglue_ipc.h>
+#include <vglue_inet.h>
 
 /*  voiceglue IPC routines  */
 
@@ -37,7 +42,28 @@
 #include <errno.h>
 static pthread_mutex_t voiceglue_threadmap_mutex;
 static std::map<VXIthreadID, int> voiceglue_threadid_to_fd;
-static std::map<VXIthreadID, int> voiceglue_threadid_to_callid;
+
+/*  Callid of the registering thread, used to prefix its log messages  */
+static __thread int voiceglue_my_callid = -1;
+
+/*  Per-thread IPC channel state, owned by the registered thread  */
+struct voiceglue_ipc_channel
+{
+    int fd;
+    /*  Line status pushed asynchronously by voiceglue:
+        1 = connected, 0 = hung up.  Only written with the
+        __sync builtins so that readers need no lock.  */
+    volatile int line_status;
+    /*  1 once voiceglue has reported that the call's cookie jar holds
+        cookies, which only voiceglue fetches send.  Never reset.  */
+    volatile int has_cookies;
+    /*  Bytes received but not yet returned as complete messages  */
+    std::string rcvbuf;
+    /*  Descriptor passed by voiceglue with SCM_RIGHTS and not yet
+        claimed by voiceglue_ipc_take_fd(), or -1  */
+    int passed_fd;
+};
+static __thread voiceglue_ipc_channel *voiceglue_my_channel = NULL;
 
 /* 
  * Register a voiceglue IPC file descriptor and callid with this thread
@@ -50,8 +76,13 @@ int voiceglue_registeripcfd (int fd, int callid)
     VXIthreadID thread_id = VXItrdThreadGetID();
     pthread_mutex_lock (&voiceglue_threadmap_mutex);
     voiceglue_threadid_to_fd[thread_id] = fd;
-    voiceglue_threadid_to_callid[thread_id] = callid;
     pthread_mutex_unlock (&voiceglue_threadmap_mutex);
+    voiceglue_my_callid = callid;
+    voiceglue_my_channel = new voiceglue_ipc_channel;
+    voiceglue_my_channel->fd = fd;
+    voiceglue_my_channel->line_status = 1;
+    voiceglue_my_channel->has_cookies = 0;
+    voiceglue_my_channel->passed_fd = -1;
     return (0);
 };
 
@@ -67,8 +98,15 @@ int voiceglue_unregisteripcfd()
     voiceglue_sendipcmsg ("\n");
     pthread_mutex_lock (&voiceglue_threadmap_mutex);
     voiceglue_threadid_to_fd.erase(thread_id);
-    voiceglue_threadid_to_callid.erase(thread_id);
     pthread_mutex_unlock (&voiceglue_threadmap_mutex);
+    voiceglue_my_callid = -1;
+    if ((voiceglue_my_channel != NULL) &&
+	(voiceglue_my_channel->passed_fd != -1))
+    {
+	close (voiceglue_my_channel->passed_fd);
+    };
+    delete voiceglue_my_channel;
+    voiceglue_my_channel = NULL;
     //  Do not close fds here, as with:
     //  int fd = voiceglue_threadid_to_fd[thread_id];;
     //  close (fd);
@@ -81,26 +119,32 @@ int voiceglue_unregisteripcfd()
 /* 
  * Send a voiceglue IPC message
  *
- * @param msg  The null-terminated bytes to send exactly (must supply own \n)
+ * @param msg  The bytes to send exactly (must supply own \n)
+ * @param len  The number of bytes in msg
  */
-int voiceglue_sendipcmsg (const char *msg)
+int voiceglue_sendipcmsg (const char *msg, size_t len)
 {
     int fd;
-    int written;
+    size_t written;
     int r;
     VXIthreadID myThreadID = VXItrdThreadGetID();
-    int len = strlen (msg);
 
     /*  Look up IPC fd  */
-    pthread_mutex_lock (&voiceglue_threadmap_mutex);
-    fd = voiceglue_threadid_to_fd[myThreadID];
-    pthread_mutex_unlock (&voiceglue_threadmap_mutex);
+    if (voiceglue_my_channel != NULL)
+    {
+	fd = voiceglue_my_channel->fd;
+    }
+    else
+    {
+	pthread_mutex_lock (&voiceglue_threadmap_mutex);
+	fd = voiceglue_threadid_to_fd[myThreadID];
+	pthread_mutex_unlock (&voiceglue_threadmap_mutex);
+    };
 
-    if (voiceglue_loglevel() >= LOG_DEBUG)
+    if ((voiceglue_loglevel() >= LOG_DEBUG) && (len > 0))
     {
 	std::ostringstream debugmsg;
-	std::string msgcontent (msg);
-	msgcontent.erase (len-1, 1);
+	std::string msgcontent (msg, len-1);
 	debugmsg << "snd vg: "
 		 << msgcontent;
 	voiceglue_log ((char) LOG_DEBUG, debugmsg);
@@ -127,6 +171,16 @@ int voiceglue_sendipcmsg (const char *msg)
     return (0);
 };
 
+/* 
+ * Send a voiceglue IPC message
+ *
+ * @param msg  The null-terminated bytes to send exactly (must supply own \n)
+ */
+int voiceglue_sendipcmsg (const char *msg)
+{
+    return voiceglue_sendipcmsg (msg, strlen (msg));
+};
+
 /* 
  * Send a voiceglue IPC message
  *
@@ -134,7 +188,7 @@ int voiceglue_sendipcmsg (const char *msg)
  */
 int voiceglue_sendipcmsg (std::string &msg)
 {
-    return voiceglue_sendipcmsg (msg.c_str());
+    return voiceglue_sendipcmsg (msg.data(), msg.length());
 };
 
 /* 
@@ -148,37 +202,175 @@ int voiceglue_sendipcmsg (std::ostringstream &msg)
 };
 
 /*!
-** Receives an voiceglue IPC message
+** Removes the next complete message from a receive buffer
+** @param rcvbuf The buffer of received bytes
+** @param msg Out the message with terminating newline removed
+** @return 1 if a complete message was found, 0 otherwise
+*/
+static int voiceglue_next_buffered_msg (std::string &rcvbuf, std::string &msg)
+{
+    std::string::size_type eol = rcvbuf.find ('\n');
+    if (eol == std::string::npos)
+    {
+	return 0;
+    };
+    msg.assign (rcvbuf, 0, eol);
+    rcvbuf.erase (0, eol + 1);
+    return 1;
+};
+
+/*!
+** Handles a message pushed by voiceglue without a request from us
+** @param channel The channel state of the calling thread
+** @param msg The message with terminating newline removed
+** @return 1 if msg was an asynchronous notification, 0 otherwise
+*/
+static int voiceglue_handle_async_msg (voiceglue_ipc_channel *channel,
+				       const std::string &msg)
+{
+    if (msg.compare (0, 15, "HttpInvalidate ") == 0)
+    {
+	//  Evicts for all threads, the fresh URL map is process-wide
+	voiceglue_http_fresh_invalidate (msg.substr (15));
+    }
+    else if (msg.compare ("Hungup") == 0)
+    {
+	if (channel != NULL)
+	{
+	    __sync_lock_test_and_set (&channel->line_status, 0);
+	};
+    }
+    else if (msg.compare ("HttpCookies") == 0)
+    {
+	if (channel != NULL)
+	{
+	    __sync_lock_test_and_set (&channel->has_cookies, 1);
+	};
+    }
+    else
+    {
+	return 0;
+    };
+    if (voiceglue_loglevel() >= LOG_DEBUG)
+    {
+	std::ostringstream debugmsg;
+	debugmsg << "rcv vg async: " << msg;
+	voiceglue_log ((char) LOG_DEBUG, debugmsg);
+    };
+    return 1;
+};
+
+/*!
+** Reads from the IPC fd, keeping any descriptor passed along with
+** the bytes.  A descriptor not yet claimed is replaced (and closed)
+** by a newer one, so a request that never claims one cannot leak it.
+** @param channel The channel state of the calling thread, or NULL
+** @param fd The IPC fd
+** @param buf Buffer to fill
+** @param len Size of buf
+** @param flags Flags as for recv(2)
+** @return as for recv(2)
+*/
+static ssize_t voiceglue_ipc_recv (voiceglue_ipc_channel *channel, int fd,
+				   char *buf, size_t len, int flags)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    union
+    {
+	struct cmsghdr align;
+	char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    ssize_t r;
+    int passed_fd;
+
+    iov.iov_base = buf;
+    iov.iov_len = len;
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+    r = recvmsg (fd, &msg, flags | MSG_CMSG_CLOEXEC);
+    if (r <= 0)
+    {
+	return r;
+    };
+
+    for (cmsg = CMSG_FIRSTHDR(&msg);
+	 cmsg != NULL;
+	 cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+	if ((cmsg->cmsg_level != SOL_SOCKET) ||
+	    (cmsg->cmsg_type != SCM_RIGHTS) ||
+	    (cmsg->cmsg_len < CMSG_LEN(sizeof(int))))
+	{
+	    continue;
+	};
+	memcpy (&passed_fd, CMSG_DATA(cmsg), sizeof (int));
+	if (channel == NULL)
+	{
+	    close (passed_fd);
+	    continue;
+	};
+	if (channel->passed_fd != -1)
+	{
+	    close (channel->passed_fd);
+	};
+	channel->passed_fd = passed_fd;
+    };
+    if ((msg.msg_flags & MSG_CTRUNC) && (voiceglue_loglevel() >= LOG_WARNING))
+    {
+	std::ostringstream errmsg;
+	errmsg << "passed descriptor truncated on fd=" << fd;
+	voiceglue_log ((char) LOG_WARNING, errmsg);
+    };
+
+    return r;
+};
+
+/*!
+** Receives an voiceglue IPC message, consuming any asynchronous
+** notifications that arrive ahead of it
 ** @return the message with terminating newline removed
 */
 std::string voiceglue_getipcmsg()
 {
     int fd;
-    int bytes_read = 0;
-    int bufsize = 1024;
     int r;
     char buf[1024];
     std::string msg;
+    std::string local_rcvbuf;
+    voiceglue_ipc_channel *channel = voiceglue_my_channel;
     VXIthreadID myThreadID = VXItrdThreadGetID();
 
     /*  Look up IPC fd  */
-    pthread_mutex_lock (&voiceglue_threadmap_mutex);
-    fd = voiceglue_threadid_to_fd[myThreadID];
-    pthread_mutex_unlock (&voiceglue_threadmap_mutex);
+    if (channel != NULL)
+    {
+	fd = channel->fd;
+    }
+    else
+    {
+	pthread_mutex_lock (&voiceglue_threadmap_mutex);
+	fd = voiceglue_threadid_to_fd[myThreadID];
+	pthread_mutex_unlock (&voiceglue_threadmap_mutex);
+    };
+    std::string &rcvbuf = (channel != NULL) ? channel->rcvbuf : local_rcvbuf;
 
-    /*  Read the data  */
-    while ((bytes_read == 0) || (buf[bytes_read-1] != '\n'))
+    /*  Read the data until a complete non-notification message arrives  */
+    for (;;)
     {
-	/*  See if we have exhausted the buffer  */
-	if (bytes_read == bufsize)
+	if (voiceglue_next_buffered_msg (rcvbuf, msg))
 	{
-	    /*  Store this buffer contents into msg, and start clean  */
-	    msg.append (buf, bytes_read);
-	    bytes_read = 0;
+	    if (voiceglue_handle_async_msg (channel, msg))
+	    {
+		continue;
+	    };
+	    break;
 	};
 
-	/*  Perform the read to fill up buf  */
-	r = read (fd, buf + bytes_read, bufsize - bytes_read);
+	r = voiceglue_ipc_recv (channel, fd, buf, sizeof (buf), 0);
 	if (r == -1)
 	{
 	    if (errno != EINTR)
@@ -187,12 +379,16 @@ std::string voiceglue_getipcmsg()
 		return ("");
 	    };
 	}
+	else if (r == 0)
+	{
+	    printf ("FATAL voiceglue error: thread %d got EOF reading from fd=%d\n", (int) myThreadID, fd);
+	    return ("");
+	}
 	else
 	{
-	    bytes_read += r;
+	    rcvbuf.append (buf, r);
 	};
     };
-    msg.append (buf, bytes_read - 1);    //  Strip off terminating newline
 
     if (voiceglue_loglevel() >= LOG_DEBUG)
     {
@@ -204,6 +400,107 @@ std::string voiceglue_getipcmsg()
     return (msg);
 };
 
+/*!
+** Returns the line status last pushed by voiceglue for this thread.
+** Notifications already waiting on the IPC fd are picked up without
+** blocking, so no request/response round trip is made.
+** @return 1 if the line is connected, 0 if it has hung up
+*/
+int voiceglue_ipc_line_status()
+{
+    int r;
+    char buf[1024];
+    std::string msg;
+    std::string::size_type eol;
+    voiceglue_ipc_channel *channel = voiceglue_my_channel;
+
+    if (channel == NULL)
+    {
+	return 0;
+    };
+    if (__sync_fetch_and_add (&channel->line_status, 0) == 0)
+    {
+	return 0;
+    };
+
+    /*  Drain anything already sent to us  */
+    for (;;)
+    {
+	r = voiceglue_ipc_recv (channel, channel->fd, buf, sizeof (buf),
+				MSG_DONTWAIT);
+	if (r > 0)
+	{
+	    channel->rcvbuf.append (buf, r);
+	}
+	else if ((r == -1) && (errno == EINTR))
+	{
+	    continue;
+	}
+	else
+	{
+	    break;
+	};
+    };
+
+    /*  Only notifications can be pending here, as no request is
+        outstanding, but leave anything else for voiceglue_getipcmsg()  */
+    while ((eol = channel->rcvbuf.find ('\n')) != std::string::npos)
+    {
+	msg.assign (channel->rcvbuf, 0, eol);
+	if (! voiceglue_handle_async_msg (channel, msg))
+	{
+	    break;
+	};
+	channel->rcvbuf.erase (0, eol + 1);
+    };
+
+    return __sync_fetch_and_add (&channel->line_status, 0);
+};
+
+/*!
+** Claims the descriptor voiceglue passed with the last message
+** received on this thread, if any.  The caller owns and must close it.
+** @return the descriptor, or -1 if none was passed
+*/
+int voiceglue_ipc_take_fd()
+{
+    int fd;
+
+    if (voiceglue_my_channel == NULL)
+    {
+	return -1;
+    };
+    fd = voiceglue_my_channel->passed_fd;
+    voiceglue_my_channel->passed_fd = -1;
+    return fd;
+};
+
+/*!
+** Returns whether this thread's call has cookies in its voiceglue
+** cookie jar.  Requests that must carry them cannot bypass voiceglue.
+** @return 1 if the call has cookies, 0 otherwise
+*/
+int voiceglue_ipc_call_has_cookies()
+{
+    if (voiceglue_my_channel == NULL)
+    {
+	return 0;
+    };
+    return __sync_fetch_and_add (&voiceglue_my_channel->has_cookies, 0);
+};
+
+/*!
+** Records the line status for this thread, as when we hang up ourselves
+** @param status 1 if the line is connected, 0 if it has hung up
+*/
+void voiceglue_ipc_set_line_status (int status)
+{
+    if (voiceglue_my_channel != NULL)
+    {
+	__sync_lock_test_and_set (&voiceglue_my_channel->line_status, status);
+    };
+};
+
 /*!
 ** Converts an ASCII string into SATC-quoted equivalent
 **
@@ -262,11 +559,6 @@ std::string voiceglue_escape_SATC_string (const char *input_bytes)
     return output_bytes.str();
 };
 
-static int voiceglue_logfd;
-static FILE *voiceglue_logfh;
-static int voiceglue_loglevel_value = -1;
-static pthread_mutex_t voiceglue_log_mutex;
-
 /*!
 ** Converts an ASCII string into SATC-quoted equivalent
 **
@@ -289,8 +581,253 @@ std::string voiceglue_escape_SATC_string (std::ostringstream &input_bytes)
     return voiceglue_escape_SATC_string (input_bytes.str().c_str());
 };
 
+/*  Asynchronous logging:
+ *
+ *  Each thread formats its log lines straight into its own
+ *  single-producer ring buffer, with no locks taken.  A background
+ *  writer thread drains all of the rings to the log fd with writev().
+ *  Only whole lines are ever published to a ring, so lines from
+ *  different threads never interleave.  When a ring is full the
+ *  line is dropped and counted (the default), or the logging thread
+ *  waits for the writer, depending on the overflow policy.
+ */
+
+/*  Must be a power of two  */
+#define VOICEGLUE_LOG_RING_SIZE 65536
+/*  Longer messages are truncated  */
+#define VOICEGLUE_LOG_MAX_LINE 16384
+#define VOICEGLUE_LOG_MAX_IOV 64
+/*  How long the writer sleeps when idle, in milliseconds  */
+#define VOICEGLUE_LOG_IDLE_MS 10
+
+struct voiceglue_log_ring
+{
+    /*  Total bytes ever consumed, only written by the writer thread  */
+    volatile unsigned long head;
+    /*  Total bytes ever published, only written by the owning thread  */
+    volatile unsigned long tail;
+    /*  1 while owned by a live thread  */
+    volatile int in_use;
+    /*  Next ring in the registry, never unlinked  */
+    voiceglue_log_ring *next;
+    char buf[VOICEGLUE_LOG_RING_SIZE];
+};
+
+static int voiceglue_logfd = -1;
+static int voiceglue_loglevel_value = -1;
+static int voiceglue_log_overflow_policy = VOICEGLUE_LOG_OVERFLOW_DROP;
+static pthread_mutex_t voiceglue_log_mutex;
+static pthread_cond_t voiceglue_log_cond;
+static pthread_t voiceglue_log_writer_thread;
+static pthread_key_t voiceglue_log_ring_key;
+static volatile int voiceglue_log_writer_running = 0;
+static volatile int voiceglue_log_stopping = 0;
+static volatile unsigned long voiceglue_log_dropped = 0;
+static voiceglue_log_ring * volatile voiceglue_log_rings = NULL;
+static __thread voiceglue_log_ring *voiceglue_my_log_ring = NULL;
+
+/*!
+** Releases a thread's log ring when the thread exits.  The writer
+** still drains what is left in it before it is reused.
+*/
+static void voiceglue_log_ring_release (void *ring)
+{
+    __sync_lock_release (&((voiceglue_log_ring *) ring)->in_use);
+}
+
+/*!
+** Gets the calling thread's log ring, claiming a drained free ring
+** or registering a new one on first use
+** @return the ring, or NULL if none could be allocated
+*/
+static voiceglue_log_ring *voiceglue_get_log_ring()
+{
+    voiceglue_log_ring *ring;
+
+    if (voiceglue_my_log_ring != NULL)
+    {
+	return voiceglue_my_log_ring;
+    };
+
+    for (ring = voiceglue_log_rings; ring != NULL; ring = ring->next)
+    {
+	if ((ring->in_use == 0) && (ring->head == ring->tail) &&
+	    __sync_bool_compare_and_swap (&ring->in_use, 0, 1))
+	{
+	    break;
+	};
+    };
+
+    if (ring == NULL)
+    {
+	ring = (voiceglue_log_ring *) malloc (sizeof (voiceglue_log_ring));
+	if (ring == NULL)
+	{
+	    return NULL;
+	};
+	ring->head = 0;
+	ring->tail = 0;
+	ring->in_use = 1;
+	do
+	{
+	    ring->next = voiceglue_log_rings;
+	}
+	while (! __sync_bool_compare_and_swap (&voiceglue_log_rings,
+					       ring->next, ring));
+    };
+
+    pthread_setspecific (voiceglue_log_ring_key, ring);
+    voiceglue_my_log_ring = ring;
+    return ring;
+}
+
+/*!
+** Writes all of iov to the log fd, retrying partial writes
+** @return 0 on success, -1 on failure
+*/
+static int voiceglue_log_writev (struct iovec *iov, int iovcnt)
+{
+    ssize_t r;
+
+    while (iovcnt > 0)
+    {
+	r = writev (voiceglue_logfd, iov, iovcnt);
+	if (r == -1)
+	{
+	    if (errno == EINTR)
+	    {
+		continue;
+	    };
+	    return -1;
+	};
+	while ((iovcnt > 0) && ((size_t) r >= iov->iov_len))
+	{
+	    r -= iov->iov_len;
+	    ++iov;
+	    --iovcnt;
+	};
+	if (iovcnt > 0)
+	{
+	    iov->iov_base = (char *) iov->iov_base + r;
+	    iov->iov_len -= r;
+	};
+    };
+    return 0;
+}
+
+/*!
+** Writes everything published so far in all rings to the log fd.
+** Only one thread at a time may drain.
+** @return the number of bytes consumed
+*/
+static unsigned long voiceglue_log_drain()
+{
+    struct iovec iov[VOICEGLUE_LOG_MAX_IOV];
+    voiceglue_log_ring *rings[VOICEGLUE_LOG_MAX_IOV / 2];
+    unsigned long tails[VOICEGLUE_LOG_MAX_IOV / 2];
+    char dropped_msg[64];
+    unsigned long dropped, head, tail, start, total = 0;
+    int iovcnt, nrings, i;
+    voiceglue_log_ring *ring = voiceglue_log_rings;
+
+    dropped = __sync_lock_test_and_set (&voiceglue_log_dropped, 0);
+    if (dropped != 0)
+    {
+	iov[0].iov_len = snprintf (dropped_msg, sizeof (dropped_msg),
+				   "%cvoiceglue dropped %lu log messages\n",
+				   (char) LOG_WARNING, dropped);
+	iov[0].iov_base = dropped_msg;
+	voiceglue_log_writev (iov, 1);
+    };
+
+    while (ring != NULL)
+    {
+	iovcnt = 0;
+	nrings = 0;
+	for (; (ring != NULL) && (nrings < VOICEGLUE_LOG_MAX_IOV / 2);
+	     ring = ring->next)
+	{
+	    head = ring->head;
+	    tail = ring->tail;
+	    __sync_synchronize();
+	    if (head == tail)
+	    {
+		continue;
+	    };
+	    start = head & (VOICEGLUE_LOG_RING_SIZE - 1);
+	    if (start + (tail - head) <= VOICEGLUE_LOG_RING_SIZE)
+	    {
+		iov[iovcnt].iov_base = ring->buf + start;
+		iov[iovcnt++].iov_len = tail - head;
+	    }
+	    else
+	    {
+		iov[iovcnt].iov_base = ring->buf + start;
+		iov[iovcnt++].iov_len = VOICEGLUE_LOG_RING_SIZE - start;
+		iov[iovcnt].iov_base = ring->buf;
+		iov[iovcnt++].iov_len =
+		    (tail - head) - (VOICEGLUE_LOG_RING_SIZE - start);
+	    };
+	    rings[nrings] = ring;
+	    tails[nrings++] = tail;
+	    total += tail - head;
+	};
+	if (iovcnt == 0)
+	{
+	    break;
+	};
+	voiceglue_log_writev (iov, iovcnt);
+	__sync_synchronize();
+	for (i = 0; i < nrings; ++i)
+	{
+	    rings[i]->head = tails[i];
+	};
+    };
+    return total;
+}
+
+/*!
+** The background log writer thread
+*/
+static void *voiceglue_log_writer (void *)
+{
+    struct timeval now;
+    struct timespec until;
+    int stopping;
+
+    for (;;)
+    {
+	stopping = voiceglue_log_stopping;
+	if ((voiceglue_log_drain() != 0) || (voiceglue_log_dropped != 0))
+	{
+	    continue;
+	};
+	if (stopping)
+	{
+	    break;
+	};
+	gettimeofday (&now, NULL);
+	until.tv_sec = now.tv_sec;
+	until.tv_nsec = (now.tv_usec + VOICEGLUE_LOG_IDLE_MS * 1000) * 1000;
+	if (until.tv_nsec >= 1000000000)
+	{
+	    until.tv_sec += 1;
+	    until.tv_nsec -= 1000000000;
+	};
+	pthread_mutex_lock (&voiceglue_log_mutex);
+	if (! voiceglue_log_stopping)
+	{
+	    pthread_cond_timedwait (&voiceglue_log_cond, &voiceglue_log_mutex,
+				    &until);
+	};
+	pthread_mutex_unlock (&voiceglue_log_mutex);
+    };
+    return NULL;
+}
+
 /*!
 ** Open the voiceglue log channel, and initializes mutex for thread ipc.
+** Starts the background log writer thread.
 ** @param logfd The file descriptor representing the log channel
 ## @param loglevel The initial log level
 ** @return 0 on success
@@ -299,16 +836,15 @@ int voiceglue_log_init (int logfd, int loglevel)
 {
     voiceglue_logfd = logfd;
     voiceglue_loglevel_value = loglevel;
-    voiceglue_logfh = fdopen(logfd, "w");
-    if (! voiceglue_logfh)
+    if (pthread_mutex_init (&voiceglue_log_mutex, NULL))
     {
-	fprintf(stderr, "ERROR: Cannot open FILE* for fd=%d: %s errno=%d\n",
-		logfd, strerror(errno), errno);
+	fprintf(stderr, "ERROR: Cannot init log mutex: %s errno=%d\n",
+		strerror(errno), errno);
 	return -1;
     };
-    if (pthread_mutex_init (&voiceglue_log_mutex, NULL))
+    if (pthread_cond_init (&voiceglue_log_cond, NULL))
     {
-	fprintf(stderr, "ERROR: Cannot init log mutex: %s errno=%d\n",
+	fprintf(stderr, "ERROR: Cannot init log condition: %s errno=%d\n",
 		strerror(errno), errno);
 	return -1;
     };
@@ -318,10 +854,85 @@ int voiceglue_log_init (int logfd, int loglevel)
 		strerror(errno), errno);
 	return -1;
     };
+    if (pthread_key_create (&voiceglue_log_ring_key,
+			    voiceglue_log_ring_release))
+    {
+	fprintf(stderr, "ERROR: Cannot create log key: %s errno=%d\n",
+		strerror(errno), errno);
+	return -1;
+    };
+    voiceglue_log_stopping = 0;
+    if (pthread_create (&voiceglue_log_writer_thread, NULL,
+			voiceglue_log_writer, NULL))
+    {
+	fprintf(stderr, "ERROR: Cannot start log writer: %s errno=%d\n",
+		strerror(errno), errno);
+	return -1;
+    };
+    voiceglue_log_writer_running = 1;
     voiceglue_log ((char) 5, "OpenVXI started feed to dynlog\n");
     return 0;
 };
 
+/*!
+** Stops the background log writer thread, after writing out
+** everything logged so far.  Later messages are written synchronously.
+*/
+void voiceglue_log_shutdown()
+{
+    if (! voiceglue_log_writer_running)
+    {
+	return;
+    };
+    pthread_mutex_lock (&voiceglue_log_mutex);
+    voiceglue_log_stopping = 1;
+    pthread_cond_signal (&voiceglue_log_cond);
+    pthread_mutex_unlock (&voiceglue_log_mutex);
+    pthread_join (voiceglue_log_writer_thread, NULL);
+    voiceglue_log_writer_running = 0;
+    pthread_mutex_lock (&voiceglue_log_mutex);
+    voiceglue_log_drain();
+    pthread_mutex_unlock (&voiceglue_log_mutex);
+};
+
+/*!
+** Sets what happens when a thread's log buffer is full
+** @param policy VOICEGLUE_LOG_OVERFLOW_DROP to drop and count the message,
+**               VOICEGLUE_LOG_OVERFLOW_BLOCK to wait for the writer
+*/
+void voiceglue_log_set_overflow_policy (int policy)
+{
+    voiceglue_log_overflow_policy = policy;
+};
+
+/*!
+** Returns the number of log messages dropped but not yet reported
+*/
+unsigned long voiceglue_log_dropped_count()
+{
+    return voiceglue_log_dropped;
+};
+
+/*!
+** Copies bytes into a ring at a position that may wrap
+*/
+static void voiceglue_log_ring_copy (voiceglue_log_ring *ring,
+				     unsigned long pos,
+				     const char *bytes, size_t len)
+{
+    size_t start = pos & (VOICEGLUE_LOG_RING_SIZE - 1);
+    size_t first = VOICEGLUE_LOG_RING_SIZE - start;
+    if (first >= len)
+    {
+	memcpy (ring->buf + start, bytes, len);
+    }
+    else
+    {
+	memcpy (ring->buf + start, bytes, first);
+	memcpy (ring->buf, bytes + first, len - first);
+    };
+}
+
 /*!
 ** Writes a message to the voiceglue log channel
 ** @param level The level of the message
@@ -330,52 +941,90 @@ int voiceglue_log_init (int logfd, int loglevel)
 */
 int voiceglue_log (char level, const char *message)
 {
-    int r, i, len;
+    char prefix[32];
+    int prefix_len = 0;
+    size_t len, needed, i;
+    unsigned long tail;
+    voiceglue_log_ring *ring;
+    struct iovec iov[4];
+
     len = strlen (message);
-    char message_cleaned [len+2];
-    std::ostringstream prefix;
-    int prefix_len;
-    VXIthreadID thread_id = VXItrdThreadGetID();
-    strcpy (message_cleaned, message);
-    if (message_cleaned[len-1] != '\n')
+    if ((len > 0) && (message[len-1] == '\n'))
+    {
+	--len;
+    };
+    if (len > VOICEGLUE_LOG_MAX_LINE)
     {
-	message_cleaned[len] = '\n';
-	message_cleaned[len+1] = '\0';
-	++len;
+	len = VOICEGLUE_LOG_MAX_LINE;
     };
-    for (i = 0; i < len-1; ++i)
+    if (voiceglue_my_callid != -1)
     {
-	if (message_cleaned[i] == '\n')
+	prefix_len = snprintf (prefix, sizeof (prefix), "callid=[%d] ",
+			       voiceglue_my_callid);
+    };
+    needed = 1 + prefix_len + len + 1;
+
+    ring = voiceglue_log_writer_running ? voiceglue_get_log_ring() : NULL;
+    if (ring == NULL)
+    {
+	//  No writer thread, so write it out here
+	std::string cleaned (message, len);
+	for (i = 0; i < len; ++i)
 	{
-	    message_cleaned[i] = ' ';
+	    if (cleaned[i] == '\n')
+	    {
+		cleaned[i] = ' ';
+	    };
 	};
+	iov[0].iov_base = &level;
+	iov[0].iov_len = 1;
+	iov[1].iov_base = prefix;
+	iov[1].iov_len = prefix_len;
+	iov[2].iov_base = (void *) cleaned.data();
+	iov[2].iov_len = len;
+	iov[3].iov_base = (void *) "\n";
+	iov[3].iov_len = 1;
+	pthread_mutex_lock (&voiceglue_log_mutex);
+	i = voiceglue_log_writev (iov, 4);
+	pthread_mutex_unlock (&voiceglue_log_mutex);
+	return (i == 0) ? 0 : 1;
     };
-    //  See if the element has a defined callid
-    pthread_mutex_lock (&voiceglue_threadmap_mutex);
-    std::map<VXIthreadID, int>::iterator iter =
-	voiceglue_threadid_to_callid.find (thread_id);
-    if (iter != voiceglue_threadid_to_callid.end())
+
+    //  Wait for (or give up on) enough space in our ring
+    tail = ring->tail;
+    while (VOICEGLUE_LOG_RING_SIZE - (tail - ring->head) < needed)
     {
-	//  Has a callid
-	int callid = voiceglue_threadid_to_callid[thread_id];
-	prefix << "callid=[" << callid << "] ";
+	if ((voiceglue_log_overflow_policy != VOICEGLUE_LOG_OVERFLOW_BLOCK) ||
+	    voiceglue_log_stopping)
+	{
+	    __sync_fetch_and_add (&voiceglue_log_dropped, 1);
+	    return 1;
+	};
+	pthread_cond_signal (&voiceglue_log_cond);
+	sched_yield();
     };
-    pthread_mutex_unlock (&voiceglue_threadmap_mutex);
-    prefix_len = prefix.str().length();
-    pthread_mutex_lock (&voiceglue_log_mutex);
-    fwrite (&level, 1, 1, voiceglue_logfh);
-    if (prefix_len != 0)
+    __sync_synchronize();
+
+    //  Format the line in place
+    voiceglue_log_ring_copy (ring, tail, &level, 1);
+    voiceglue_log_ring_copy (ring, tail + 1, prefix, prefix_len);
+    voiceglue_log_ring_copy (ring, tail + 1 + prefix_len, message, len);
+    for (i = tail + 1 + prefix_len; i < tail + 1 + prefix_len + len; ++i)
     {
-	fwrite (prefix.str().c_str(), prefix_len, 1, voiceglue_logfh);
+	if (ring->buf[i & (VOICEGLUE_LOG_RING_SIZE - 1)] == '\n')
+	{
+	    ring->buf[i & (VOICEGLUE_LOG_RING_SIZE - 1)] = ' ';
+	};
     };
-    r = fwrite (message_cleaned, len, 1, voiceglue_logfh);
-    if (r == 0)
+    voiceglue_log_ring_copy (ring, tail + needed - 1, "\n", 1);
+
+    //  Publish it
+    __sync_synchronize();
+    ring->tail = tail + needed;
+    if (tail + needed - ring->head > VOICEGLUE_LOG_RING_SIZE / 2)
     {
-	pthread_mutex_unlock (&voiceglue_log_mutex);
-	return 1;
+	pthread_cond_signal (&voiceglue_log_cond);
     };
-    fflush (voiceglue_logfh);
-    pthread_mutex_unlock (&voiceglue_log_mutex);
     return 0;
 };
 
@@ -29,16 +29,28 @@
 
 #include <VXItrd.h>
 
+/*  Log overflow policies for voiceglue_log_set_overflow_policy()  */
+#define VOICEGLUE_LOG_OVERFLOW_DROP  0
+#define VOICEGLUE_LOG_OVERFLOW_BLOCK 1
+
 int voiceglue_registeripcfd (int fd, int callid);
 int voiceglue_unregisteripcfd();
 int voiceglue_sendipcmsg (const char *msg);
+int voiceglue_sendipcmsg (const char *msg, size_t len);
 int voiceglue_sendipcmsg (std::string &msg);
 int voiceglue_sendipcmsg (std::ostringstream &msg);
 std::string voiceglue_getipcmsg();
+int voiceglue_ipc_line_status();
+void voiceglue_ipc_set_line_status (int status);
+int voiceglue_ipc_call_has_cookies();
+int voiceglue_ipc_take_fd();
 std::string voiceglue_escape_SATC_string (const char *input_bytes);
 std::string voiceglue_escape_SATC_string (std::string &input_bytes);
 std::string voiceglue_escape_SATC_string (std::ostringstream &input_bytes);
 int voiceglue_log_init (int logfd, int loglevel);
+void voiceglue_log_shutdown();
+void voiceglue_log_set_overflow_policy (int policy);
+unsigned long voiceglue_log_dropped_count();
 int voiceglue_log (char level, const char *message);
 int voiceglue_log (char level, std::string &message);
 int voiceglue_log (char level, std::ostringstream &message);
@@ -0,0 +1,373 @@
+//  Copyright 2006,2007 Ampersand Inc., Doug Campbell
+//
+//  This file is part of libvglue.
+//
+//  libvglue is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libvglue is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with libvglue; if not, see <http://www.gnu.org/licenses/>.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <syslog.h>
+#include <pthread.h>
+#include <string>
+#include <vglue_ipc.h>
+#include <vglue_msg.h>
+#include <vglue_tostring.h>
+
+/*  voiceglue IPC message building routines  */
+
+#define VOICEGLUE_MSG_INITIAL_SIZE 4096
+
+#define VOICEGLUE_MSG_RAW 0
+#define VOICEGLUE_MSG_QUOTED 1
+#define VOICEGLUE_MSG_URLENCODED 2
+
+voiceglue_msg::voiceglue_msg()
+    : buf (NULL), len (0), size (0),
+      encoding (VOICEGLUE_MSG_RAW), properties_added (0)
+{
+}
+
+voiceglue_msg::~voiceglue_msg()
+{
+    free (buf);
+}
+
+/*!
+**  Makes room for more bytes, growing the buffer geometrically
+*/
+void voiceglue_msg::reserve (size_t more)
+{
+    if (len + more <= size)
+    {
+	return;
+    };
+    size_t new_size = (size == 0) ? VOICEGLUE_MSG_INITIAL_SIZE : size;
+    while (new_size < len + more)
+    {
+	new_size *= 2;
+    };
+    char *new_buf = (char *) realloc (buf, new_size);
+    if (new_buf == NULL)
+    {
+	//  Out of memory, so the message is lost
+	voiceglue_log ((char) LOG_ERR, "out of memory building IPC message");
+	abort();
+    };
+    buf = new_buf;
+    size = new_size;
+}
+
+void voiceglue_msg::put_raw (const char *bytes, size_t n)
+{
+    reserve (n);
+    memcpy (buf + len, bytes, n);
+    len += n;
+}
+
+/*!
+**  Appends one byte in the current encoding
+*/
+void voiceglue_msg::put (char c)
+{
+    static const char *hex_digits = "0123456789abcdef";
+    static const char *url_digits = "0123456789ABCDEF";
+    unsigned char uc = (unsigned char) c;
+
+    reserve (4);
+    if (encoding == VOICEGLUE_MSG_QUOTED)
+    {
+	//  As voiceglue_escape_SATC_string()
+	if (c == '\\')
+	{
+	    buf[len++] = '\\';
+	    buf[len++] = '\\';
+	}
+	else if (c == '\n')
+	{
+	    buf[len++] = '\\';
+	    buf[len++] = 'n';
+	}
+	else if (c == '\'')
+	{
+	    buf[len++] = '\\';
+	    buf[len++] = '\'';
+	}
+	else if (c == '\"')
+	{
+	    buf[len++] = '\\';
+	    buf[len++] = '\"';
+	}
+	else if ((uc < ' ') || (uc > '~'))
+	{
+	    buf[len++] = '\\';
+	    buf[len++] = 'x';
+	    buf[len++] = hex_digits[uc >> 4];
+	    buf[len++] = hex_digits[uc & 0x0F];
+	}
+	else
+	{
+	    buf[len++] = c;
+	};
+    }
+    else if (encoding == VOICEGLUE_MSG_URLENCODED)
+    {
+	//  As UrlEncode()
+	if (c == ' ')
+	{
+	    buf[len++] = '+';
+	}
+	else if (isalnum (uc) || ((c != '\0') && strchr ("-_.!~*'()", c)))
+	{
+	    buf[len++] = c;
+	}
+	else
+	{
+	    buf[len++] = '%';
+	    buf[len++] = url_digits[uc >> 4];
+	    buf[len++] = url_digits[uc & 0x0F];
+	};
+    }
+    else
+    {
+	buf[len++] = c;
+    };
+}
+
+voiceglue_msg &voiceglue_msg::begin (const char *command)
+{
+    len = 0;
+    encoding = VOICEGLUE_MSG_RAW;
+    properties_added = 0;
+    put_raw (command, strlen (command));
+    return *this;
+}
+
+voiceglue_msg &voiceglue_msg::add (const char *bytes, size_t n)
+{
+    if (encoding == VOICEGLUE_MSG_RAW)
+    {
+	put_raw (bytes, n);
+    }
+    else
+    {
+	for (size_t i = 0; i < n; ++i)
+	{
+	    put (bytes[i]);
+	};
+    };
+    return *this;
+}
+
+voiceglue_msg &voiceglue_msg::add (const char *bytes)
+{
+    if (bytes == NULL)
+    {
+	return *this;
+    };
+    return add (bytes, strlen (bytes));
+}
+
+/*!
+**  Appends a wide string, converting to UTF-8 on the fly
+*/
+voiceglue_msg &voiceglue_msg::add (const VXIchar *wide)
+{
+    char utf8[4];
+    unsigned long cp;
+
+    if (wide == NULL)
+    {
+	return *this;
+    };
+    for (; *wide != 0; ++wide)
+    {
+	cp = (unsigned long) *wide;
+	if (cp < 0x80)
+	{
+	    put ((char) cp);
+	    continue;
+	};
+	if (cp < 0x800)
+	{
+	    utf8[0] = (char) (0xC0 | (cp >> 6));
+	    utf8[1] = (char) (0x80 | (cp & 0x3F));
+	    add (utf8, 2);
+	}
+	else if (cp < 0x10000)
+	{
+	    utf8[0] = (char) (0xE0 | (cp >> 12));
+	    utf8[1] = (char) (0x80 | ((cp >> 6) & 0x3F));
+	    utf8[2] = (char) (0x80 | (cp & 0x3F));
+	    add (utf8, 3);
+	}
+	else
+	{
+	    utf8[0] = (char) (0xF0 | ((cp >> 18) & 0x07));
+	    utf8[1] = (char) (0x80 | ((cp >> 12) & 0x3F));
+	    utf8[2] = (char) (0x80 | ((cp >> 6) & 0x3F));
+	    utf8[3] = (char) (0x80 | (cp & 0x3F));
+	    add (utf8, 4);
+	};
+    };
+    return *this;
+}
+
+voiceglue_msg &voiceglue_msg::add (long value)
+{
+    char digits[24];
+    int n = snprintf (digits, sizeof (digits), "%ld", value);
+    return add (digits, n);
+}
+
+/*!
+**  Appends a value in the same text form as VXIValue_to_Std_String(),
+**  formatting scalars directly into the buffer
+*/
+voiceglue_msg &voiceglue_msg::add (const VXIValue *value)
+{
+    char digits[32];
+    int n;
+
+    if (value == NULL)
+    {
+	return *this;
+    };
+    switch (VXIValueGetType (value))
+    {
+    case VALUE_INTEGER:
+	return add ((long) VXIIntegerValue ((const VXIInteger *) value));
+    case VALUE_LONG:
+	return add ((long) VXILongValue ((const VXILong *) value));
+    case VALUE_ULONG:
+	n = snprintf (digits, sizeof (digits), "%lu",
+		      (unsigned long) VXIULongValue ((const VXIULong *) value));
+	return add (digits, n);
+    case VALUE_FLOAT:
+	n = snprintf (digits, sizeof (digits), "%g",
+		      (double) VXIFloatValue ((const VXIFloat *) value));
+	return add (digits, n);
+    case VALUE_DOUBLE:
+	n = snprintf (digits, sizeof (digits), "%g",
+		      VXIDoubleValue ((const VXIDouble *) value));
+	return add (digits, n);
+    case VALUE_BOOLEAN:
+	return add ((VXIBooleanValue ((const VXIBoolean *) value) == TRUE) ?
+		    "true" : "false");
+    case VALUE_STRING:
+	return add (VXIStringCStr ((const VXIString *) value));
+    default:
+    {
+	//  Rare compound values take the slow path
+	std::string text = VXIValue_to_Std_String (value);
+	return add (text.data(), text.length());
+    }
+    };
+}
+
+voiceglue_msg &voiceglue_msg::space()
+{
+    put_raw (" ", 1);
+    return *this;
+}
+
+voiceglue_msg &voiceglue_msg::open_quote()
+{
+    put_raw ("\"", 1);
+    encoding = VOICEGLUE_MSG_QUOTED;
+    properties_added = 0;
+    return *this;
+}
+
+voiceglue_msg &voiceglue_msg::close_quote()
+{
+    encoding = VOICEGLUE_MSG_RAW;
+    put_raw ("\"", 1);
+    return *this;
+}
+
+voiceglue_msg &voiceglue_msg::open_urlencode()
+{
+    encoding = VOICEGLUE_MSG_URLENCODED;
+    return *this;
+}
+
+voiceglue_msg &voiceglue_msg::close_urlencode()
+{
+    encoding = VOICEGLUE_MSG_RAW;
+    return *this;
+}
+
+voiceglue_msg &voiceglue_msg::add_quoted (const char *bytes)
+{
+    return space().open_quote().add (bytes).close_quote();
+}
+
+voiceglue_msg &voiceglue_msg::add_quoted (const VXIchar *wide)
+{
+    return space().open_quote().add (wide).close_quote();
+}
+
+voiceglue_msg &voiceglue_msg::add_property (const char *name,
+					    const VXIMap *props,
+					    const VXIchar *key)
+{
+    if (properties_added++)
+    {
+	add (" ", 1);
+    };
+    add (name);
+    add ("=", 1);
+    return add (VXIMapGetProperty (props, key));
+}
+
+/*!
+**  Terminates the message with a newline and sends it
+**  @return 0 on success, -1 on failure
+*/
+int voiceglue_msg::send()
+{
+    encoding = VOICEGLUE_MSG_RAW;
+    put_raw ("\n", 1);
+    return voiceglue_sendipcmsg (buf, len);
+}
+
+static pthread_key_t voiceglue_msg_key;
+static pthread_once_t voiceglue_msg_key_once = PTHREAD_ONCE_INIT;
+static __thread voiceglue_msg *voiceglue_my_msg = NULL;
+
+static void voiceglue_msg_destroy (void *builder)
+{
+    delete (voiceglue_msg *) builder;
+}
+
+static void voiceglue_msg_make_key()
+{
+    pthread_key_create (&voiceglue_msg_key, voiceglue_msg_destroy);
+}
+
+/*!
+**  Returns the calling thread's message builder
+*/
+voiceglue_msg &voiceglue_msg_builder()
+{
+    if (voiceglue_my_msg == NULL)
+    {
+	pthread_once (&voiceglue_msg_key_once, voiceglue_msg_make_key);
+	voiceglue_my_msg = new voiceglue_msg;
+	pthread_setspecific (voiceglue_msg_key, voiceglue_my_msg);
+    };
+    return *voiceglue_my_msg;
+}
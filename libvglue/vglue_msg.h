@@ -0,0 +1,103 @@
+//                 -*-C++-*-
+
+//  Copyright 2006,2007 Ampersand Inc., Doug Campbell
+//
+//  This file is part of libvglue.
+//
+//  libvglue is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libvglue is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with libvglue; if not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VGLUE_MSG_H
+#define VGLUE_MSG_H
+
+#ifndef __cplusplus
+#error "This is a C++ only header file"
+#endif
+
+#include <stddef.h>
+#include <VXIvalue.h>
+
+/*!
+**  Builds an outgoing voiceglue IPC message in place.
+**
+**  Each thread has one builder, from voiceglue_msg_builder(), whose
+**  buffer is kept between messages, so once it has grown to the
+**  largest message sent no allocation is done at all.  Text is
+**  appended in the current encoding:  raw, SATC-quoted (between
+**  open_quote() and close_quote()) or URL-encoded (between
+**  open_urlencode() and close_urlencode()).  Only one message may be
+**  built at a time on a thread.
+*/
+class voiceglue_msg
+{
+  public:
+    voiceglue_msg();
+    ~voiceglue_msg();
+
+    //  Starts a new message with command word command
+    voiceglue_msg &begin (const char *command);
+
+    //  Appends bytes in the current encoding
+    voiceglue_msg &add (const char *bytes, size_t len);
+    voiceglue_msg &add (const char *bytes);
+    //  Appends the UTF-8 form of a wide string in the current encoding
+    voiceglue_msg &add (const VXIchar *wide);
+    //  Appends the decimal form of an integer in the current encoding
+    voiceglue_msg &add (long value);
+    //  Appends the text form of a value, as VXIValue_to_Std_String()
+    voiceglue_msg &add (const VXIValue *value);
+
+    //  Appends an unencoded separating space
+    voiceglue_msg &space();
+    //  Starts and ends an SATC-quoted string
+    voiceglue_msg &open_quote();
+    voiceglue_msg &close_quote();
+    //  Starts and ends URL-encoding
+    voiceglue_msg &open_urlencode();
+    voiceglue_msg &close_urlencode();
+
+    //  Appends a space and a complete SATC-quoted string
+    voiceglue_msg &add_quoted (const char *bytes);
+    voiceglue_msg &add_quoted (const VXIchar *wide);
+
+    //  Appends name=value for property key in props, space-separated
+    //  from any previous property, value "" if props has no such key
+    voiceglue_msg &add_property (const char *name, const VXIMap *props,
+				 const VXIchar *key);
+
+    //  Terminates the message and sends it on this thread's IPC fd
+    int send();
+
+    //  The message built so far, not yet terminated
+    const char *data() const { return buf; }
+    size_t length() const { return len; }
+
+  private:
+    void reserve (size_t more);
+    void put (char c);
+    void put_raw (const char *bytes, size_t len);
+
+    char *buf;
+    size_t len;
+    size_t size;
+    int encoding;
+    int properties_added;
+
+    //  Not copyable
+    voiceglue_msg (const voiceglue_msg &);
+    voiceglue_msg &operator= (const voiceglue_msg &);
+};
+
+voiceglue_msg &voiceglue_msg_builder();
+
+#endif /* include guard VGLUE_MSG_H */
@@ -21,7 +21,9 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <cerrno>
+#include <cstdio>
 #include <vglue_ipc.h>
+#include <vglue_msg.h>
 #include <vglue_tostring.h>
 #include <vglue_prompt.h>
 #include <vglue_tostring.h>
@@ -32,6 +34,117 @@
 
 /*  voiceglue prompt (prompt support) routines  */
 
+/*!
+**  Computes a hash identifying in-memory audio by its content
+**  @param content The audio bytes
+**  @param size The number of bytes
+**  @param hash Gets filled with the hash as 16 hex digits
+*/
+static void voiceglue_pcm_hash (const VXIbyte *content, VXIulong size,
+				char hash[17])
+{
+    //  64-bit FNV-1a, with the size folded in
+    unsigned long long h = 0xcbf29ce484222325ULL;
+    for (VXIulong i = 0; i < size; ++i)
+    {
+	h = (h ^ content[i]) * 0x100000001b3ULL;
+    };
+    h = (h ^ (unsigned long long) size) * 0x100000001b3ULL;
+    snprintf (hash, 17, "%016llx", h);
+};
+
+/*!
+**  Writes in-memory audio to the file voiceglue will queue it from.
+**  The path is named by the content hash, so if it already holds
+**  this audio (a recording played back again) nothing is written.
+**  Otherwise the audio goes to a temporary file that is renamed into
+**  place, so the path never holds a partial write.
+**  @param path The path returned by GetPCMPath
+**  @param content The audio bytes
+**  @param size The number of bytes
+**  @return 0 on success, -1 on failure (already logged)
+*/
+static int voiceglue_pcm_write (const std::string &path,
+				const VXIbyte *content, VXIulong size)
+{
+    struct stat stat_buf;
+    if ((stat (path.c_str(), &stat_buf) == 0) &&
+	((VXIulong) stat_buf.st_size == size))
+    {
+	if (voiceglue_loglevel() >= LOG_DEBUG)
+	{
+	    std::ostringstream logstring;
+	    logstring << "Reusing PCM stream file \"" << path << "\"";
+	    voiceglue_log ((char) LOG_DEBUG, logstring);
+	};
+	return 0;
+    };
+
+    std::string tmp_path = path + ".tmp";
+    unlink (tmp_path.c_str());
+    int pcm_file_fd = open (tmp_path.c_str(),
+			    (O_WRONLY | O_CREAT | O_TRUNC), 0664);
+    if (pcm_file_fd == -1)
+    {
+	if (voiceglue_loglevel() >= LOG_ERR)
+	{
+	    std::ostringstream errmsg;
+	    errmsg << "PCMPath returned unopenable filepath \""
+		   << tmp_path
+		   << "\", open errno="
+		   << errno;
+	    voiceglue_log ((char) LOG_ERR, errmsg);
+	};
+	return -1;
+    };
+    VXIulong bytes_written = 0;
+    ssize_t write_result;
+    while (bytes_written < size)
+    {
+	write_result = write (pcm_file_fd,
+			      (const char *) content + bytes_written,
+			      size - bytes_written);
+	if (write_result <= 0)
+	{
+	    if ((write_result == -1) && (errno == EINTR))
+	    {
+		continue;
+	    };
+	    if (voiceglue_loglevel() >= LOG_ERR)
+	    {
+		std::ostringstream errmsg;
+		errmsg << "PCM stream file \""
+		       << tmp_path
+		       << "\", cannot be written, write return code="
+		       << write_result
+		       << " errno="
+		       << errno;
+		voiceglue_log ((char) LOG_ERR, errmsg);
+	    };
+	    close (pcm_file_fd);
+	    unlink (tmp_path.c_str());
+	    return -1;
+	};
+	bytes_written += write_result;
+    };
+    close (pcm_file_fd);
+    if (rename (tmp_path.c_str(), path.c_str()) != 0)
+    {
+	if (voiceglue_loglevel() >= LOG_ERR)
+	{
+	    std::ostringstream errmsg;
+	    errmsg << "PCM stream file \""
+		   << tmp_path
+		   << "\", cannot be renamed, errno="
+		   << errno;
+	    voiceglue_log ((char) LOG_ERR, errmsg);
+	};
+	unlink (tmp_path.c_str());
+	return -1;
+    };
+    return 0;
+};
+
 /*!
 **  Queues a prompt
 **  @param prompt_spec An SSML spec
@@ -52,14 +165,13 @@ VXIpromptResult voiceglue_prompt (const VXIchar *prompt_spec,
   };
 
   //  Get the bargein param
-  std::string bargein_param_utf8 =
-      VXIchar_to_Std_String
-      (VXIStringCStr
-       (((const VXIString *) VXIMapGetProperty
-	 (((const VXIMap *) properties), L"bargein"))));
-  if (bargein_param_utf8.length() == 0)
+  const VXIchar *bargein_param =
+      VXIStringCStr
+      (((const VXIString *) VXIMapGetProperty
+	(((const VXIMap *) properties), L"bargein")));
+  if ((bargein_param == NULL) || (*bargein_param == 0))
   {
-      bargein_param_utf8 = "true";
+      bargein_param = L"true";
   };
 
   //  Determine if this is an in-memory audio sample
@@ -100,7 +212,6 @@ VXIpromptResult voiceglue_prompt (const VXIchar *prompt_spec,
 	  };
 	  return VXIprompt_RESULT_INVALID_ARGUMENT;
       };
-      std::string pcmdata_name = VXIchar_to_Std_String (pcmdata_map_key);
       VXIvalueType contenttype = VXIValueGetType (pcmdata_map_value);
       if (contenttype != VALUE_CONTENT)
       {
@@ -127,7 +238,7 @@ VXIpromptResult voiceglue_prompt (const VXIchar *prompt_spec,
       {
 	  std::ostringstream logstring;
 	  logstring << "Found in-memory audio prompt named "
-		    << pcmdata_name
+		    << VXIchar_to_Std_String (pcmdata_map_key)
 		    << " of type "
 		    << VXIchar_to_Std_String (content_type_string)
 		    << " length "
@@ -136,13 +247,14 @@ VXIpromptResult voiceglue_prompt (const VXIchar *prompt_spec,
 	  voiceglue_log ((char) LOG_DEBUG, logstring);
       };
 
-      //  Request a filepath from perl
-      std::ostringstream ipc_msg;
-      ipc_msg << "GetPCMPath "
-	      << pcmdata_name << " "
-	      << VXIchar_to_Std_String (content_type_string)
-	      << "\n";
-      voiceglue_sendipcmsg (ipc_msg);
+      //  Request a filepath from perl, named by content
+      char pcm_hash[17];
+      voiceglue_pcm_hash (content_ptr, content_size, pcm_hash);
+      voiceglue_msg_builder().begin ("GetPCMPath")
+	  .space().add (pcmdata_map_key)
+	  .space().add (content_type_string)
+	  .space().add (pcm_hash)
+	  .send();
       std::string ipcmsg_result = voiceglue_getipcmsg();
       if ((ipcmsg_result.length() < 9) ||
 	  (ipcmsg_result.substr(0,8).compare("PCMPath ") != 0))
@@ -159,78 +271,61 @@ VXIpromptResult voiceglue_prompt (const VXIchar *prompt_spec,
       ipcmsg_result.erase (0, 8);
       //  Rest is the filepath to write
 
-      //  Write the file
-      unlink (ipcmsg_result.c_str());
-      int rec_file_fd = open (ipcmsg_result.c_str(),
-			      (O_WRONLY | O_CREAT), 0664);
-      if (rec_file_fd == -1)
+      //  Write the file, unless it already holds this audio
+      if (voiceglue_pcm_write (ipcmsg_result, content_ptr, content_size) != 0)
       {
-	  if (voiceglue_loglevel() >= LOG_ERR)
-	  {
-	      std::ostringstream errmsg;
-	      errmsg << "PCMPath returned unopenable filepath \""
-		     << ipcmsg_result
-		     << "\", open errno="
-		     << errno;
-	      voiceglue_log ((char) LOG_ERR, errmsg);
-	  };
 	  return VXIprompt_RESULT_INVALID_ARGUMENT;
       };
-      unsigned int bytes_written = 0;
-      ssize_t write_result;
-      while (bytes_written < content_size)
-      {
-	  write_result = write (rec_file_fd,
-				(char *) content_ptr + bytes_written,
-				content_size - bytes_written);
-	  if (write_result <= 0)
-	  {
-	      if (voiceglue_loglevel() >= LOG_ERR)
-	      {
-		  std::ostringstream errmsg;
-		  errmsg << "PCM stream file \""
-			 << ipcmsg_result
-			 << "\", cannot be written, write return code="
-			 << write_result
-			 << " errno="
-			 << errno;
-		  voiceglue_log ((char) LOG_ERR, errmsg);
-	      };
-	      return VXIprompt_RESULT_INVALID_ARGUMENT;
-	  };
-	  bytes_written += write_result;
-      };
-      
+
       //  Queue the written file
-      std::ostringstream ipc_msg2;
-      ipc_msg2 << "PCMQueue "
-	       << ipcmsg_result
-	       << " "
-	       << bargein_param_utf8
-	       << "\n";
-      voiceglue_sendipcmsg (ipc_msg2);
+      voiceglue_msg_builder().begin ("PCMQueue")
+	  .space().add (ipcmsg_result.data(), ipcmsg_result.length())
+	  .space().add (bargein_param)
+	  .send();
   }
   else
   {
       //  This is SSML (could contain TTS and/or <audio>)
-      std::string prompt_spec_utf8 = VXIchar_to_Std_String (prompt_spec);
       if (voiceglue_loglevel() >= LOG_DEBUG)
       {
 	  std::ostringstream logmsg;
-	  logmsg << "VXIpromptQueue (" << prompt_spec_utf8
+	  logmsg << "VXIpromptQueue (" << VXIchar_to_Std_String (prompt_spec)
 		 << ")" << "\n";
 	  voiceglue_log ((char) LOG_DEBUG, logmsg);
       };
-      std::ostringstream ipc_msg;
-      ipc_msg
-	  << "Queue "
-	  << voiceglue_escape_SATC_string (prompt_spec_utf8)
-	  << " "
-	  << bargein_param_utf8
-	  << "\n";
-      voiceglue_sendipcmsg (ipc_msg);
+      voiceglue_msg_builder().begin ("Queue")
+	  .add_quoted (prompt_spec)
+	  .space().add (bargein_param)
+	  .send();
   };
 
   return VXIprompt_RESULT_SUCCESS;
 };
 
+/*!
+**  Asks voiceglue to fetch a prompt's audio and TTS ahead of play.
+**  Nothing is queued and no reply is awaited:  voiceglue hands the
+**  items to its http cache, bounded per call, so that a later
+**  voiceglue_prompt() of the same SSML finds them ready.
+**  @param prompt_spec An SSML spec
+**  @return VXIprompt_RESULT_SUCCESS on success, other code on failure.
+*/
+VXIpromptResult voiceglue_prefetch (const VXIchar *prompt_spec)
+{
+  if (voiceglue_loglevel() >= LOG_DEBUG)
+  {
+      std::ostringstream logmsg;
+      logmsg << "VXIpromptPrefetch (" << VXIchar_to_Std_String (prompt_spec)
+	     << ")";
+      voiceglue_log ((char) LOG_DEBUG, logmsg);
+  };
+
+  if (voiceglue_msg_builder().begin ("Prefetch")
+      .add_quoted (prompt_spec)
+      .send() != 0)
+  {
+      return VXIprompt_RESULT_FAILURE;
+  };
+
+  return VXIprompt_RESULT_SUCCESS;
+};
@@ -29,5 +29,6 @@
 
 VXIpromptResult voiceglue_prompt (const VXIchar *prompt_spec,
 				  const VXIMap *properties);
+VXIpromptResult voiceglue_prefetch (const VXIchar *prompt_spec);
 
 #endif /* include guard VGLUE_PROMPT_H */
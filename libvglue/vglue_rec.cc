@@ -17,21 +17,191 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <syslog.h>
 #include <stdlib.h>
 #include <cerrno>
 #include <vglue_ipc.h>
+#include <vglue_msg.h>
 #include <vglue_rec.h>
 #include <vglue_tostring.h>
+#include <pthread.h>
+#include <cstdio>
 #include <string>
 #include <sstream>
+#include <map>
 
 #include <VXIrec.h>
 
 /*  voiceglue rec (recognition support) routines  */
 
+/*
+**  Process-wide cache of the grammars voiceglue has already parsed.
+**  Every grammar is identified by a key hashed from its type, text and
+**  properties, and voiceglue remembers the parse under that key for
+**  all calls.  A grammar whose key is cached is loaded by a short
+**  GrammarRef message naming the key, instead of shipping and hashing
+**  the whole text again.  Each entry counts the loaded grammar ids
+**  that share it; only entries no longer in use are evicted.
+*/
+#define VOICEGLUE_GRAMMAR_CACHE_MAX 1024
+
+struct voiceglue_grammar_cache_entry
+{
+    unsigned int refs;		    //  loaded grammar ids using this key
+    unsigned long last_use;	    //  for evicting the least recent
+};
+
+typedef std::map<std::string, voiceglue_grammar_cache_entry>
+    voiceglue_grammar_cache_map;
+static voiceglue_grammar_cache_map voiceglue_grammar_cache;
+//  Maps each loaded grammar id to its key
+static std::map<std::string, std::string> voiceglue_grammar_id_key;
+static unsigned long voiceglue_grammar_cache_clock = 0;
+static pthread_mutex_t voiceglue_grammar_cache_mutex =
+    PTHREAD_MUTEX_INITIALIZER;
+
+/*!
+**  Computes the cache key of a grammar from its encoded message fields
+**  @param bytes The type, text and properties as sent to voiceglue
+**  @param len The number of bytes
+**  @param key Gets filled with the key as 32 hex digits
+*/
+static void voiceglue_grammar_key (const char *bytes, size_t len,
+				   char key[33])
+{
+    //  Two independent 64-bit hashes, FNV-1a and a multiply-rotate,
+    //  so an accidental collision between grammars is not a concern
+    unsigned long long h1 = 0xcbf29ce484222325ULL;
+    unsigned long long h2 = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < len; ++i)
+    {
+	unsigned char c = (unsigned char) bytes[i];
+	h1 = (h1 ^ c) * 0x100000001b3ULL;
+	h2 = (h2 + c) * 0xff51afd7ed558ccdULL;
+	h2 ^= h2 >> 29;
+    };
+    h1 = (h1 ^ (unsigned long long) len) * 0x100000001b3ULL;
+    snprintf (key, 33, "%016llx%016llx", h1, h2);
+};
+
+/*!
+**  Looks up a grammar key, counting a use if cached
+**  @param key The grammar key
+**  @return true if voiceglue already holds a parse for the key
+*/
+static bool voiceglue_grammar_cache_lookup (const std::string &key)
+{
+    bool found = false;
+    pthread_mutex_lock (&voiceglue_grammar_cache_mutex);
+    voiceglue_grammar_cache_map::iterator entry =
+	voiceglue_grammar_cache.find (key);
+    if (entry != voiceglue_grammar_cache.end())
+    {
+	entry->second.last_use = ++voiceglue_grammar_cache_clock;
+	found = true;
+    };
+    pthread_mutex_unlock (&voiceglue_grammar_cache_mutex);
+    return found;
+};
+
+/*!
+**  Records a grammar id as loaded under a key, adding the key to the
+**  cache and evicting an unused entry if the cache is full
+**  @param key The grammar key
+**  @param gram_id The id of the grammar
+*/
+static void voiceglue_grammar_cache_add (const std::string &key,
+					 const char *gram_id)
+{
+    pthread_mutex_lock (&voiceglue_grammar_cache_mutex);
+    voiceglue_grammar_cache_map::iterator entry =
+	voiceglue_grammar_cache.find (key);
+    if (entry == voiceglue_grammar_cache.end())
+    {
+	if (voiceglue_grammar_cache.size() >= VOICEGLUE_GRAMMAR_CACHE_MAX)
+	{
+	    voiceglue_grammar_cache_map::iterator victim =
+		voiceglue_grammar_cache.end();
+	    for (voiceglue_grammar_cache_map::iterator i =
+		     voiceglue_grammar_cache.begin();
+		 i != voiceglue_grammar_cache.end(); ++i)
+	    {
+		if ((i->second.refs == 0) &&
+		    ((victim == voiceglue_grammar_cache.end()) ||
+		     (i->second.last_use < victim->second.last_use)))
+		{
+		    victim = i;
+		};
+	    };
+	    if (victim != voiceglue_grammar_cache.end())
+	    {
+		voiceglue_grammar_cache.erase (victim);
+	    };
+	};
+	voiceglue_grammar_cache_entry fresh;
+	fresh.refs = 0;
+	entry = voiceglue_grammar_cache.insert
+	    (voiceglue_grammar_cache_map::value_type (key, fresh)).first;
+    };
+    entry->second.refs++;
+    entry->second.last_use = ++voiceglue_grammar_cache_clock;
+    voiceglue_grammar_id_key[gram_id] = key;
+    pthread_mutex_unlock (&voiceglue_grammar_cache_mutex);
+};
+
+/*!
+**  Releases a grammar id's use of its cached key
+**  @param gram_id The id of the grammar
+*/
+static void voiceglue_grammar_cache_release (const char *gram_id)
+{
+    pthread_mutex_lock (&voiceglue_grammar_cache_mutex);
+    std::map<std::string, std::string>::iterator id =
+	voiceglue_grammar_id_key.find (gram_id);
+    if (id != voiceglue_grammar_id_key.end())
+    {
+	voiceglue_grammar_cache_map::iterator entry =
+	    voiceglue_grammar_cache.find (id->second);
+	if ((entry != voiceglue_grammar_cache.end()) &&
+	    (entry->second.refs > 0))
+	{
+	    entry->second.refs--;
+	};
+	voiceglue_grammar_id_key.erase (id);
+    };
+    pthread_mutex_unlock (&voiceglue_grammar_cache_mutex);
+};
+
+/*!
+**  Builds the full Grammar message in the thread's message builder
+**  @return The offset of the fields the grammar key is computed from
+*/
+static size_t voiceglue_grammar_msg (voiceglue_msg &ipcmsg,
+				     const VXIchar *gram_str,
+				     const VXIchar *gram_type,
+				     const VXIMap *props,
+				     const char *gram_id)
+{
+    ipcmsg.begin ("Grammar")
+	.space().add (gram_id);
+    size_t key_offset = ipcmsg.length();
+    ipcmsg.add_quoted (gram_type)
+	.add_quoted (gram_str)
+	.space().open_quote()
+	.add_property ("inputmodes", props, L"inputmodes")
+	.add_property ("bargein", props, L"bargein")
+	.add_property ("fetchaudiodelay", props, L"fetchaudiodelay")
+	.add_property ("fetchtimeout", props, L"fetchtimeout")
+	.add_property ("termchar", props, L"termchar")
+	.add_property ("termtimeout", props, L"termtimeout")
+	.add_property ("interdigittimeout", props, L"interdigittimeout")
+	.close_quote();
+    return key_offset;
+};
+
 /*!
 **  Loads a grammar into voiceglue
 **  @param gram_str The grammar to load
@@ -45,11 +215,8 @@ VXIrecResult voiceglue_load_grammar (const VXIchar *gram_str,
 				     const VXIMap *props,
 				     const char *gram_id)
 {
-    std::string grammar = VXIchar_to_Std_String (gram_str);
-    std::string type = VXIchar_to_Std_String (gram_type);
-
     //  Sanity-check grammar
-    if (grammar.length() == 0)
+    if ((gram_str == NULL) || (*gram_str == 0))
     {
 	if (voiceglue_loglevel() >= LOG_ERR)
 	{
@@ -58,49 +225,54 @@ VXIrecResult voiceglue_load_grammar (const VXIchar *gram_str,
 	return VXIrec_RESULT_SYNTAX_ERROR;
     };
 
-    //  Create property string parameter
-    std::ostringstream prop_parameter;
-    prop_parameter << "inputmodes="
-		   << VXIMap_Property_to_Std_String (props, "inputmodes")
-		   << " "
-		   << "bargein="
-		   << VXIMap_Property_to_Std_String (props, "bargein")
-		   << " "
-		   << "fetchaudiodelay="
-		   << VXIMap_Property_to_Std_String (props, "fetchaudiodelay")
-		   << " "
-		   << "fetchtimeout="
-		   << VXIMap_Property_to_Std_String (props, "fetchtimeout")
-		   << " "
-		   << "termchar="
-		   << VXIMap_Property_to_Std_String (props, "termchar")
-		   << " "
-		   << "termtimeout="
-		   << VXIMap_Property_to_Std_String (props, "termtimeout")
-		   << " "
-		   << "interdigittimeout="
-		   << VXIMap_Property_to_Std_String (props,
-						     "interdigittimeout");
+    //  Build the parse message and key the grammar by its contents
+    voiceglue_msg &ipcmsg = voiceglue_msg_builder();
+    size_t key_offset = voiceglue_grammar_msg (ipcmsg, gram_str, gram_type,
+					       props, gram_id);
+    char key_buf[33];
+    voiceglue_grammar_key (ipcmsg.data() + key_offset,
+			   ipcmsg.length() - key_offset, key_buf);
+    std::string key (key_buf);
+
+    //  If voiceglue has parsed this grammar before, for any call,
+    //  just reference the parse
+    std::string ipcmsg_result;
+    if (voiceglue_grammar_cache_lookup (key))
+    {
+	voiceglue_msg_builder().begin ("GrammarRef")
+	    .space().add (gram_id)
+	    .space().add (key_buf)
+	    .send();
+	ipcmsg_result = voiceglue_getipcmsg();
+	if ((ipcmsg_result.length() >= 9) &&
+	    ipcmsg_result.substr(0, 9).compare("Grammar 0") == 0)
+	{
+	    voiceglue_grammar_cache_add (key, gram_id);
+	    return VXIrec_RESULT_SUCCESS;
+	};
+
+	//  voiceglue no longer knows the key, send the grammar itself
+	if (voiceglue_loglevel() >= LOG_DEBUG)
+	{
+	    std::ostringstream logstring;
+	    logstring << "grammar key " << key << " not known to voiceglue";
+	    voiceglue_log ((char) LOG_DEBUG, logstring);
+	};
+	voiceglue_grammar_msg (ipcmsg, gram_str, gram_type, props, gram_id);
+    };
 
     //  Send parse message to perl
-    std::ostringstream ipcmsg;
-    ipcmsg << "Grammar "
-	   << gram_id << " "
-	   << voiceglue_escape_SATC_string (type)
-	   << " "
-	   << voiceglue_escape_SATC_string (grammar) << " "
-	   << voiceglue_escape_SATC_string (prop_parameter.str().c_str())
-	   << "\n";
-    voiceglue_sendipcmsg (ipcmsg);
+    ipcmsg.space().add (key_buf).send();
 
     //  Get parse response
-    std::string ipcmsg_result = voiceglue_getipcmsg();
+    ipcmsg_result = voiceglue_getipcmsg();
     if ((ipcmsg_result.length() < 9) ||
 	ipcmsg_result.substr(0, 9).compare("Grammar 0") != 0)
     {
 	return VXIrec_RESULT_FAILURE;
     };
-    
+
+    voiceglue_grammar_cache_add (key, gram_id);
     return VXIrec_RESULT_SUCCESS;
 };
 
@@ -114,10 +286,7 @@ VXIrecResult voiceglue_activate_grammar (const VXIMap *props,
 					 const char *gram_id)
 {
     //  Send activate message to perl
-    std::ostringstream ipcmsg;
-    ipcmsg << "ActivateGrammar "
-	   << gram_id << "\n";
-    voiceglue_sendipcmsg (ipcmsg);
+    voiceglue_msg_builder().begin ("ActivateGrammar").space().add (gram_id).send();
 
     //  Get parse response
     std::string ipcmsg_result = voiceglue_getipcmsg();
@@ -138,10 +307,7 @@ VXIrecResult voiceglue_activate_grammar (const VXIMap *props,
 VXIrecResult voiceglue_deactivate_grammar (const char *gram_id)
 {
     //  Send deactivate message to perl
-    std::ostringstream ipcmsg;
-    ipcmsg << "DeactivateGrammar "
-	   << gram_id << "\n";
-    voiceglue_sendipcmsg (ipcmsg);
+    voiceglue_msg_builder().begin ("DeactivateGrammar").space().add (gram_id).send();
 
     //  Get parse response
     std::string ipcmsg_result = voiceglue_getipcmsg();
@@ -161,11 +327,11 @@ VXIrecResult voiceglue_deactivate_grammar (const char *gram_id)
 */
 VXIrecResult voiceglue_free_grammar (const char *gram_id)
 {
+    //  The parse stays cached in voiceglue for other calls
+    voiceglue_grammar_cache_release (gram_id);
+
     //  Send deactivate message to perl
-    std::ostringstream ipcmsg;
-    ipcmsg << "FreeGrammar "
-	   << gram_id << "\n";
-    voiceglue_sendipcmsg (ipcmsg);
+    voiceglue_msg_builder().begin ("FreeGrammar").space().add (gram_id).send();
 
     //  Get parse response
     std::string ipcmsg_result = voiceglue_getipcmsg();
@@ -188,39 +354,20 @@ VXIrecResult voiceglue_free_grammar (const char *gram_id)
 VXIrecResult voiceglue_recognize (const VXIMap *props,
 				  vxistring &nlsml_result)
 {
-    //  Create property string parameter
-    std::ostringstream prop_parameter;
-    prop_parameter << "inputmodes="
-		   << VXIMap_Property_to_Std_String (props, "inputmodes")
-		   << " "
-		   << "bargein="
-		   << VXIMap_Property_to_Std_String (props, "bargein")
-		   << " "
-		   << "timeout="
-		   << VXIMap_Property_to_Std_String (props, "timeout")
-		   << " "
-		   << "fetchaudiodelay="
-		   << VXIMap_Property_to_Std_String (props, "fetchaudiodelay")
-		   << " "
-		   << "fetchtimeout="
-		   << VXIMap_Property_to_Std_String (props, "fetchtimeout")
-		   << " "
-		   << "termchar="
-		   << VXIMap_Property_to_Std_String (props, "termchar")
-		   << " "
-		   << "termtimeout="
-		   << VXIMap_Property_to_Std_String (props, "termtimeout")
-		   << " "
-		   << "interdigittimeout="
-		   << VXIMap_Property_to_Std_String (props,
-						     "interdigittimeout");
-
     //  Send recognize message to perl
-    std::ostringstream ipcmsg;
-    ipcmsg << "Recognize "
-	   << voiceglue_escape_SATC_string (prop_parameter.str().c_str())
-	   << "\n";
-    voiceglue_sendipcmsg (ipcmsg);
+    voiceglue_msg &ipcmsg = voiceglue_msg_builder();
+    ipcmsg.begin ("Recognize")
+	.space().open_quote()
+	.add_property ("inputmodes", props, L"inputmodes")
+	.add_property ("bargein", props, L"bargein")
+	.add_property ("timeout", props, L"timeout")
+	.add_property ("fetchaudiodelay", props, L"fetchaudiodelay")
+	.add_property ("fetchtimeout", props, L"fetchtimeout")
+	.add_property ("termchar", props, L"termchar")
+	.add_property ("termtimeout", props, L"termtimeout")
+	.add_property ("interdigittimeout", props, L"interdigittimeout")
+	.close_quote()
+	.send();
 
     //  Get recognize response
     std::string ipcmsg_result = voiceglue_getipcmsg();
@@ -263,19 +410,65 @@ VXIrecResult voiceglue_recognize (const VXIMap *props,
     return vxi_ret_code;
 };
 
+/*!
+**  Releases a recording mapped by voiceglue_record()
+**  @param content The mapped waveform, set to NULL
+**  @param userData The size of the mapping in bytes
+*/
+static void voiceglue_recording_destroy (VXIbyte **content, void *userData)
+{
+    if ((content != NULL) && (*content != NULL))
+    {
+	munmap (*content, (size_t) userData);
+	*content = NULL;
+    };
+};
+
+/*!
+**  Releases a recording read by voiceglue_record()
+**  @param content The waveform copy, set to NULL
+**  @param userData Unused
+*/
+static void voiceglue_recording_free (VXIbyte **content, void *userData)
+{
+    if ((content != NULL) && (*content != NULL))
+    {
+	free (*content);
+	*content = NULL;
+    };
+};
+
+/*!
+**  Closes a descriptor passed with a Record response that is not used
+**  @param fd The descriptor, or -1
+**  @param result The result to return
+**  @return result
+*/
+static VXIrecResult voiceglue_record_fail (int fd, VXIrecResult result)
+{
+    if (fd != -1)
+    {
+	close (fd);
+    };
+    return result;
+};
+
 /*!
 **  Performs a record.
+**  The recording arrives as a descriptor passed with the response and
+**  is mapped read-only rather than read, so its pages are only brought
+**  in if the content is actually looked at.  From an older voiceglue it
+**  arrives as a path that later records reuse, and a copy is read.
 **  @param props The property map
-**  @param waveform Gets filled with pointer to malloc'd buffer of waveform
-**  @param waveform_len Gets filled with number of bytes in waveform
+**  @param waveform Gets filled with a ulaw VXIContent of the waveform,
+**                  or NULL if no audio was recorded
 **  @param duration Gets filled with duration of recording in ms
 **  @param recorded_maxtime Gets filled with whether maxtime was hit (1 or 0)
 **  @param terminator_digit The digit that terminated the recording, or 0
 **  @return VXIrec_RESULT_SUCCESS on success, an error code on failure.
 */
 VXIrecResult voiceglue_record (const VXIMap *props,
-			       unsigned char **waveform,
-			       unsigned int *waveform_len,
+			       VXIContent **waveform,
 			       unsigned int *duration,
 			       int *recorded_maxtime,
 			       VXIbyte *terminator_digit)
@@ -283,35 +476,22 @@ VXIrecResult voiceglue_record (const VXIMap *props,
     //  Initialize return for error condition,
     //  will replace later on success.
     *waveform = NULL;
-    *waveform_len = 0;
-
-    //  Create property string parameter
-    std::ostringstream prop_parameter;
-    prop_parameter
-	<< "beep="
-	<< VXIMap_Property_to_Std_String (props, "vxi.rec.beep")
-	<< " "
-	<< "rectype="
-	<< VXIMap_Property_to_Std_String (props, "@rectype")
-	<< " "
-	<< "maxtime="
-	<< VXIMap_Property_to_Std_String (props, "@maxtime")
-	<< " "
-	<< "finalsilence="
-	<< VXIMap_Property_to_Std_String (props, "@finalsilence")
-	<< " "
-	<< "dtmfterm="
-	<< VXIMap_Property_to_Std_String (props, "@dtmfterm");
 
     //  Send record message to perl
-    std::ostringstream ipcmsg;
-    ipcmsg << "Record "
-	   << voiceglue_escape_SATC_string (prop_parameter.str().c_str())
-	   << "\n";
-    voiceglue_sendipcmsg (ipcmsg);
-
-    //  Get record response
+    voiceglue_msg &ipcmsg = voiceglue_msg_builder();
+    ipcmsg.begin ("Record")
+	.space().open_quote()
+	.add_property ("beep", props, L"vxi.rec.beep")
+	.add_property ("rectype", props, L"@rectype")
+	.add_property ("maxtime", props, L"@maxtime")
+	.add_property ("finalsilence", props, L"@finalsilence")
+	.add_property ("dtmfterm", props, L"@dtmfterm")
+	.close_quote()
+	.send();
+
+    //  Get record response, and the recording if passed with it
     std::string ipcmsg_result = voiceglue_getipcmsg();
+    int rec_file_fd = voiceglue_ipc_take_fd();
 
     //  Parse out message type
     if ((ipcmsg_result.length() < 9) ||
@@ -324,7 +504,8 @@ VXIrecResult voiceglue_record (const VXIMap *props,
 		   << ipcmsg_result;
 	    voiceglue_log ((char) LOG_ERR, errmsg);
 	};
-	return VXIrec_RESULT_PLATFORM_ERROR;
+	return voiceglue_record_fail (rec_file_fd,
+				      VXIrec_RESULT_PLATFORM_ERROR);
     };
     ipcmsg_result.erase (0, 9);
 
@@ -340,14 +521,15 @@ VXIrecResult voiceglue_record (const VXIMap *props,
 		   << ipcmsg_result;
 	    voiceglue_log ((char) LOG_ERR, errmsg);
 	};
-	return VXIrec_RESULT_PLATFORM_ERROR;
+	return voiceglue_record_fail (rec_file_fd,
+				      VXIrec_RESULT_PLATFORM_ERROR);
     };
     int ret_code = atoi (ipcmsg_result.c_str());
     VXIrecResult vxi_ret_code = (VXIrecResult) ret_code;
     ipcmsg_result.erase (0, ws_index + 1);
     if (vxi_ret_code != 0)
     {
-	return vxi_ret_code;
+	return voiceglue_record_fail (rec_file_fd, vxi_ret_code);
     };
 
     //  Parse out integer reason code
@@ -362,7 +544,8 @@ VXIrecResult voiceglue_record (const VXIMap *props,
 		   << ipcmsg_result;
 	    voiceglue_log ((char) LOG_ERR, errmsg);
 	};
-	return VXIrec_RESULT_PLATFORM_ERROR;
+	return voiceglue_record_fail (rec_file_fd,
+				      VXIrec_RESULT_PLATFORM_ERROR);
     };
     int reason_code = atoi (ipcmsg_result.c_str());
     if (reason_code == 4)
@@ -377,7 +560,7 @@ VXIrecResult voiceglue_record (const VXIMap *props,
     if (reason_code == 5)
     {
 	//  Case of no audio started (noinput)
-	return vxi_ret_code;
+	return voiceglue_record_fail (rec_file_fd, vxi_ret_code);
     };
 
     //  Parse out integer duration code
@@ -392,7 +575,8 @@ VXIrecResult voiceglue_record (const VXIMap *props,
 		   << ipcmsg_result;
 	    voiceglue_log ((char) LOG_ERR, errmsg);
 	};
-	return VXIrec_RESULT_PLATFORM_ERROR;
+	return voiceglue_record_fail (rec_file_fd,
+				      VXIrec_RESULT_PLATFORM_ERROR);
     };
     *duration = atoi (ipcmsg_result.c_str());
     ipcmsg_result.erase (0, ws_index + 1);
@@ -409,7 +593,8 @@ VXIrecResult voiceglue_record (const VXIMap *props,
 		   << ipcmsg_result;
 	    voiceglue_log ((char) LOG_ERR, errmsg);
 	};
-	return VXIrec_RESULT_PLATFORM_ERROR;
+	return voiceglue_record_fail (rec_file_fd,
+				      VXIrec_RESULT_PLATFORM_ERROR);
     };
     VXIbyte digit = *(ipcmsg_result.c_str());
     if (digit == '-') {digit = (VXIbyte) 0;};
@@ -417,8 +602,14 @@ VXIrecResult voiceglue_record (const VXIMap *props,
     ipcmsg_result.erase (0, ws_index + 1);
     //  Rest is the filename of the recorded waveform
 
-    //  Read the file
-    int rec_file_fd = open (ipcmsg_result.c_str(), O_RDONLY);
+    //  Map the file if voiceglue passed it, it has then been unlinked
+    //  so the next record on the call cannot change it.  Otherwise the
+    //  path is reused by the next record, so read a copy of it.
+    int rec_file_passed = (rec_file_fd != -1);
+    if (! rec_file_passed)
+    {
+	rec_file_fd = open (ipcmsg_result.c_str(), O_RDONLY | O_CLOEXEC);
+    };
     if (rec_file_fd == -1)
     {
 	if (voiceglue_loglevel() >= LOG_ERR)
@@ -446,10 +637,10 @@ VXIrecResult voiceglue_record (const VXIMap *props,
 		   << stat_result;
 	    voiceglue_log ((char) LOG_ERR, errmsg);
 	};
+	close (rec_file_fd);
 	return VXIrec_RESULT_PLATFORM_ERROR;
     };
     unsigned int rec_file_size = (unsigned int) stat_buf.st_size;
-    *waveform_len = rec_file_size;
     if (voiceglue_loglevel() >= LOG_DEBUG)
     {
 	std::ostringstream errmsg;
@@ -465,34 +656,82 @@ VXIrecResult voiceglue_record (const VXIMap *props,
     };
     if (rec_file_size == 0)
     {
+	close (rec_file_fd);
 	return vxi_ret_code;
     };
-    *waveform = (unsigned char *) malloc (rec_file_size);
-    unsigned int bytes_read = 0;
-    ssize_t read_result;
-    while (bytes_read < rec_file_size)
-    {
-	read_result = read (rec_file_fd, *waveform + bytes_read,
-			    rec_file_size - bytes_read);
-	if (read_result <= 0)
+    if (! rec_file_passed)
+    {
+	VXIbyte *copy = (VXIbyte *) malloc (rec_file_size);
+	if (copy == NULL)
 	{
-	    if (voiceglue_loglevel() >= LOG_ERR)
+	    close (rec_file_fd);
+	    return VXIrec_RESULT_OUT_OF_MEMORY;
+	};
+	unsigned int bytes_read = 0;
+	ssize_t read_result;
+	while (bytes_read < rec_file_size)
+	{
+	    read_result = read (rec_file_fd, copy + bytes_read,
+				rec_file_size - bytes_read);
+	    if ((read_result == -1) && (errno == EINTR))
+	    {
+		continue;
+	    };
+	    if (read_result <= 0)
 	    {
-		std::ostringstream errmsg;
-		errmsg << "Recorded file \""
-		       << ipcmsg_result
-		       << "\", cannot be read, read return code="
-		       << read_result
-		       << " errno="
-		       << errno;
-		voiceglue_log ((char) LOG_ERR, errmsg);
+		if (voiceglue_loglevel() >= LOG_ERR)
+		{
+		    std::ostringstream errmsg;
+		    errmsg << "Recorded file \""
+			   << ipcmsg_result
+			   << "\", cannot be read, read return code="
+			   << read_result
+			   << " errno="
+			   << errno;
+		    voiceglue_log ((char) LOG_ERR, errmsg);
+		};
+		free (copy);
+		close (rec_file_fd);
+		return VXIrec_RESULT_PLATFORM_ERROR;
 	    };
-	    free (*waveform);
-	    *waveform = NULL;
-	    *waveform_len = 0;
-	    return VXIrec_RESULT_PLATFORM_ERROR;
+	    bytes_read += read_result;
 	};
-	bytes_read += read_result;
+	close (rec_file_fd);
+	*waveform = VXIContentCreate (VXIREC_MIMETYPE_ULAW,
+				      copy, rec_file_size,
+				      voiceglue_recording_free, NULL);
+	if (*waveform == NULL)
+	{
+	    free (copy);
+	    return VXIrec_RESULT_OUT_OF_MEMORY;
+	};
+	return vxi_ret_code;
+    };
+    void *mapped = mmap (NULL, rec_file_size, PROT_READ, MAP_PRIVATE,
+			 rec_file_fd, 0);
+    int mmap_errno = errno;
+    close (rec_file_fd);
+    if (mapped == MAP_FAILED)
+    {
+	if (voiceglue_loglevel() >= LOG_ERR)
+	{
+	    std::ostringstream errmsg;
+	    errmsg << "Recorded file \""
+		   << ipcmsg_result
+		   << "\", cannot be mapped, errno="
+		   << mmap_errno;
+	    voiceglue_log ((char) LOG_ERR, errmsg);
+	};
+	return VXIrec_RESULT_PLATFORM_ERROR;
+    };
+    *waveform = VXIContentCreate (VXIREC_MIMETYPE_ULAW,
+				  (VXIbyte *) mapped, rec_file_size,
+				  voiceglue_recording_destroy,
+				  (void *) (size_t) rec_file_size);
+    if (*waveform == NULL)
+    {
+	munmap (mapped, rec_file_size);
+	return VXIrec_RESULT_OUT_OF_MEMORY;
     };
 
     return vxi_ret_code;
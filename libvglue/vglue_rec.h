@@ -38,8 +38,7 @@ VXIrecResult voiceglue_free_grammar (const char *gram_id);
 VXIrecResult voiceglue_recognize (const VXIMap *props,
 				  vxistring &nlsml_result);
 VXIrecResult voiceglue_record (const VXIMap *props,
-			       unsigned char **waveform,
-			       unsigned int *waveform_len,
+			       VXIContent **waveform,
 			       unsigned int *duration,
 			       int *recorded_maxtime,
 			       VXIbyte *terminator_digit);
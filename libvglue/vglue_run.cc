@@ -70,6 +70,16 @@ int voiceglue_start_platform (int num_channels, int logfd, int loglevel,
 	return (1);
     };
 
+    /*  Apply the dynlog feed overflow policy  */
+    const VXIValue *block_on_overflow =
+	VXIMapGetProperty (config_args, L"client.log.vglueBlockOnOverflow");
+    if ((block_on_overflow != NULL) &&
+	(VXIValueGetType (block_on_overflow) == VALUE_INTEGER) &&
+	(VXIIntegerValue ((const VXIInteger *) block_on_overflow) != 0))
+    {
+	voiceglue_log_set_overflow_policy (VOICEGLUE_LOG_OVERFLOW_BLOCK);
+    };
+
     /*  Add the logfd and loglevel to the configArgs  */
     VXIMapSetProperty (config_args, L"logfd",
 		       (VXIValue *) VXIIntegerCreate (logfd));
@@ -136,14 +146,16 @@ int voiceglue_stop_thread (void *channel_handle)
 };
 
 /*!
-** Stops the VXI platform.  The
+** Stops the VXI platform, and flushes the log.  The
 ** config args configArgs are from vxiStartPlatform().
 ** @param platform_ The handle returned from vxiStartPlatform
 ** @return 0 on success, 1 on failure (on failure, check message log)
 */
 int voiceglue_stop_platform (void *platform_handle)
 {
-    return vxiStopPlatform (platform_handle);
+    int result = vxiStopPlatform (platform_handle);
+    voiceglue_log_shutdown();
+    return result;
 };
 
 /*!
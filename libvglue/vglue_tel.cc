@@ -19,6 +19,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <vglue_ipc.h>
+#include <vglue_msg.h>
 #include <vglue_tel.h>
 #include <vglue_tostring.h>
 #include <string>
@@ -27,58 +28,33 @@
 /*  voiceglue tel (telephony support) routines  */
 
 /*!
-**  Gets current telephone line status
+**  Gets current telephone line status, as last pushed by voiceglue
 **  @return VXItel_STATUS_ACTIVE (connected) or VXItel_STATUS_INACTIVE (hungup)
 */
 VXItelStatus voiceglue_get_line_status ()
 {
-    //  Send request to perl
-    voiceglue_sendipcmsg ("GetLineStatus\n");
-
-    //  Get response
-    std::string ipcmsg_result = voiceglue_getipcmsg();
-    if ((ipcmsg_result.length() < 12) ||
-	ipcmsg_result.substr(0, 11).compare("LineStatus ") != 0)
-    {
-	if (voiceglue_loglevel() >= LOG_ERR)
-	{
-	    std::ostringstream errmsg;
-	    errmsg << "invalid response to GetLineStatus: "
-		   << ipcmsg_result;
-	    voiceglue_log ((char) LOG_ERR, errmsg);
-	};
-	return VXItel_STATUS_INACTIVE;
-    };
-    if (ipcmsg_result.substr(11, 1).compare("1") == 0)
+    if (voiceglue_ipc_line_status())
     {
-	if (voiceglue_loglevel() >= LOG_DEBUG)
-	{
-	    std::ostringstream errmsg;
-	    errmsg << "LineStatus is CONNECTED";
-	    voiceglue_log ((char) LOG_DEBUG, errmsg);
-	};
 	return VXItel_STATUS_ACTIVE;
     };
-    if (ipcmsg_result.substr(11, 1).compare("0") == 0)
-    {
-	if (voiceglue_loglevel() >= LOG_DEBUG)
-	{
-	    std::ostringstream errmsg;
-	    errmsg << "LineStatus is DISCONNECTED";
-	    voiceglue_log ((char) LOG_DEBUG, errmsg);
-	};
-	return VXItel_STATUS_INACTIVE;
-    };
-    if (voiceglue_loglevel() >= LOG_ERR)
+    if (voiceglue_loglevel() >= LOG_DEBUG)
     {
 	std::ostringstream errmsg;
-	errmsg << "invalid parameter from LineStatus msg: "
-	       << ipcmsg_result;
-	voiceglue_log ((char) LOG_ERR, errmsg);
+	errmsg << "LineStatus is DISCONNECTED";
+	voiceglue_log ((char) LOG_DEBUG, errmsg);
     };
     return VXItel_STATUS_INACTIVE;
 };
 
+/*!
+**  Hangs up the call
+*/
+void voiceglue_disconnect ()
+{
+    voiceglue_ipc_set_line_status (0);
+    voiceglue_msg_builder().begin ("Disconnect").send();
+};
+
 /*
  *  Peforms a transfer
  *  @param dest The destination
@@ -93,8 +69,7 @@ VXItelResult voiceglue_transfer (std::string dest,
 				 std::string timeout,
 				 std::string &result)
 {
-    std::ostringstream ipc_msg;
-    std::string type_string;
+    const char *type_string;
 
     //  Decode transfer type
     if (type == 0)
@@ -111,16 +86,12 @@ VXItelResult voiceglue_transfer (std::string dest,
     };
 
     //  Send request to voiceglue
-    ipc_msg << "Transfer "
-	    << voiceglue_escape_SATC_string (dest.c_str())
-	    << " "
-	    << voiceglue_escape_SATC_string (from.c_str())
-	    << " "
-	    << voiceglue_escape_SATC_string (type_string)
-	    << " "
-	    << voiceglue_escape_SATC_string (timeout.c_str())
-	    << "\n";
-    voiceglue_sendipcmsg (ipc_msg.str().c_str());
+    voiceglue_msg_builder().begin ("Transfer")
+	.add_quoted (dest.c_str())
+	.add_quoted (from.c_str())
+	.add_quoted (type_string)
+	.add_quoted (timeout.c_str())
+	.send();
 
     //  Wait for it to finish
     std::string ipcmsg_result = voiceglue_getipcmsg();
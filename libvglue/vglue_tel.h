@@ -28,6 +28,7 @@
 #include <VXItel.h>
 
 VXItelStatus voiceglue_get_line_status ();
+void voiceglue_disconnect ();
 VXItelResult voiceglue_transfer (std::string dest,
 				 std::string from,
 				 int type,
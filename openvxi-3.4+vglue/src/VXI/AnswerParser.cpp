@@ -28,7 +28,7 @@
 #include "VXIrec.h"                     // for a single type name (eliminate?)
 #include "XMLChConverter.hpp"           // for xmlcharstring
 #include <sstream>
-#include <map>
+#include <algorithm>
 #include <list>
 #include <vector>
 
@@ -38,6 +38,7 @@
 
 #include <framework/MemBufInputSource.hpp>
 #include <sax/ErrorHandler.hpp>         // by XMLErrorReporter
+#include <sax/HandlerBase.hpp>
 #include <dom/DOM.hpp>
 #include <sax/SAXParseException.hpp>
 #include <util/XMLChar.hpp>
@@ -61,6 +62,7 @@ public:
   
   void SetInstance(DOMElement *is) { instanceDomList.push_back(is); }
   void SetInstance(const xmlcharstring & is){ instanceStrList.push_back(is); }  
+  void SetInstanceText(const XMLCh * is) { instanceTextList.push_back(is); }
 
   bool operator<(const AnswerHolder & x) 
   {
@@ -93,6 +95,7 @@ public:
       fConfidence = x.fConfidence;
       instanceDomList = x.instanceDomList;
       instanceStrList = x.instanceStrList;
+      instanceTextList = x.instanceTextList;
       answerElement = x.answerElement;
     }
     return *this;
@@ -111,10 +114,11 @@ public:
   DOMLIST instanceDomList;
   typedef std::list<xmlcharstring> STRLIST;
   STRLIST instanceStrList;    
+  STRLIST instanceTextList;     // text <instance>s, when no DOM was built
 };  
 
 typedef std::vector<AnswerHolder > ANSWERHOLDERVECTOR;
-typedef std::map<VXIflt32, ANSWERHOLDERVECTOR, std::greater<VXIflt32> > ANSWERHOLDERMAP;
+typedef std::vector<AnswerHolder *> ANSWERHOLDERORDER;
 
 class AnswerParserErrorReporter : public ErrorHandler {
 public:
@@ -135,7 +139,101 @@ private:
 
 // ---------------------------------------------------------------------------
 
+// One <instance> of an interpretation, as read by NLSMLHandler.
+struct NLSMLInstance {
+  std::basic_string<XMLCh> text;
+  bool hasData;                  // any text or element content at all
+};
+
+// One <interpretation>, as read by NLSMLHandler.
+struct NLSMLInterpretation {
+  enum InputEvent { NO_EVENT, NOINPUT_EVENT, NOMATCH_EVENT, INVALID_EVENT };
+
+  std::basic_string<XMLCh> grammar;
+  std::basic_string<XMLCh> confidence;       // of the <interpretation>
+  std::basic_string<XMLCh> inputConfidence;  // of the <input>
+  std::basic_string<XMLCh> mode;
+  std::basic_string<XMLCh> inputText;
+  InputEvent event;                // first element inside <input>
+  bool hasInput;
+  const VXIchar * error;           // first malformed child, or NULL
+
+  std::vector<NLSMLInstance> instances;
+  unsigned int instanceCount;      // entries past this are left for reuse
+};
+
+// Reads a NLSML result in a single pass.  The structural errors which
+// ProcessNLSML finds while walking the DOM are recorded where they occur,
+// so ProcessResult can report them in the same order.  The records are
+// reused from one result to the next.
+class AnswerParser::NLSMLHandler : public HandlerBase {
+public:
+  NLSMLHandler() : HandlerBase(), count(0) { Reset(); }
+  virtual ~NLSMLHandler() { }
+
+  void Reset();
+
+  void startElement(const XMLCh* const, AttributeList&);
+  void endElement(const XMLCh* const);
+  void characters(const XMLCh* const chars, const unsigned int length);
+
+  void warning(const SAXParseException& toCatch)     { /* Ignore */ }
+  void fatalError(const SAXParseException& toCatch)  { error(toCatch); }
+  void error(const SAXParseException & toCatch)
+  { throw SAXParseException(toCatch); }
+
+  bool NeedsDOM() const                       { return needsDOM; }
+  unsigned int GetCount() const               { return count; }
+  const NLSMLInterpretation & Get(unsigned int i) const
+  { return interpretations[i]; }
+
+  const VXIchar * GetError(unsigned int i) const
+  { return (i == errorAt) ? resultError : NULL; }
+  // Returns the error found after the first i interpretations, if any.
+
+private:
+  void SetError(const VXIchar * message);
+
+  std::vector<NLSMLInterpretation> interpretations;
+  unsigned int count;
+  std::basic_string<XMLCh> resultGrammar;
+  int depth;
+  bool inInput;
+  bool inInstance;
+  bool needsDOM;                   // an <instance> holds elements
+  const VXIchar * resultError;
+  unsigned int errorAt;
+
+  NLSMLHandler(const NLSMLHandler &);             // not implemented
+  NLSMLHandler & operator=(const NLSMLHandler &); // not implemented
+};
+
+// ---------------------------------------------------------------------------
+
 AnswerParser::AnswerParser()
+  : nlsmlHandler(NULL), nlsmlSaxParser(NULL), nlsmlParser(NULL)
+{
+  nlsmlHandler = new NLSMLHandler();
+  if (nlsmlHandler == NULL)
+    throw VXIException::OutOfMemory();
+
+  nlsmlSaxParser = new SAXParser();
+  if (nlsmlSaxParser == NULL) {
+    delete nlsmlHandler;
+    nlsmlHandler = NULL;
+    throw VXIException::OutOfMemory();
+  }
+
+  nlsmlSaxParser->setValidationScheme(SAXParser::Val_Never);
+  nlsmlSaxParser->setDoNamespaces(false);
+  nlsmlSaxParser->setDoSchema(false);
+  nlsmlSaxParser->setValidationSchemaFullChecking(false);
+  nlsmlSaxParser->setDocumentHandler(nlsmlHandler);
+  nlsmlSaxParser->setErrorHandler(nlsmlHandler);
+}
+
+
+void AnswerParser::CreateDOMParser()
 {
     //  Log to voiceglue
     /*
@@ -147,17 +245,17 @@ AnswerParser::AnswerParser()
     };
     */
 
-  nlsmlParser = new XercesDOMParser();
-  if (nlsmlParser == NULL)
+  XercesDOMParser * domParser = new XercesDOMParser();
+  if (domParser == NULL)
     throw VXIException::OutOfMemory();
 
-  nlsmlParser->setValidationScheme( XercesDOMParser::Val_Never);
-  nlsmlParser->setDoNamespaces(false);
-  nlsmlParser->setDoSchema(false);
-  nlsmlParser->setValidationSchemaFullChecking(false);
-  nlsmlParser->setCreateEntityReferenceNodes(false);
+  domParser->setValidationScheme( XercesDOMParser::Val_Never);
+  domParser->setDoNamespaces(false);
+  domParser->setDoSchema(false);
+  domParser->setValidationSchemaFullChecking(false);
+  domParser->setCreateEntityReferenceNodes(false);
 
-  // nlsmlParser->setToCreateXMLDeclTypeNode(true);
+  // domParser->setToCreateXMLDeclTypeNode(true);
 
   ErrorHandler *errReporter = new AnswerParserErrorReporter();
   if (errReporter == NULL) {
@@ -172,11 +270,12 @@ AnswerParser::AnswerParser()
     };
       */
 
-    delete nlsmlParser;
+    delete domParser;
     throw VXIException::OutOfMemory();
   }
 
-  nlsmlParser->setErrorHandler(errReporter);
+  domParser->setErrorHandler(errReporter);
+  nlsmlParser = domParser;
 }
 
 
@@ -200,6 +299,11 @@ AnswerParser::~AnswerParser()
     delete nlsmlParser;
     nlsmlParser = NULL;
   }
+
+  delete nlsmlSaxParser;
+  nlsmlSaxParser = NULL;
+  delete nlsmlHandler;
+  nlsmlHandler = NULL;
 }
 
 inline bool AnswerParser::IsAllWhiteSpace(const XMLCh* str)
@@ -254,10 +358,19 @@ AnswerParser::ParseResult AnswerParser::Parse(SimpleLogger & log, AnswerTranslat
 	  return AnswerParser::UnsupportedContent;
   }
   else {
+    bool useDOM = false;
     try {
       VXIcharToXMLCh membufURL(L"nlsml recognition result");
       MemBufInputSource buf(docContent,docContentSize,membufURL.c_str(),false);
-      nlsmlParser->parse(buf);
+      nlsmlHandler->Reset();
+      nlsmlSaxParser->parse(buf);
+
+      // (2.1) XML instances are set from the DOM.
+      if (nlsmlHandler->NeedsDOM()) {
+        if (nlsmlParser == NULL) CreateDOMParser();
+        nlsmlParser->parse(buf);
+        useDOM = true;
+      }
     }
     catch (const XMLException & exception) {
       if (log.IsLogging(0)) {
@@ -280,7 +393,10 @@ AnswerParser::ParseResult AnswerParser::Parse(SimpleLogger & log, AnswerTranslat
       return AnswerParser::ParseError;
     }
 
-    switch (ProcessNLSML(log, translator, gm, maxnbest, bestAnswer)) {
+    int result = useDOM
+      ? ProcessNLSML(log, translator, gm, maxnbest, bestAnswer)
+      : ProcessResult(log, translator, gm, maxnbest, bestAnswer);
+    switch (result) {
     case -1:
       return AnswerParser::ParseError;
     case 0:
@@ -327,6 +443,172 @@ static const XMLCh DEFAULT_MODE[]
     = { 's','p','e','e','c','h','\0' };
 
 
+static bool IsWhiteSpace(const XMLCh * chars, unsigned int length)
+{
+  for (unsigned int i = 0; i < length; ++i)
+    if (chars[i] != '\r' && chars[i] != '\n' && chars[i] != '\t' &&
+        chars[i] != ' ')
+      return false;
+  return true;
+}
+
+static void GetAttribute(AttributeList & attrs, const XMLCh * name,
+                         std::basic_string<XMLCh> & value)
+{
+  const XMLCh * temp = attrs.getValue(name);
+  if (temp == NULL) value.erase();
+  else value = temp;
+}
+
+void AnswerParser::NLSMLHandler::Reset()
+{
+  count = 0;
+  resultGrammar.erase();
+  depth = 0;
+  inInput = false;
+  inInstance = false;
+  needsDOM = false;
+  resultError = NULL;
+  errorAt = 0;
+}
+
+void AnswerParser::NLSMLHandler::SetError(const VXIchar * message)
+{
+  if (resultError != NULL) return;
+  resultError = message;
+  errorAt = count;
+}
+
+void AnswerParser::NLSMLHandler::startElement(const XMLCh* const name,
+                                              AttributeList & attrs)
+{
+  ++depth;
+  if (resultError != NULL) return;
+
+  switch (depth) {
+  case 1:   // (1) <result>
+    if (!Compare(name, NODE_RESULT)) {
+      SetError(L"AnswerParser: document must have a single "
+               L"root named 'result'");
+      return;
+    }
+    GetAttribute(attrs, ATTR_GRAMMAR, resultGrammar);
+    break;
+
+  case 2:   // (2) <interpretation>
+  {
+    if (!Compare(name, NODE_INTERPRETATION)) {
+      SetError(L"AnswerParser: only <interpretation> elements may "
+               L"follow <result>");
+      return;
+    }
+
+    if (count == interpretations.size())
+      interpretations.push_back(NLSMLInterpretation());
+    NLSMLInterpretation & interp = interpretations[count++];
+
+    GetAttribute(attrs, ATTR_GRAMMAR, interp.grammar);
+    if (interp.grammar.empty()) interp.grammar = resultGrammar;
+    GetAttribute(attrs, ATTR_CONFIDENCE, interp.confidence);
+    interp.inputConfidence.erase();
+    interp.mode.erase();
+    interp.inputText.erase();
+    interp.event = NLSMLInterpretation::NO_EVENT;
+    interp.hasInput = false;
+    interp.error = NULL;
+    interp.instanceCount = 0;
+    break;
+  }
+
+  case 3:   // (3) <input> and <instance>
+  {
+    NLSMLInterpretation & interp = interpretations[count - 1];
+    if (interp.error != NULL) return;
+
+    if (Compare(name, NODE_INSTANCE)) {
+      if (interp.instanceCount == interp.instances.size())
+        interp.instances.push_back(NLSMLInstance());
+      NLSMLInstance & instance = interp.instances[interp.instanceCount++];
+      instance.text.erase();
+      instance.hasData = false;
+      inInstance = true;
+    }
+    else if (!Compare(name, NODE_INPUT))
+      interp.error = L"AnswerParser: Only <input> and <instance> "
+                     L"elements are allowed in an <interpretation>";
+    else if (interp.hasInput)
+      interp.error = L"AnswerParser: Only one <input> element is "
+                     L"allowed in an <interpretation>";
+    else {
+      interp.hasInput = true;
+      GetAttribute(attrs, ATTR_MODE, interp.mode);
+      GetAttribute(attrs, ATTR_CONFIDENCE, interp.inputConfidence);
+      inInput = true;
+    }
+    break;
+  }
+
+  case 4:   // (4) <noinput>, <nomatch> or the instance data
+  {
+    NLSMLInterpretation & interp = interpretations[count - 1];
+    if (inInput && interp.event == NLSMLInterpretation::NO_EVENT) {
+      if (Compare(name, NODE_NOINPUT))
+        interp.event = NLSMLInterpretation::NOINPUT_EVENT;
+      else if (Compare(name, NODE_NOMATCH))
+        interp.event = NLSMLInterpretation::NOMATCH_EVENT;
+      else
+        interp.event = NLSMLInterpretation::INVALID_EVENT;
+    }
+    else if (inInstance) {
+      interp.instances[interp.instanceCount - 1].hasData = true;
+      needsDOM = true;
+    }
+    break;
+  }
+
+  default:
+    break;
+  }
+}
+
+void AnswerParser::NLSMLHandler::endElement(const XMLCh* const name)
+{
+  if (depth == 3) {
+    inInput = false;
+    inInstance = false;
+  }
+  --depth;
+}
+
+void AnswerParser::NLSMLHandler::characters(const XMLCh* const chars,
+                                            const unsigned int length)
+{
+  if (resultError != NULL || depth < 1) return;
+
+  if (depth == 1) {
+    if (!IsWhiteSpace(chars, length))
+      SetError(L"AnswerParser: PCDATA not allowed after <result>");
+    return;
+  }
+
+  NLSMLInterpretation & interp = interpretations[count - 1];
+  if (depth == 2) {
+    if (interp.error == NULL && !IsWhiteSpace(chars, length))
+      interp.error = L"AnswerParser: PCDATA not allowed after "
+                     L"<interpretation>";
+  }
+  else if (depth == 3 && inInput) {
+    if (interp.event == NLSMLInterpretation::NO_EVENT)
+      interp.inputText.append(chars, length);
+  }
+  else if (depth == 3 && inInstance) {
+    NLSMLInstance & instance = interp.instances[interp.instanceCount - 1];
+    instance.text.append(chars, length);
+    instance.hasData = true;
+  }
+}
+
+
 // This function is used by the other NLSMLSetVars functions to set everything
 // but the 'interpretation'.
 //
@@ -498,6 +780,25 @@ static bool SetUpNBestList(int *nbest, bool *isAmbigous, SimpleLogger & log,
       }
       ++(*nbest);
     }  
+
+    // or text read without a DOM
+    AnswerHolder::STRLIST::iterator tpos;
+    for(tpos = ans.instanceTextList.begin(); 
+        tpos != ans.instanceTextList.end(); ++tpos, ++index) {
+
+      if (index > 0)
+        *isAmbigous = true;
+
+      if (log.IsLogging(2)) {
+         log.StartDiagnostic(2) << L"SetUpNBestList(" << *nbest
+         << L", " << XMLChToVXIchar(ans.grammarid).c_str() << L")";
+         log.EndDiagnostic();
+      }
+
+      NLSMLSetVars(translator, *nbest, ans.confidence, 
+                   ans.utterance.c_str(), ans.inputmode, (*tpos).c_str());
+      ++(*nbest);
+    }
   } 
   else {
     // Use the input text(utterance) as instance
@@ -522,6 +823,66 @@ static bool SetUpNBestList(int *nbest, bool *isAmbigous, SimpleLogger & log,
   return true;
 }
 
+static bool HigherConfidence(const AnswerHolder * x, const AnswerHolder * y)
+{
+  return x->fConfidence > y->fConfidence;
+}
+
+// This function sets up the lastresult$ structure from the answers, best
+// confidence first and, for the same confidence, by grammar precedence.
+//
+static int SetUpLastResult(SimpleLogger & log, AnswerTranslator & translator,
+                           int maxnbest, ANSWERHOLDERVECTOR & answers,
+                           VXMLElement & bestAnswer)
+{
+  if( answers.empty() ) {
+    // something is wrong, return error
+    log.LogDiagnostic(0, L"AnswerParser: the result structure is corrupted");                         
+    return -1;
+  }
+
+  // order by confidence, keeping the document order for the same score
+  ANSWERHOLDERORDER a;
+  a.reserve(answers.size());
+  for (ANSWERHOLDERVECTOR::iterator i = answers.begin(); i != answers.end(); ++i)
+    a.push_back(&(*i));
+  std::stable_sort(a.begin(), a.end(), HigherConfidence);
+
+  // go through each run of the same score and sort its precedence using
+  // selection sort
+  int vsize = a.size();
+  for( int first = 0, last = 0; first < vsize; first = last ) {
+    for( last = first + 1; last < vsize &&
+           a[last]->fConfidence == a[first]->fConfidence; ++last );
+    for(int i = first; i < last; i++ ) {
+      int min = i;
+      for( int j = i+1; j < last; j++)
+        if (*a[j] < *a[min]) min = j;       
+      AnswerHolder * t = a[min]; a[min] = a[i]; a[i] = t;
+    }
+  }
+    
+  // go through the answers and setup lastresult structure
+  int nbestIndex = 0;
+  bool isAmbigous = false;
+  for( int i = 0; i < vsize; i++) {
+    if( nbestIndex == 0 ) {
+      // create the result structure at first element
+      translator.EvaluateExpression(L"application.lastresult$ = "
+                                    L"new Array();");
+      bestAnswer = a[i]->answerElement;
+    }                 
+
+    if( !SetUpNBestList(&nbestIndex, &isAmbigous, log, translator, *a[i]))
+      return -1;
+
+    // check for maxnbest, if there is ambiguity, ignore maxnbest
+    // and setup appropriate nbest list
+    if( nbestIndex > maxnbest -1 ) break;
+  }     
+  return 0;
+}
+
 // This function converts an NLSML result into ECMAScript.
 //
 int AnswerParser::ProcessNLSML(SimpleLogger & log,
@@ -570,7 +931,7 @@ int AnswerParser::ProcessNLSML(SimpleLogger & log,
   // (2) <interpretation> elements
 
   int nbest = -1;
-  ANSWERHOLDERMAP answerMap;
+  ANSWERHOLDERVECTOR answers;
 
   for (DOMNode * temp2 = result->getFirstChild(); temp2 != NULL;
        temp2 = temp2->getNextSibling())
@@ -638,6 +999,12 @@ int AnswerParser::ProcessNLSML(SimpleLogger & log,
       }
     }
 
+    if (input == NULL) {
+      log.LogDiagnostic(0, L"AnswerParser: an <interpretation> must contain "
+                        L"an <input> element");
+      return -1;
+    }
+
     // (3.1.5) Get the input mode.
     const XMLCh * mode = input->getAttribute(ATTR_MODE);
     if (mode == NULL || mode[0] == 0) mode = DEFAULT_MODE;
@@ -732,21 +1099,9 @@ int AnswerParser::ProcessNLSML(SimpleLogger & log,
     // set the answer element here
     newanswer.answerElement = answerElement;
     
-    // find the current confidence in answer map
-    ANSWERHOLDERMAP::iterator mit = answerMap.find(vConfidence);
-    AnswerHolder *newAnswerPtr = NULL;
-    // insert answer with confidence sorted in order
-    if( mit == answerMap.end()) {
-      // this score is first one in this list, create it
-      ANSWERHOLDERVECTOR newlist;
-      newlist.push_back(newanswer);
-      answerMap[vConfidence] = newlist;
-      newAnswerPtr = &(answerMap[vConfidence].back());
-    } 
-    else {      
-      (*mit).second.push_back(newanswer);
-      newAnswerPtr = &((*mit).second.back());     
-    }         
+    // add the answer, SetUpLastResult sorts them by confidence
+    answers.push_back(newanswer);
+    AnswerHolder *newAnswerPtr = &(answers.back());
 
     // (4) Look at each <instance>.
     //
@@ -800,51 +1155,122 @@ int AnswerParser::ProcessNLSML(SimpleLogger & log,
     }
   }
 
-  // Setting up the lastresult$ structure
-  ANSWERHOLDERMAP::iterator it = answerMap.begin();
-  if( it == answerMap.end() ) {
-    // something is wrong, return error
-    log.LogDiagnostic(0, L"AnswerParser: the result structure is corrupted");                         
-    return -1;
-  }
-  else {    
-    // go through the vector and sort its precedence using selection sort
-    for( it = answerMap.begin(); it != answerMap.end(); ++it ) {
-      ANSWERHOLDERVECTOR & a = (*it).second;
-      int vsize = a.size();
-      if( vsize <= 1 ) continue;
-      for(int i = 0; i < vsize; i++ ) {
-        int min = i;
-        for( int j = i+1; j < vsize; j++)
-          if (a[j] < a[min]) min = j;       
-        AnswerHolder t = a[min]; a[min] = a[i]; a[i] = t;
-      }
+  return SetUpLastResult(log, translator, maxnbest, answers, bestAnswer);
+}
+
+
+// This function converts the interpretations read by NLSMLHandler into
+// ECMAScript, the same way ProcessNLSML does from the DOM.
+//
+int AnswerParser::ProcessResult(SimpleLogger & log,
+                                AnswerTranslator & translator,
+                                GrammarManager & gm, int maxnbest,
+                                VXMLElement & bestAnswer)
+{
+  int nbest = -1;
+  ANSWERHOLDERVECTOR answers;
+  answers.reserve(nlsmlHandler->GetCount());
+
+  for (unsigned int i = 0; i < nlsmlHandler->GetCount(); ++i) {
+    // (1) Anything malformed before this <interpretation>?
+    const VXIchar * error = nlsmlHandler->GetError(i);
+    if (error != NULL) {
+      log.LogDiagnostic(0, error);
+      return -1;
     }
-    
-    // go through the vector and setup lastresult structure
-    int nbestIndex = 0;
-    bool done = false, isAmbigous = false;
-    for( it = answerMap.begin(); !done && it != answerMap.end(); ++it ) {
-      ANSWERHOLDERVECTOR & a = (*it).second;
-      int vsize = a.size();
-      for( int i = 0; !done && i < vsize; i++) {
-        if( nbestIndex == 0 ) {
-          // create the result structure at first element
-          translator.EvaluateExpression(L"application.lastresult$ = "
-                                        L"new Array();");
-          bestAnswer = a[i].answerElement;
-        }                 
 
-        if( !SetUpNBestList(&nbestIndex, &isAmbigous, log, translator, a[i]))
-          return -1;
+    const NLSMLInterpretation & interp = nlsmlHandler->Get(i);
+    if (interp.error != NULL) {
+      log.LogDiagnostic(0, interp.error);
+      return -1;
+    }
+    if (!interp.hasInput) {
+      log.LogDiagnostic(0, L"AnswerParser: an <interpretation> must contain "
+                        L"an <input> element");
+      return -1;
+    }
+
+    // (2) Get the input mode.
+    const XMLCh * mode = interp.mode.c_str();
+    if (interp.mode.empty()) mode = DEFAULT_MODE;
+
+    // (3) Is this an event?  See ProcessNLSML for the nbest checks.
+    switch (interp.event) {
+    case NLSMLInterpretation::NOINPUT_EVENT:
+      if (nbest == -1) return 1;
+      return 0; // Ignore this and subsequent interpretations.
+    case NLSMLInterpretation::NOMATCH_EVENT:
+      //special case of setting lastresult$ input mode
+      translator.EvaluateExpression(L"application.lastresult$ = "
+                                    L"new Array();");
+      translator.EvaluateExpression(L"application.lastresult$[0] = new Object();");
+
+      if (Compare(mode, DEFAULT_MODE))
+        translator.SetString(L"application.lastresult$[0].inputmode", L"voice");
+      else
+        translator.SetString(L"application.lastresult$[0].inputmode", XMLChToVXIchar(mode).c_str());
+
+      if (nbest == -1) return 2;
+      return 0; // Ignore this and subsequent interpretations.
+    case NLSMLInterpretation::INVALID_EVENT:
+      log.LogDiagnostic(0, L"AnswerParser: Only <noinput> and <nomatch> "
+                        L"elements or PCDATA is allowed in an <input>");
+      return -1;
+    default:
+      break;
+    }
+
+    if (interp.inputText.empty()) {
+      log.LogDiagnostic(0, L"AnswerParser: <input> element may not be empty");
+      return -1;
+    }
+
+    // (4) Get the confidence.
+    const XMLCh * confidence = interp.inputConfidence.c_str();
+    if (interp.inputConfidence.empty())
+      confidence = interp.confidence.c_str();
+    if (confidence[0] == 0)
+      confidence = DEFAULT_CONFIDENCE;
 
-        // check for maxnbest, if there is ambiguity, ignore maxnbest
-        // and setup appropriate nbest list
-        if( isAmbigous && nbestIndex > maxnbest-1 ) done = true;
-        else if( nbestIndex > maxnbest -1 ) done = true;
-      }       
-    }     
+    VXIflt32 vConfidence = 0.5;
+    std::basic_stringstream<VXIchar> confStream(XMLChToVXIchar(confidence).c_str());
+    confStream >> vConfidence;    
+
+    // (5) Find the grammar of this answer.
+    answers.push_back(AnswerHolder(interp.inputText.c_str(), mode,
+                                   interp.grammar.c_str(), confidence,
+                                   vConfidence, gm));
+    AnswerHolder & answer = answers.back();
+
+    VXMLElement answerElement;
+    if (!gm.FindMatchedElement(XMLChToVXIchar(answer.grammarid).c_str(), 
+                               answerElement, answer.grammarInfo) ||
+        answerElement == 0)
+    {
+      // No match found!
+      log.LogError(433);
+      return 2;
+    }
+    answer.answerElement = answerElement;
+
+    // (6) Each <instance>; the input text stands in for an empty one.
+    for (unsigned int j = 0; j < interp.instanceCount; ++j) {
+      ++nbest;
+      if (interp.instances[j].hasData)
+        answer.SetInstanceText(interp.instances[j].text.c_str());
+      else
+        answer.SetInstance(answer.utterance);
+    }
+    if (interp.instanceCount == 0)
+      answer.SetInstance(answer.utterance);
   }
-  return 0;
-}
 
+  // (7) Anything malformed after the last <interpretation>?
+  const VXIchar * error = nlsmlHandler->GetError(nlsmlHandler->GetCount());
+  if (error != NULL) {
+    log.LogDiagnostic(0, error);
+    return -1;
+  }
+
+  return SetUpLastResult(log, translator, maxnbest, answers, bestAnswer);
+}
@@ -26,6 +26,7 @@
 
 #include "VXItypes.h"
 #include <parsers/XercesDOMParser.hpp>
+#include <parsers/SAXParser.hpp>
 
 extern "C" struct VXIContent;
 extern "C" struct VXIValue;
@@ -54,7 +55,9 @@ public:
   };
 
   /**
-   * Parses a NLSML recognition result.
+   * Parses a NLSML recognition result.  The result is read in a single
+   * streaming pass; a DOM is only built when an <instance> holds XML.
+   * The parser may be reused for any number of results.
    */
   ParseResult Parse(SimpleLogger & log, AnswerTranslator &, GrammarManager &, int, VXIContent *, VXMLElement &);
 
@@ -68,10 +71,22 @@ private:
   //           2 Success - nomatch event
   int ProcessNLSML(SimpleLogger & log, AnswerTranslator &, GrammarManager &, int, VXMLElement &);
 
+  // Same as ProcessNLSML, from the interpretations the streaming pass
+  // collected.
+  int ProcessResult(SimpleLogger & log, AnswerTranslator &, GrammarManager &, int, VXMLElement &);
+
+  void CreateDOMParser();
+
   bool IsAllWhiteSpace(const XMLCh* str);
 
+  AnswerParser(const AnswerParser &);             // not implemented
+  AnswerParser & operator=(const AnswerParser &); // not implemented
+
 private:
-  xercesc::XercesDOMParser * nlsmlParser;
+  class NLSMLHandler;
+  NLSMLHandler             * nlsmlHandler;
+  xercesc::SAXParser       * nlsmlSaxParser;
+  xercesc::XercesDOMParser * nlsmlParser;    // created on first XML instance
 };
 
 #endif
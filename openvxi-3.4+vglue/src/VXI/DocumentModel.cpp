@@ -178,12 +178,14 @@ public:
   ATTRIBUTES attributes;
   CHILDREN   children;
   DocumentLevel docLevel;
+  VXMLStaticSSML * staticSSML;          // owned, static <prompt>s only
   
   DocumentLevel GetDocumentLevel() const { return docLevel; }
   bool GetAttribute(VXMLAttributeType key, vxistring & attr) const;
 
   VXMLElementRef(const VXMLNodeRef * p, VXMLElementType n, DocumentLevel dlevel)
-    : VXMLNodeRef(p, VXMLNode::Type_VXMLElement), name(n), docLevel(dlevel)
+    : VXMLNodeRef(p, VXMLNode::Type_VXMLElement), name(n), docLevel(dlevel),
+      staticSSML(NULL)
     {
 #ifdef VGMEMLOG
 	if (voiceglue_loglevel() >= LOG_DEBUG)
@@ -198,6 +200,7 @@ public:
     }
 
   virtual ~VXMLElementRef() {
+    delete staticSSML;
     for (CHILDREN::iterator i = children.begin(); i != children.end(); ++i)
     {
 #ifdef VGMEMLOG
@@ -239,6 +242,128 @@ bool VXMLElementRef::GetAttribute(VXMLAttributeType key,
   return false;
 }
 
+//#############################################################################
+// Static prompts
+
+void VXMLStaticSSML::AppendAttribute(vxistring & sofar, const VXIchar * name,
+                                     const vxistring & value)
+{
+  sofar += L' ';
+  sofar += name;
+  sofar += L"=\"";
+
+  // We need to escape three characters: (",<,&) -> (&quot;, &lt;, &amp;)
+  vxistring::size_type start = 0, pos;
+  while ((pos = value.find_first_of(L"\"<&", start)) != vxistring::npos) {
+    sofar.append(value, start, pos - start);
+    switch (value[pos]) {
+    case '\"':   sofar += L"&quot;";    break;
+    case '<':    sofar += L"&lt;";      break;
+    case '&':    sofar += L"&amp;";     break;
+    }
+    start = pos + 1;
+  }
+  sofar.append(value, start, vxistring::npos);
+
+  sofar += L"\"";
+}
+
+
+// The <audio> attributes which PromptManager takes from properties when the
+// document does not give them, in VXMLStaticSSML::Slot order.
+static const VXMLAttributeType SLOT_ATTRIBUTES[] = {
+  ATTRIBUTE_FETCHTIMEOUT,
+  ATTRIBUTE_FETCHHINT,
+  ATTRIBUTE_MAXAGE,
+  ATTRIBUTE_MAXSTALE
+};
+
+static const VXIchar * const SLOT_NAMES[] = {
+  L"fetchtimeout",
+  L"fetchhint",
+  L"maxage",
+  L"maxstale"
+};
+
+
+// This follows PromptManager::ProcessSegments for the content and <audio>
+// it renders the same way every time.  Returns false for anything else.
+static bool RenderStaticSSML(const VXMLNodeRef * node, VXMLStaticSSML & ssml,
+                             vxistring & ssmlHeader)
+{
+  // (1) Content.
+  if (node->GetType() == VXMLNode::Type_VXMLContent) {
+    const VXMLContentRef * content = static_cast<const VXMLContentRef *>(node);
+    bool empty = ssml.slots.empty() && ssml.text.back().empty();
+    if (empty && ssmlHeader.empty())
+      ssmlHeader = content->data.substr(0, content->ssmlHeaderLen);
+
+    // A prompt holding only the SSML header and trailer is empty.  Any
+    // <audio> makes the prompt longer than its header.
+    if (content->data == L"</speak>" && ssml.slots.empty() &&
+        ssml.text.back().length() <= ssmlHeader.length())
+      ssml.text.back().erase();
+    else
+      ssml.text.back() += content->data;
+    return true;
+  }
+
+  // (2) <audio> with a fixed src.
+  const VXMLElementRef * elem = static_cast<const VXMLElementRef *>(node);
+  vxistring attr;
+  if (elem->name != NODE_AUDIO || elem->GetAttribute(ATTRIBUTE_EXPR, attr))
+    return false;
+
+  ssml.text.back() += L"<audio";
+  elem->GetAttribute(ATTRIBUTE_SRC, attr);
+  VXMLStaticSSML::AppendAttribute(ssml.text.back(), L"src", attr);
+
+  for (int i = VXMLStaticSSML::SLOT_FETCHTIMEOUT;
+       i <= VXMLStaticSSML::SLOT_MAXSTALE; ++i)
+  {
+    if (elem->GetAttribute(SLOT_ATTRIBUTES[i], attr) && !attr.empty())
+      VXMLStaticSSML::AppendAttribute(ssml.text.back(), SLOT_NAMES[i], attr);
+    else {
+      ssml.slots.push_back(VXMLStaticSSML::Slot(i));
+      ssml.text.push_back(vxistring());
+    }
+  }
+
+  // Add in the alternate text (if any).
+  if (elem->children.empty()) {
+    ssml.text.back() += L"/>";
+    return true;
+  }
+
+  ssml.text.back() += L">";
+  for (VXMLElementRef::CHILDREN::const_iterator i = elem->children.begin();
+       i != elem->children.end(); ++i)
+    if (!RenderStaticSSML(*i, ssml, ssmlHeader)) return false;
+  ssml.text.back() += L"</audio>";
+  return true;
+}
+
+
+static void CompileStaticPrompt(VXMLElementRef & prompt)
+{
+  VXMLStaticSSML * ssml = new VXMLStaticSSML();
+  if (ssml == NULL) throw VXMLDocumentModel::OutOfMemory();
+  ssml->text.push_back(vxistring());
+
+  vxistring ssmlHeader;
+  for (VXMLElementRef::CHILDREN::const_iterator i = prompt.children.begin();
+       i != prompt.children.end(); ++i)
+  {
+    if (!RenderStaticSSML(*i, *ssml, ssmlHeader)) {
+      delete ssml;
+      return;
+    }
+  }
+
+  delete prompt.staticSSML;
+  prompt.staticSSML = ssml;
+}
+
 //#############################################################################
 
 class VXMLNodeIteratorData {
@@ -566,6 +691,12 @@ void VXMLDocumentRep::EndElement()
   if (pos == NULL)
     throw VXMLDocumentModel::InternalError();
 
+  // Render prompts which need nothing at runtime now, once.
+  if (pos->GetType() == VXMLNode::Type_VXMLElement) {
+    VXMLElementRef * elem = static_cast<VXMLElementRef *>(pos);
+    if (elem->name == NODE_PROMPT) CompileStaticPrompt(*elem);
+  }
+
   posType = pos->GetType();
   pos = const_cast<VXMLNodeRef *>(pos->GetParent());
 }
@@ -809,6 +940,14 @@ DocumentLevel VXMLElement::GetDocumentLevel() const
 }
 
 
+const VXMLStaticSSML * VXMLElement::GetStaticSSML() const
+{
+  if (internals == NULL) return NULL;
+  const VXMLElementRef * ref = static_cast<const VXMLElementRef *>(internals);
+  return ref->staticSSML;
+}
+
+
 //#############################################################################
 
 // This code is NOT sensitive to possible byte order differences....  This is
@@ -25,6 +25,7 @@
 
 #include "VXIvalue.h"
 #include "VXML.h"
+#include <vector>
 
 class VXMLElement;
 class VXMLNodeRef;
@@ -104,6 +105,27 @@ private: // not implemented
 };
 
 
+// The SSML of a <prompt> whose content needs nothing at runtime, rendered
+// when the document is built.  The <audio> fetch attributes which the
+// document leaves to properties are slots, filled in when it is queued.
+class VXMLStaticSSML {
+public:
+  enum Slot {
+    SLOT_FETCHTIMEOUT,
+    SLOT_FETCHHINT,
+    SLOT_MAXAGE,
+    SLOT_MAXSTALE
+  };
+
+  std::vector<vxistring> text;    // text[i] comes before slots[i]
+  std::vector<Slot>      slots;   // one less than text
+
+  // Appends name="value" with the value escaped for SSML.
+  static void AppendAttribute(vxistring & sofar, const VXIchar * name,
+                              const vxistring & value);
+};
+
+
 class VXMLContent : public VXMLNode {
 public:
   virtual ~VXMLContent() { }
@@ -134,6 +156,9 @@ public: // Creation & comparison functions
   bool GetAttribute(VXMLAttributeType key, vxistring & attr) const;
   DocumentLevel GetDocumentLevel() const;
 
+  // Returns the rendered SSML of a static <prompt>, or NULL.
+  const VXMLStaticSSML * GetStaticSSML() const;
+
 private:
   VXMLElement & operator=(const VXMLNode &);
 };
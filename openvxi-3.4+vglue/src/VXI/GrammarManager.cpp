@@ -30,6 +30,8 @@
 #include "DocumentModel.hpp"
 #include <sstream>
 
+#include <vglue_tostring.h>
+
 //#############################################################################
 // Grammar description class
 //#############################################################################
@@ -39,6 +41,9 @@ const VXIchar * const GrammarManager::FinalSilence  = L"@finalsilence";
 const VXIchar * const GrammarManager::MaxTime       = L"@maxtime";
 const VXIchar * const GrammarManager::RecordingType = L"@rectype";
 
+// Most <option> grammars one GrammarManager keeps loaded between documents.
+static const unsigned int MAX_OPTION_GRAMMARS = 64;
+
 enum GrammarScope {
   GRS_NONE,
   GRS_FIELD,
@@ -69,9 +74,16 @@ public:
   bool IsDynamic() const                   { return !srcexpr.empty(); }
   bool IsScope(GrammarScope s) const       { return s == scope; }
 
+  // A kept grammar belongs to GrammarManager::optionGrammars.
+  void SetKept(bool b)                     { kept = b; }
+  bool IsKept() const                      { return kept; }
+
   bool IsField(const vxistring & f) const  { return f == field; }
   bool IsDialog(const vxistring & d) const { return d == dialog; }
   bool IsDoc(const vxistring & d) const    { return d == docID; }
+  const vxistring & GetField() const       { return field; }
+  const vxistring & GetDialog() const      { return dialog; }
+  const vxistring & GetDocID() const       { return docID; }
   void GetElement(VXMLElement & e) const   { e = element; }
 
   const VXIchar *GetSrcExpr() const { return srcexpr.c_str(); }
@@ -90,6 +102,7 @@ private:
   vxistring         srcexpr;
   vxistring         mimetype;
   bool              enabled;
+  bool              kept;
 
   // store current activated info to determine precedence
   GrammarScope      activatedScope;
@@ -103,6 +116,7 @@ GrammarInfo::GrammarInfo(VXIrecGrammar * g,
                          unsigned long gSeq,
 						 const VXIchar *expr, const VXIchar *mime)
     : element(elem), recgrammar(g), scope(GRS_NONE), docID(id), enabled(false),
+      kept(false),
       srcexpr(expr?expr:L""), mimetype(mime?mime:L""), activatedScope(GRS_NONE), 
       grammarSeq(gSeq)
 {
@@ -198,7 +212,7 @@ private:
 //#############################################################################
 
 GrammarManager::GrammarManager(VXIrecInterface * r, const SimpleLogger & l)
-  : log(l), vxirec(r), grammarSequence(0)
+  : log(l), vxirec(r), grammarSequence(0), optionGrammarUses(0)
 {
 }
 
@@ -206,6 +220,13 @@ GrammarManager::GrammarManager(VXIrecInterface * r, const SimpleLogger & l)
 GrammarManager::~GrammarManager()
 {
   ReleaseGrammars();
+
+  for (KEPTGRAMMARS::iterator i = optionGrammars.begin();
+       i != optionGrammars.end(); ++i)
+  {
+    VXIrecGrammar * grammar = (*i).second.grammar;
+    vxirec->FreeGrammar(vxirec, &grammar);
+  }
 }
 
 void GrammarManager::ThrowSpecificEventError(VXIrecResult err, OpType opType)
@@ -777,105 +798,164 @@ void GrammarManager::BuildOptionGrammars(const vxistring & documentID,
 {
   log.LogDiagnostic(2, L"GrammarManager::BuildOptionGrammars()");
 
-  // (1) Create new vectors to hold the grammar.
+  // (1) Get each option.
 
-  VXIVectorHolder speechUtts;
-  VXIVectorHolder speechVals;
-  VXIVectorHolder dtmfUtts;
-  VXIVectorHolder dtmfVals;
-  VXIVectorHolder gramAcceptanceAttrs;
-
-  if (speechUtts.GetValue() == NULL || speechVals.GetValue() == NULL ||
-      dtmfUtts.GetValue()   == NULL || dtmfVals.GetValue()   == NULL ||
-      gramAcceptanceAttrs.GetValue() == NULL)
-    throw VXIException::OutOfMemory();
-
-  // (2) Get each option.
+  OPTIONS options;
 
   for (VXMLNodeIterator it(element); it; ++it) {
     VXMLNode child = *it;
 
-    // (2.1) Ignore anything which isn't an option.
+    // (1.1) Ignore anything which isn't an option.
 
     if (child.GetType() != VXMLNode::Type_VXMLElement) continue;
     VXMLElement & domElem = reinterpret_cast<VXMLElement &>(child);
     if (domElem.GetName() != NODE_OPTION) continue;
 
-    // (2.2) Get attributes and CDATA.
-
-    vxistring value;
-    domElem.GetAttribute(ATTRIBUTE_VALUE, value);
+    // (1.2) Get attributes and CDATA.
 
-    vxistring dtmf;
-    domElem.GetAttribute(ATTRIBUTE_DTMF, dtmf);
+    Option option;
+    domElem.GetAttribute(ATTRIBUTE_VALUE, option.value);
+    domElem.GetAttribute(ATTRIBUTE_DTMF, option.dtmf);
 
     vxistring accept;
     domElem.GetAttribute(ATTRIBUTE_ACCEPT, accept);
+    option.approximate = (accept == L"approximate");
 
-    vxistring text;
-    GrammarManager::GetEnclosedText(log, domElem, text);
+    GrammarManager::GetEnclosedText(log, domElem, option.text);
 
-    if (value.empty()) value = text;
-    if (value.empty()) value = dtmf;
+    if (option.value.empty()) option.value = option.text;
+    if (option.value.empty()) option.value = option.dtmf;
 
-    // (2.3) Add to vectors as appropriate.
+    if (!option.text.empty() || !option.dtmf.empty())
+      options.push_back(option);
+  }
 
-    if (!text.empty()) {
-      VXIVectorAddElement(speechUtts.GetValue(),
-         reinterpret_cast<VXIValue *>(VXIStringCreate(text.c_str())));
-      VXIVectorAddElement(speechVals.GetValue(),
-         reinterpret_cast<VXIValue *>(VXIStringCreate(value.c_str())));
-    }
+  if (options.empty()) return;
 
-    if (!dtmf.empty()) {
-      VXIVectorAddElement(dtmfUtts.GetValue(),
-         reinterpret_cast<VXIValue *>(VXIStringCreate(dtmf.c_str())));
-      VXIVectorAddElement(dtmfVals.GetValue(),
-         reinterpret_cast<VXIValue *>(VXIStringCreate(value.c_str())));
+  // (2) Options hold no expressions, so the same field with the same
+  //     properties always gives the same grammars.
+
+  vxistring field;
+  element.GetAttribute(ATTRIBUTE__ITEMNAME, field);
+
+  vxistring key(documentID);
+  key += L'\n';
+  key += field;
+  key += L'\n';
+  key += Std_String_to_vxistring(VXIValue_to_Std_String(
+                   reinterpret_cast<const VXIValue *>(props.GetValue())));
+  for (OPTIONS::const_iterator i = options.begin(); i != options.end(); ++i) {
+    key += L'\n';
+    key += (*i).text;
+    key += L'\t';
+    key += (*i).dtmf;
+    key += L'\t';
+    key += (*i).value;
+    key += ((*i).approximate ? L"\ta" : L"\te");
+  }
+
+  // (3) Add grammars.
+
+  AddOptionGrammar(documentID, element, props, options, key, false);
+  AddOptionGrammar(documentID, element, props, options, key, true);
+
+  log.LogDiagnostic(2, L"GrammarManager::BuildOptionGrammar - end");
+}
+
+
+void GrammarManager::AddOptionGrammar(const vxistring & documentID,
+                                      const VXMLElement & element,
+                                      const VXIMapHolder & props,
+                                      const OPTIONS & options,
+                                      const vxistring & baseKey,
+                                      bool isDTMF)
+{
+  // (1) Reuse the grammar kept from an earlier visit.
+
+  vxistring key(baseKey);
+  key += (isDTMF ? L"\ndtmf" : L"\nspeech");
+
+  KEPTGRAMMARS::iterator kept = optionGrammars.find(key);
+  if (kept != optionGrammars.end() && !(*kept).second.inUse) {
+    if (log.IsLogging(2)) {
+      log.StartDiagnostic(2) << L"GrammarManager::AddOptionGrammar - reusing "
+                             << (*kept).second.grammar;
+      log.EndDiagnostic();
     }
 
-    if( !text.empty() || !dtmf.empty() )
-    {
-      if (!accept.empty() && accept == L"approximate") {
-        VXIVectorAddElement(gramAcceptanceAttrs.GetValue(),
-          reinterpret_cast<VXIValue *>(VXIIntegerCreate(1)));
-        } else {
-          VXIVectorAddElement(gramAcceptanceAttrs.GetValue(),
-            reinterpret_cast<VXIValue *>(VXIIntegerCreate(0)));
-        }
+    (*kept).second.inUse = true;
+    (*kept).second.lastUsed = ++optionGrammarUses;
+    AddGrammar((*kept).second.grammar, documentID, element);
+    grammars.back()->SetKept(true);
+    return;
+  }
+
+  // (2) Create new vectors to hold the grammar.
+
+  VXIVectorHolder utts;
+  VXIVectorHolder vals;
+  VXIVectorHolder gramAcceptanceAttrs;
+
+  if (utts.GetValue() == NULL || vals.GetValue() == NULL ||
+      gramAcceptanceAttrs.GetValue() == NULL)
+    throw VXIException::OutOfMemory();
+
+  for (OPTIONS::const_iterator i = options.begin(); i != options.end(); ++i) {
+    const vxistring & utt = (isDTMF ? (*i).dtmf : (*i).text);
+    if (!utt.empty()) {
+      VXIVectorAddElement(utts.GetValue(),
+         reinterpret_cast<VXIValue *>(VXIStringCreate(utt.c_str())));
+      VXIVectorAddElement(vals.GetValue(),
+         reinterpret_cast<VXIValue *>(VXIStringCreate((*i).value.c_str())));
     }
 
+    // The acceptance list covers every option, speech or DTMF.
+    VXIVectorAddElement(gramAcceptanceAttrs.GetValue(),
+      reinterpret_cast<VXIValue *>(VXIIntegerCreate((*i).approximate ? 1 : 0)));
   }
 
-  // (3) Add grammars.
+  if (VXIVectorLength(utts.GetValue()) == 0) return;
+
+  // (3) Load the grammar.
 
   VXIrecGrammar * grammar;
+  VXIrecResult err = vxirec->LoadGrammarOption(vxirec, props.GetValue(),
+                                               utts.GetValue(),
+                                               vals.GetValue(),
+                                               gramAcceptanceAttrs.GetValue(),
+                                               isDTMF ? TRUE : FALSE, &grammar);
+  if( err != VXIrec_RESULT_SUCCESS )
+    ThrowSpecificEventError(err, GRAMMAR);
 
-  if (VXIVectorLength(speechUtts.GetValue()) > 0) {
-    VXIrecResult err = vxirec->LoadGrammarOption(vxirec, props.GetValue(),
-                                                 speechUtts.GetValue(),
-                                                 speechVals.GetValue(),
-                                                 gramAcceptanceAttrs.GetValue(),
-                                                 FALSE, &grammar);
-    if( err != VXIrec_RESULT_SUCCESS )
-      ThrowSpecificEventError(err, GRAMMAR);
+  AddGrammar(grammar, documentID, element);
 
-    AddGrammar(grammar, documentID, element);
-  }
+  // (4) Keep it for the next visit.  If this key is already held (the same
+  //     document loaded twice) the new grammar is simply not kept.
 
-  if (VXIVectorLength(dtmfUtts.GetValue()) > 0) {
-    VXIrecResult err = vxirec->LoadGrammarOption(vxirec, props.GetValue(),
-                                                 dtmfUtts.GetValue(),
-                                                 dtmfVals.GetValue(),
-                                                 gramAcceptanceAttrs.GetValue(),
-                                                 TRUE, &grammar);
-    if( err != VXIrec_RESULT_SUCCESS )
-      ThrowSpecificEventError(err, GRAMMAR);
+  if (kept != optionGrammars.end()) return;
+
+  if (optionGrammars.size() >= MAX_OPTION_GRAMMARS) {
+    KEPTGRAMMARS::iterator oldest = optionGrammars.end();
+    for (KEPTGRAMMARS::iterator i = optionGrammars.begin();
+         i != optionGrammars.end(); ++i)
+    {
+      if ((*i).second.inUse) continue;
+      if (oldest == optionGrammars.end() ||
+          (*i).second.lastUsed < (*oldest).second.lastUsed)
+        oldest = i;
+    }
+    if (oldest == optionGrammars.end()) return;
 
-    AddGrammar(grammar, documentID, element);
+    VXIrecGrammar * old = (*oldest).second.grammar;
+    vxirec->FreeGrammar(vxirec, &old);
+    optionGrammars.erase(oldest);
   }
 
-  log.LogDiagnostic(2, L"GrammarManager::BuildOptionGrammar - end");
+  KeptGrammar & entry = optionGrammars[key];
+  entry.grammar = grammar;
+  entry.inUse = true;
+  entry.lastUsed = ++optionGrammarUses;
+  grammars.back()->SetKept(true);
 }
 
 
@@ -970,6 +1050,17 @@ void GrammarManager::AddGrammar(VXIrecGrammar * gr,
   }
 
   grammars.push_back(gp);
+
+  // File the new grammar under every selection it can take part in.
+  GRAMMARS::size_type pos = grammars.size() - 1;
+  if (gp->IsScope(GRS_DOC))
+    docScopeGrammars.push_back(pos);
+
+  DialogIndex & dialog = grammarIndex[gp->GetDocID()][gp->GetDialog()];
+  if (gp->IsScope(GRS_DIALOG))
+    dialog.dialogScope.push_back(pos);
+  if (!gp->GetField().empty())
+    dialog.fields[gp->GetField()].push_back(pos);
 }
 
 
@@ -1044,11 +1135,16 @@ void GrammarManager::ReleaseGrammars()
 
       if (gp->IsEnabled())
         vxirec->DeactivateGrammar(vxirec, grammar);
-      vxirec->FreeGrammar(vxirec, &grammar);
+      if (!gp->IsKept())
+        vxirec->FreeGrammar(vxirec, &grammar);
       delete gp;
     }
   }
 
+  for (KEPTGRAMMARS::iterator i = optionGrammars.begin();
+       i != optionGrammars.end(); ++i)
+    (*i).second.inUse = false;
+
   while (!universals.empty()) {
     GrammarInfoUniv * gp = universals.back();
     universals.pop_back();
@@ -1063,6 +1159,9 @@ void GrammarManager::ReleaseGrammars()
     vxirec->FreeGrammar(vxirec, &grammar);
     delete gp;
   }
+
+  grammarIndex.clear();
+  docScopeGrammars.clear();
 }
 
 
@@ -1083,16 +1182,45 @@ bool GrammarManager::EnableGrammars(const vxistring & documentID,
   // (1) Do ordinary grammars...
   // They are activated in reverse order.  This should activate them
   // in the order of precedence the VXMl spec dictates (3.1.4)
-  for (GRAMMARS::iterator i = grammars.end(); i != grammars.begin();)
+
+  // (1.1) Look up the candidates: grammars of this field, dialog scoped
+  //       grammars of this dialog, and document scoped grammars if not modal.
+  const GRAMMARINDEX none;
+  const GRAMMARINDEX * fieldList  = &none;
+  const GRAMMARINDEX * dialogList = &none;
+  const GRAMMARINDEX * docList    = (isModal ? &none : &docScopeGrammars);
+
+  DOCINDEX::const_iterator d = grammarIndex.find(documentID);
+  if (d != grammarIndex.end()) {
+    DIALOGINDEX::const_iterator g = (*d).second.find(dialogName);
+    if (g != (*d).second.end()) {
+      if (!isModal) dialogList = &(*g).second.dialogScope;
+      if (!fieldName.empty()) {
+        FIELDINDEX::const_iterator f = (*g).second.fields.find(fieldName);
+        if (f != (*g).second.fields.end()) fieldList = &(*f).second;
+      }
+    }
+  }
+
+  // (1.2) Merge the three lists from the back, visiting each grammar once.
+  GRAMMARINDEX::size_type nf = fieldList->size();
+  GRAMMARINDEX::size_type ng = dialogList->size();
+  GRAMMARINDEX::size_type nd = docList->size();
+  while (nf > 0 || ng > 0 || nd > 0)
   {
-    i--;
-
-    bool docsMatch    = (*i)->IsDoc(documentID);
-    bool dialogsMatch = docsMatch    && (*i)->IsDialog(dialogName);
-    bool fieldsMatch  = dialogsMatch && (*i)->IsField(fieldName);
-    bool fieldGram = (!fieldName.empty() && fieldsMatch);
-    bool dialogGram = (!isModal && (*i)->IsScope(GRS_DIALOG) && dialogsMatch);
-    bool docGram = (!isModal && (*i)->IsScope(GRS_DOC));
+    GRAMMARS::size_type pos = 0;
+    if (nf > 0) pos = (*fieldList)[nf - 1];
+    if (ng > 0 && (*dialogList)[ng - 1] > pos) pos = (*dialogList)[ng - 1];
+    if (nd > 0 && (*docList)[nd - 1] > pos) pos = (*docList)[nd - 1];
+
+    bool fieldGram = (nf > 0 && (*fieldList)[nf - 1] == pos);
+    bool dialogGram = (ng > 0 && (*dialogList)[ng - 1] == pos);
+    bool docGram = (nd > 0 && (*docList)[nd - 1] == pos);
+    if (fieldGram) --nf;
+    if (dialogGram) --ng;
+    if (docGram) --nd;
+
+    GRAMMARS::iterator i = grammars.begin() + pos;
     GrammarScope cScope = GRS_NONE;
 
     if ( fieldGram ||
@@ -28,6 +28,7 @@
 #include "VXIvalue.h"
 #include "Scripter.hpp" 
 #include <vector>
+#include <map>
 
 extern "C" struct VXIrecGrammar;
 extern "C" struct VXIrecInterface;
@@ -149,6 +150,18 @@ private:
 
   void BuildOptionGrammars(const vxistring & docID, const VXMLElement& doc,
                            const VXIMapHolder & props);
+
+  struct Option {
+    vxistring text;
+    vxistring dtmf;
+    vxistring value;
+    bool      approximate;
+  };
+  typedef std::vector<Option> OPTIONS;
+
+  void AddOptionGrammar(const vxistring & docID, const VXMLElement & elem,
+                        const VXIMapHolder & props, const OPTIONS & options,
+                        const vxistring & key, bool isDTMF);
   
   static bool GetEnclosedText(const SimpleLogger & log,
                               const VXMLElement & doc, vxistring & str);
@@ -172,9 +185,36 @@ private:
   typedef std::vector<GrammarInfo *> GRAMMARS;
   GRAMMARS grammars;
 
+  // Positions in 'grammars', in ascending order, filed by AddGrammar under
+  // the document, dialog and field each grammar may be activated for.  This
+  // lets EnableGrammars visit only the candidates instead of comparing the
+  // names of every loaded grammar on every turn.
+  typedef std::vector<GRAMMARS::size_type> GRAMMARINDEX;
+  typedef std::map<vxistring, GRAMMARINDEX> FIELDINDEX;
+  struct DialogIndex {
+    GRAMMARINDEX dialogScope;   // dialog scoped grammars of this dialog
+    FIELDINDEX   fields;        // all grammars of each field in this dialog
+  };
+  typedef std::map<vxistring, DialogIndex> DIALOGINDEX;
+  typedef std::map<vxistring, DIALOGINDEX> DOCINDEX;
+  DOCINDEX grammarIndex;
+  GRAMMARINDEX docScopeGrammars; // document scoped grammars of every document
+
   typedef std::vector<GrammarInfoUniv *> UNIVERSALS;
   UNIVERSALS universals;
 
+  // <option> grammars stay loaded when ReleaseGrammars drops the document,
+  // keyed by document, field, mode, properties and options, so revisiting a
+  // field reuses its grammar instead of loading it through VXIrec again.
+  struct KeptGrammar {
+    VXIrecGrammar * grammar;
+    bool            inUse;      // held by an entry in 'grammars'
+    unsigned long   lastUsed;
+  };
+  typedef std::map<vxistring, KeptGrammar> KEPTGRAMMARS;
+  KEPTGRAMMARS optionGrammars;
+  unsigned long optionGrammarUses;
+
   const SimpleLogger & log;
   VXIrecInterface * vxirec;
   unsigned int grammarSequence;
@@ -100,22 +100,41 @@ inline void AddSSMLAttribute(const VXMLElement & elem, VXMLAttributeType attr,
     attrString = defaultVal;
   }
 
-  sofar += SPACE;
-  sofar += name;
-  sofar += L"=\"";
-
-  // We need to escape three characters: (",<,&) -> (&quot;, &lt;, &amp;)
-  vxistring::size_type pos = 0;
-  while ((pos = attrString.find_first_of(L"\"<&", pos)) != vxistring::npos) {
-    switch (attrString[pos]) {
-    case '\"':   attrString.replace(pos, 1, L"&quot;");    ++pos;  break;
-    case '<':    attrString.replace(pos, 1, L"&lt;");      ++pos;  break;
-    case '&':    attrString.replace(pos, 1, L"&amp;");     ++pos;  break;
-    }
-  };
+  VXMLStaticSSML::AppendAttribute(sofar, name, attrString);
+}
+
+
+// The property and SSML attribute which fill each VXMLStaticSSML::Slot.
+static const VXIchar * const STATIC_SSML_SLOTS[][2] = {
+  { L"fetchtimeout",   L"fetchtimeout" },
+  { L"audiofetchhint", L"fetchhint"    },
+  { L"audiomaxage",    L"maxage"       },
+  { L"audiomaxstale",  L"maxstale"     }
+};
+
 
-  sofar += attrString;
-  sofar += L"\"";
+static void RenderStaticSSML(const VXMLStaticSSML & ssml,
+                             const PropertyList & propertyList,
+                             vxistring & sofar)
+{
+  // Each property is looked up at most once, however many <audio> need it.
+  const int SLOT_COUNT = sizeof(STATIC_SSML_SLOTS) / sizeof(STATIC_SSML_SLOTS[0]);
+  const VXIchar * values[SLOT_COUNT];
+  bool found[SLOT_COUNT];
+  for (int i = 0; i < SLOT_COUNT; ++i) found[i] = false;
+
+  sofar = ssml.text[0];
+  for (unsigned int i = 0; i < ssml.slots.size(); ++i) {
+    int slot = ssml.slots[i];
+    if (!found[slot]) {
+      values[slot] = propertyList.GetProperty(STATIC_SSML_SLOTS[slot][0]);
+      found[slot] = true;
+    }
+    if (values[slot] != NULL)
+      VXMLStaticSSML::AppendAttribute(sofar, STATIC_SSML_SLOTS[slot][1],
+                                      values[slot]);
+    sofar += ssml.text[i + 1];
+  }
 }
 
 
@@ -251,6 +270,10 @@ void PromptManager::Queue(const VXMLElement & elem, const VXMLElement & ref,
 {
   log->LogDiagnostic(2, L"PromptManager::Queue()");
 
+  // Property maps and other values made while queuing are short lived,
+  // allocate them from an arena released when this returns.
+  VXIValueArenaScope arena;
+
   // (1) Find <field> or <menu> associated with this prompt, if any.  This is
   // used by the <enumerate> element.
   VXMLElement item = ref;
@@ -315,12 +338,18 @@ void PromptManager::Queue(const VXMLElement & elem, const VXMLElement & ref,
                      (VXIValue*)VXIStringCreate(bargeinType.c_str())); 
   }
    
-  // (4) Build prompt, recursively handling the contents.
+  // (4) Build prompt, recursively handling the contents.  Prompts holding
+  //     only text and fixed <audio> were rendered when the document was built.
   vxistring content, ssmlHeader;
-  bool hasPromptData = false;
-  for (VXMLNodeIterator it(elem); it; ++it)
-    ProcessSegments(*it, item, propertyList, translator,
-                    bargein, properties, content, ssmlHeader, hasPromptData, replaceXmlBase);
+  const VXMLStaticSSML * staticSSML = elem.GetStaticSSML();
+  if (staticSSML != NULL && !replaceXmlBase)
+    RenderStaticSSML(*staticSSML, propertyList, content);
+  else {
+    bool hasPromptData = false;
+    for (VXMLNodeIterator it(elem); it; ++it)
+      ProcessSegments(*it, item, propertyList, translator,
+                      bargein, properties, content, ssmlHeader, hasPromptData, replaceXmlBase);
+  }
   if (content.empty()) return;
 
   // (5) Add a new segment.
@@ -56,7 +56,8 @@ static vxistring toString(const VXIchar * s)
 
 // ------*---------*---------*---------*---------*---------*---------*---------
 
-PropertyList::PropertyList(const SimpleLogger & l) : log(l)
+PropertyList::PropertyList(const SimpleLogger & l)
+  : flattened(NULL), log(l)
 {
   properties.reserve(LAST_PROP);
   while (properties.size() < LAST_PROP)
@@ -64,28 +65,41 @@ PropertyList::PropertyList(const SimpleLogger & l) : log(l)
 }
 
 
-PropertyList::PropertyList(const PropertyList & p) : log(p.log)
+PropertyList::PropertyList(const PropertyList & p)
+  : flattened(NULL), log(p.log)
 {
   properties = p.properties;
+  VXIValueHeapScope heap;
+  if (p.flattened != NULL) flattened = VXIMapClone(p.flattened);
 }
 
 
 PropertyList& PropertyList::operator=(const PropertyList & x)
 {
   if (this != &x) {
+    Invalidate();
     properties = x.properties;
+    VXIValueHeapScope heap;
+    if (x.flattened != NULL) flattened = VXIMapClone(x.flattened);
   }
 
   return *this;
 }
 
 
+void PropertyList::Invalidate()
+{
+  if (flattened != NULL) VXIMapDestroy(&flattened);
+}
+
+
 const VXIchar* PropertyList::GetProperty(const VXIchar * key,
                                          PropertyLevel L) const
 {
   int pos = L;
   do {
     if (pos == LAST_PROP) --pos;
+    if (properties[pos].empty()) continue;
     STRINGMAP::const_iterator i = properties[pos].find(key);
     if (i != properties[pos].end()) return (*i).second.c_str();
   } while (--pos >= 0);
@@ -101,6 +115,7 @@ bool PropertyList::SetProperty(const VXIchar * key, const VXIchar * value,
 
   STRINGMAP & propmap = properties[level];
   propmap[key] = value;
+  Invalidate();
 
   return true;
 }
@@ -120,6 +135,7 @@ void PropertyList::SetProperties(const VXMLElement & doc, PropertyLevel level,
   }
 
   // (1) Clear all properties at this level and above.
+  Invalidate();
   properties[level].clear();
   STRINGMAP & propmap = properties[level];
 
@@ -598,6 +614,7 @@ bool PropertyList::PushProperties(const VXMLElement & doc)
     }
   }
 
+  if (foundSomething) Invalidate();
   return foundSomething;
 }
 
@@ -610,38 +627,76 @@ void PropertyList::PopProperties()
     if (!properties[i].empty()) break;
 
   // Clear it.
+  if (properties[i].empty()) return;
   properties[i].clear();
+  Invalidate();
 }
 
 void PropertyList::PopPropertyLevel(PropertyLevel l)
 {
   if( l < LAST_PROP && !properties[l].empty()) {
     properties[l].clear();
+    Invalidate();
   }
 }
 
 // This starts at the lowest level, inserting entries into a newly created map.
-// Values at higher levels will overwrite keys with identical names.
+// Values at higher levels will overwrite keys with identical names.  The
+// result is kept until the next change, so prompts and recognitions within
+// one turn share a single copy instead of each rebuilding it.  Since it is
+// usually built within an arena scope yet outlives it, it is taken from the
+// heap so as not to pin an arena chunk.
 //
-void PropertyList::GetProperties(VXIMapHolder & m) const
+const VXIMap * PropertyList::GetFlattenedProperties() const
 {
-  // (1) Collapse the values down into a single map.
-  STRINGMAP collapsed;
+  if (flattened != NULL) return flattened;
+
+  VXIValueHeapScope heap;
+  VXIMapHolder collapsed;
+  if (collapsed.GetValue() == NULL) throw VXIException::OutOfMemory();
+
   PROPERTIES::const_iterator i;
   for (i = properties.begin(); i != properties.end(); ++i) {
     for (STRINGMAP::const_iterator j = (*i).begin(); j != (*i).end(); ++j) {
-      collapsed[(*j).first] = (*j).second;
+      VXIString * value = VXIStringCreate((*j).second.c_str());
+      if (value == NULL) throw VXIException::OutOfMemory();
+
+      // Set this key.
+      VXIMapSetProperty(collapsed.GetValue(), (*j).first.c_str(),
+                        reinterpret_cast<VXIValue *>(value));
     }
   }
 
-  // (2) Create a new map & copy the values over.
-  STRINGMAP::const_iterator j;
-  for (j = collapsed.begin(); j != collapsed.end(); ++j) {
-    VXIString * value = VXIStringCreate((*j).second.c_str());
-    if (value == NULL) throw VXIException::OutOfMemory();
+  flattened = collapsed.Release();
+  return flattened;
+}
+
 
-    // Set this key.
-    VXIMapSetProperty(m.GetValue(), (*j).first.c_str(),
-                      reinterpret_cast<VXIValue *>(value));
+void PropertyList::GetProperties(VXIMapHolder & m) const
+{
+  if (m.GetValue() == NULL) return;
+  const VXIMap * props = GetFlattenedProperties();
+
+  // (1) An empty map can simply share the flattened view.
+  if (VXIMapNumProperties(m.GetValue()) == 0) {
+    VXIMap * copy = VXIMapClone(props);
+    if (copy == NULL) throw VXIException::OutOfMemory();
+    m.Acquire(copy);
+    return;
   }
+
+  // (2) Otherwise copy the values over, replacing existing keys.
+  const VXIchar * key;
+  const VXIValue * value;
+  VXIMapIterator * it = VXIMapGetFirstProperty(props, &key, &value);
+  if (it == NULL) return;
+  do {
+    VXIValue * copy = VXIValueClone(value);
+    if (copy == NULL) {
+      VXIMapIteratorDestroy(&it);
+      throw VXIException::OutOfMemory();
+    }
+    VXIMapSetProperty(m.GetValue(), key, copy);
+  } while (VXIMapGetNextProperty(it, &key, &value) == VXIvalue_RESULT_SUCCESS);
+  VXIMapIteratorDestroy(&it);
 }
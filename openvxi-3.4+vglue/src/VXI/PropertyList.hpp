@@ -89,12 +89,20 @@ public:
   void PopProperties();
   void PopPropertyLevel(PropertyLevel l);
   void GetProperties(VXIMapHolder &) const;
+  // Adds every effective property to the map.  An empty map receives a
+  // clone of the cached flattened view, which shares its storage.
+
+  const VXIMap * GetFlattenedProperties() const;
+  // Returns the effective properties of all levels as a single map of
+  // strings.  The map is built on first use and kept until the next
+  // change to the list; it must not be modified and is only valid until
+  // then.  Use VXIMapClone to keep a copy.
 
   PropertyList& operator=(const PropertyList &);
   PropertyList(const PropertyList &);
 
   PropertyList(const SimpleLogger & l);
-  ~PropertyList() { properties.clear(); }
+  ~PropertyList() { Invalidate(); properties.clear(); }
 
 public:
   static bool ConvertTimeToMilliseconds(const SimpleLogger &,
@@ -120,9 +128,13 @@ public:
   //          false - the value was illegal, result contains the best guess
 
 private:
+  void Invalidate();
+  // Discards the flattened view.
+
   typedef std::map<vxistring, vxistring> STRINGMAP;
   typedef std::vector<STRINGMAP> PROPERTIES;
   PROPERTIES properties;
+  mutable VXIMap * flattened;
   const SimpleLogger & log;
 };
 
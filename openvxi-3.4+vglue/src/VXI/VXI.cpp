@@ -263,6 +263,26 @@ VXI::VXI()
     parser = NULL;
     throw VXIException::OutOfMemory();
   }
+
+  try {
+    answerParser = new AnswerParser();
+  }
+  catch (...) {
+    delete pm;
+    pm = NULL;
+    delete parser;
+    parser = NULL;
+    answerParser = NULL;
+    throw;
+  }
+
+  if (answerParser == NULL) {
+    delete pm;
+    pm = NULL;
+    delete parser;
+    parser = NULL;
+    throw VXIException::OutOfMemory();
+  }
 }
 
 
@@ -274,6 +294,7 @@ VXI::~VXI()
     exe = temp;
   }
 
+  delete answerParser;
   delete pm;
   delete parser;
 }
@@ -3936,6 +3957,10 @@ void VXI::DoRecognition(const VXMLElement & item,
 
 void VXI::do_recognition(VXIMapHolder &properties, const PropertyList & propertyList)
 {
+  // Values made while recognizing and handling the result are short
+  // lived, allocate them from an arena released when this returns.
+  VXIValueArenaScope arena;
+
   // (2) Is the line still active?
   CheckLineStatus();
 
@@ -4008,7 +4033,6 @@ void VXI::ProcessRecognitionResult(
   log->LogDiagnostic(2, L"VXI::ProcessRecognitionResult");
 
   VXIAnswerTranslator translator(exe->script);
-  AnswerParser answerParser;
   vxistring grammarID;
   int maxnbest = 1;
 
@@ -4025,7 +4049,7 @@ void VXI::ProcessRecognitionResult(
 
   // (2) Set application.lastresult$ array.
   VXMLElement answerElement;  // hold best matched answer
-  AnswerParser::ParseResult parseRes = answerParser.Parse(*log, translator, exe->gm, maxnbest, xmlresult, answerElement);
+  AnswerParser::ParseResult parseRes = answerParser->Parse(*log, translator, exe->gm, maxnbest, xmlresult, answerElement);
   switch (parseRes) {
 
   case AnswerParser::ParseError:
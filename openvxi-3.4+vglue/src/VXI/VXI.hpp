@@ -33,6 +33,7 @@
 #include "ExecutableContentHandler.hpp"
 
 class AnswerInformation;
+class AnswerParser;
 class DocumentParser;
 class ExecutionContext;
 class JumpDoc;
@@ -269,6 +270,7 @@ private:
   VXItelInterface    * tel;
   VXIobjectInterface * object;
   PromptManager      * pm;      // owned
+  AnswerParser       * answerParser; // owned
 
   VXIMap             * sdParams;
   VXIMap             * sdResult;
@@ -34,6 +34,10 @@
 #include "DocumentParser.hpp"
 #include "VXIjsi.h"
 #include "VXIcache.h"                 // for version check on interface
+#include "VXIrec.h"                   // for well known map keys
+#include "VXIprompt.h"
+#include "VXIinet.h"
+#include "VXML.h"
 
 #include <syslog.h>
 #include <vglue_tostring.h>
@@ -46,6 +50,32 @@
 
 static unsigned int DEFAULT_DOCUMENT_CACHE_SIZE = 1024; // 1024 kB = 1 MB
 
+// Property map keys the interpreter sets and looks up on every turn.
+// These are interned so maps reference rather than copy them, and
+// lookups using these same constants compare pointers.
+static const VXIchar * const WELL_KNOWN_MAP_KEYS[] = {
+  REC_BARGEIN_TYPE, REC_CONFIDENCE_LEVEL, REC_DTMF_TERMINATOR_CHAR,
+  REC_DTMF_TIMEOUT, REC_DTMF_TIMEOUT_INTERDIGIT, REC_DTMF_TIMEOUT_TERMINATOR,
+  REC_INPUT_MODES, REC_LANGUAGE, REC_MAX_RECORDING_TIME,
+  REC_RECORD_MIME_TYPE, REC_RECORDUTTERANCE, REC_RECORDUTTERANCETYPE,
+  REC_RESULT_NBEST_SIZE, REC_SENSITIVITY, REC_SPEED_VS_ACCURACY,
+  REC_TIMEOUT_COMPLETE, REC_TIMEOUT_INCOMPLETE, REC_TIMEOUT_SPEECH,
+  REC_GRAMMAR_ACCEPTANCE, REC_GRAMMAR_MODE, REC_GRAMMAR_WEIGHT,
+  REC_PREFETCH_REQUEST, REC_BEEP, REC_DTMF_FLUSH_QUEUE,
+  PROMPT_AUDIO_REFS, PROMPT_PREFETCH_REQUEST,
+  INET_CACHE_CONTROL_MAX_AGE, INET_CACHE_CONTROL_MAX_STALE, INET_CACHING,
+  INET_OPEN_IF_MODIFIED, INET_OPEN_LOCAL_FILE, INET_PREFETCH_PRIORITY,
+  INET_SUBMIT_METHOD, INET_SUBMIT_MIME_TYPE, INET_TIMEOUT_OPEN,
+  INET_TIMEOUT_IO, INET_TIMEOUT_DOWNLOAD, INET_URL_BASE, INET_URL_QUERY_ARGS,
+  INET_INFO_ABSOLUTE_NAME, INET_INFO_MIME_TYPE, INET_INFO_SIZE_BYTES,
+  INET_INFO_VALIDATOR, INET_INFO_HTTP_STATUS,
+  PROP_BARGEIN, PROP_BARGEINTYPE, PROP_COMPLETETIME, PROP_CONFIDENCE,
+  PROP_INCOMPLETETIME, PROP_INPUTMODES, PROP_INTERDIGITTIME, PROP_MAXNBEST,
+  PROP_SENSITIVITY, PROP_SPEEDVSACC, PROP_TERMCHAR, PROP_TERMTIME,
+  PROP_TIMEOUT, PROP_UNIVERSALS, PROP_MAXSPEECHTIME, PROP_RECORDUTTERANCE,
+  PROP_RECORDUTTERANCETYPE
+};
+
 // VXIinterp_RESULT_SUCCESS
 // VXIinterp_RESULT_FAILURE
 VXI_INTERPRETER 
@@ -65,6 +95,12 @@ VXIinterpreterResult VXIinterpreterInit(VXIlogInterface * log,
   if (!DocumentParser::Initialize(cacheSize))
     return VXIinterp_RESULT_FAILURE;
 
+  if (VXIMapInternKeys(WELL_KNOWN_MAP_KEYS,
+                       sizeof(WELL_KNOWN_MAP_KEYS) /
+                       sizeof(WELL_KNOWN_MAP_KEYS[0])) !=
+      VXIvalue_RESULT_SUCCESS)
+    return VXIinterp_RESULT_FAILURE;
+
   return VXIinterp_RESULT_SUCCESS;
 }
 
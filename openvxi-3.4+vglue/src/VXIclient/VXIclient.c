@@ -536,6 +536,10 @@ VXIplatformResult VXIplatformInit(VXIMap *configArgs, VXIunsigned *nbChannels)
     const VXIVector *proxyRules   = NULL;
     VXIMap *loadedExtensionRules  = NULL;
     VXIVector *loadedProxyRules   = NULL;
+    VXIint32 nativeHttp           = 0;
+    VXIint32 poolSize             = SBINET_CONNECTION_POOL_SIZE_DEFAULT;
+    VXIint32 idleTimeout          = SBINET_CONNECTION_IDLE_TIMEOUT_DEFAULT;
+    VXIMap *inetConfig            = NULL;
     diagLogBase                   = 0;
 
     GetVXIMap(configArgs, CLIENT_INET_EXTENSION_RULES, &extensionRules);
@@ -620,11 +624,38 @@ VXIplatformResult VXIplatformInit(VXIMap *configArgs, VXIunsigned *nbChannels)
     GetVXIString(configArgs, CLIENT_INET_PROXY_SERVER, &proxyServer);
     GetVXIInt(configArgs, CLIENT_INET_PROXY_PORT, &proxyPort);
 
-    /* Initialize the Internet component */
-    inetResult = SBinetInit(gblLog, (VXIunsigned) diagLogBase, NULL, 
-                            0, 0, 0, proxyServer, proxyPort,
-                            gblUserAgentName, extensionRules, proxyRules);
-    CHECK_RESULT_RETURN(NULL, "SBinetInit()", inetResult);
+    GetVXIInt(configArgs, CLIENT_INET_NATIVE_HTTP, &nativeHttp);
+    GetVXIInt(configArgs, CLIENT_INET_CONNECTION_POOL_SIZE, &poolSize);
+    GetVXIInt(configArgs, CLIENT_INET_CONNECTION_IDLE_TIMEOUT, &idleTimeout);
+
+    /* Initialize the Internet component, with the same parameters
+       SBinetInit() sets plus those of the native HTTP client */
+    inetConfig = VXIMapCreate();
+    CHECK_MEMALLOC_RETURN(NULL, inetConfig, L"SBinetInitEx");
+    VXIMapSetProperty(inetConfig, SBINET_USER_AGENT_NAME,
+                      (VXIValue *) VXIStringCreate(gblUserAgentName));
+    if (extensionRules)
+      VXIMapSetProperty(inetConfig, SBINET_EXTENSION_RULES,
+                        (VXIValue *) VXIMapClone(extensionRules));
+    if (proxyServer && *proxyServer) {
+      VXIchar proxyRule[256];
+      VXIVector *proxyVector = VXIVectorCreate();
+      CHECK_MEMALLOC_RETURN(NULL, proxyVector, L"SBinetInitEx");
+      SWIswprintf(proxyRule, 256, L"|%s:%d", proxyServer, proxyPort);
+      VXIVectorAddElement(proxyVector, (VXIValue *) VXIStringCreate(proxyRule));
+      VXIMapSetProperty(inetConfig, SBINET_PROXY_RULES,
+                        (VXIValue *) proxyVector);
+    }
+    VXIMapSetProperty(inetConfig, SBINET_NATIVE_HTTP,
+                      (VXIValue *) VXIIntegerCreate(nativeHttp));
+    VXIMapSetProperty(inetConfig, SBINET_CONNECTION_POOL_SIZE,
+                      (VXIValue *) VXIIntegerCreate(poolSize));
+    VXIMapSetProperty(inetConfig, SBINET_CONNECTION_IDLE_TIMEOUT,
+                      (VXIValue *) VXIIntegerCreate(idleTimeout));
+
+    inetResult = SBinetInitEx(gblLog, (VXIunsigned) diagLogBase, inetConfig);
+    VXIMapDestroy(&inetConfig);
+    CHECK_RESULT_RETURN(NULL, "SBinetInitEx()", inetResult);
 
     if (loadedExtensionRules)
       VXIMapDestroy(&loadedExtensionRules);
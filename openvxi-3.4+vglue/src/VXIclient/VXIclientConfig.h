@@ -85,6 +85,9 @@
 #define CLIENT_INET_EXTENSION_RULE_PREFIX      L"client.inet.extensionRule."
 #define CLIENT_INET_USER_AGENT                 L"client.inet.userAgent"
 #define CLIENT_INET_ACCEPT_COOKIES             L"client.inet.acceptCookies"
+#define CLIENT_INET_NATIVE_HTTP                L"client.inet.nativeHttp"
+#define CLIENT_INET_CONNECTION_POOL_SIZE       L"client.inet.connectionPoolSize"
+#define CLIENT_INET_CONNECTION_IDLE_TIMEOUT    L"client.inet.connectionIdleTimeout"
 /*@}*/
 
 #define OSR_USE_INTERNAL_SBINET                L"com.vocalocity.osr.use.sbinet"
@@ -230,7 +230,15 @@ VXIpromptResult VXIpromptPrefetch(VXIpromptInterface * vxip,
   Diag(impl, DIAG_TAG_PREFETCHING, L"VXIpromptPrefetch", L"%s",
       (text ? text : L"NULL")); 
 
-  return VXIprompt_RESULT_SUCCESS;
+  if (text == NULL || *text == L'\0')
+    return VXIprompt_RESULT_INVALID_ARGUMENT;
+
+  // As with Queue, only SSML comes here.  Voiceglue fetches the audio
+  // and TTS in the background, bounded per call, and keeps the counts.
+  if (type == NULL || VXIstrcmp(type, VXI_MIME_SSML) != 0)
+    return VXIprompt_RESULT_UNSUPPORTED;
+
+  return voiceglue_prefetch(text);
 }
 
 
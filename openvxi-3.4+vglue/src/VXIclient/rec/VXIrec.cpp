@@ -605,6 +605,9 @@ static VXIrecResult VXIrecRecognize(VXIrecInterface *pThis,
       return (rec_res);
   };
 
+  //  voiceglue leaves the values of number, date and such empty
+  tp->InterpretDTMFResult(nlsmlresult);
+
   // Create a new results structure.
   const unsigned int CHARSIZE = sizeof(VXIchar) / sizeof(VXIbyte);
   VXIContent * xmlresult = NULL;
@@ -739,16 +742,14 @@ static VXIrecResult VXIrecRecord(VXIrecInterface *pThis,
   result->marktime = 0;
   *recordResult = result;
 
-  unsigned char * c_waveform;
-  unsigned int waveformSizeBytes;
+  VXIContent * waveform;
   int rec_maxtime;
   unsigned int vg_duration;
   VXIbyte digit;
 
-  //  voiceglue code puts waveform into c_waveform[0..<end>]
+  //  voiceglue code hands back the waveform as mapped content
   VXIrecResult r =  voiceglue_record (props,
-				      &c_waveform,
-				      &waveformSizeBytes,
+				      &waveform,
 				      &vg_duration,
 				      &rec_maxtime,
 				      &digit);
@@ -757,7 +758,7 @@ static VXIrecResult VXIrecRecord(VXIrecInterface *pThis,
       (*recordResult)->Destroy(recordResult);    
       return r;
   };
-  if (c_waveform == NULL)
+  if (waveform == NULL)
   {
       //  Got NOINPUT
       (*recordResult)->xmlresult =
@@ -768,16 +769,7 @@ static VXIrecResult VXIrecRecord(VXIrecInterface *pThis,
   else
   {
       //  Got a waveform
-      (*recordResult)->waveform =
-	  VXIContentCreate(VXIREC_MIMETYPE_ULAW,
-			   c_waveform, waveformSizeBytes,
-			   ResultContentDestroy, NULL);
-      if( (*recordResult)->waveform == NULL ) {
-	  (*recordResult)->Destroy(recordResult);    
-	  tp->LogError(400, L"%s%s", L"Error", L"out of memory");
-	  return VXIrec_RESULT_OUT_OF_MEMORY;    
-      }
-      
+      (*recordResult)->waveform = waveform;
       (*recordResult)->duration = (VXIlong) vg_duration;
       if(rec_maxtime == 1) (*recordResult)->maxtime = TRUE;
       (*recordResult)->termchar = digit;
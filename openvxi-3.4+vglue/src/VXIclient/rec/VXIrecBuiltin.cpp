@@ -0,0 +1,466 @@
+
+/****************License************************************************
+ * Vocalocity OpenVXI
+ * Copyright (C) 2004-2005 by Vocalocity, Inc. All Rights Reserved.
+ * vglue mods Copyright 2006,2007 Ampersand Inc., Doug Campbell
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ * Vocalocity, the Vocalocity logo, and VocalOS are trademarks or
+ * registered trademarks of Vocalocity, Inc.
+ * OpenVXI is a trademark of Scansoft, Inc. and used under license
+ * by Vocalocity.
+ ***********************************************************************/
+
+#include "VXIrecBuiltin.h"
+
+#include <cwchar>
+#include <map>
+#include <sstream>
+#include <vector>
+
+static const VXIchar * const DIGIT_KEYS = L"0123456789";
+
+// The keys a boolean accepts, as SRGSDTMF's table
+static const VXIchar * const BOOLEAN_KEYS = L"0123456789*#";
+
+// Digit counts past this are taken as this, which is more than any
+// grammar is built for
+static const int MAX_COUNT = 1000000;
+
+typedef std::map<vxistring, vxistring> ARGS;
+
+// Reads a length parameter; values that are not all digits are ignored.
+static bool GetCount(const ARGS & args, const VXIchar * name, int & count)
+{
+  ARGS::const_iterator i = args.find(name);
+  if (i == args.end() || (*i).second.empty()) return false;
+  const vxistring & value = (*i).second;
+  int n = 0;
+  for (vxistring::size_type j = 0; j < value.length(); ++j) {
+    if (value[j] < L'0' || value[j] > L'9') return false;
+    if (n < MAX_COUNT) n = n * 10 + (value[j] - L'0');
+  }
+  count = (n < MAX_COUNT ? n : MAX_COUNT);
+  return true;
+}
+
+// Reads a boolean key parameter; anything but a single key is ignored.
+static bool GetBooleanKey(const ARGS & args, const VXIchar * name,
+                          VXIchar & key)
+{
+  ARGS::const_iterator i = args.find(name);
+  if (i == args.end() || (*i).second.length() != 1 ||
+      wcschr(BOOLEAN_KEYS, (*i).second[0]) == NULL)
+    return false;
+  key = (*i).second[0];
+  return true;
+}
+
+
+/******************************************
+ * VXIrecBuiltinSpec : Type and parameters
+ ******************************************/
+
+vxistring VXIrecBuiltinSpec::GetKey() const
+{
+  std::basic_stringstream<VXIchar> key;
+  switch (type) {
+  case DIGITS:
+    key << L"digits?minlength=" << minlength << L";maxlength=" << maxlength;
+    break;
+  case BOOLEAN:
+    key << L"boolean";
+    if (yes != 0) key << L"?y=" << yes;
+    if (no != 0) key << (yes != 0 ? L";n=" : L"?n=") << no;
+    break;
+  case NUMBER:   key << L"number";   break;
+  case CURRENCY: key << L"currency"; break;
+  case DATE:     key << L"date";     break;
+  case TIME:     key << L"time";     break;
+  }
+  return key.str();
+}
+
+
+/******************************************
+ * VXIrecDTMFGrammar : A builtin's automaton
+ ******************************************/
+
+int VXIrecDTMFGrammar::KeyIndex(VXIchar key)
+{
+  if (key >= L'0' && key <= L'9') return key - L'0';
+  switch (key) {
+  case L'*': return 10;
+  case L'#': return 11;
+  case L'A': return 12;
+  case L'B': return 13;
+  case L'C': return 14;
+  case L'D': return 15;
+  }
+  return -1;
+}
+
+
+int VXIrecDTMFGrammar::Walk(const VXIchar * input) const
+{
+  int state = start;
+  for (; input != NULL && *input != L'\0' && state >= 0; ++input) {
+    int k = KeyIndex(*input);
+    state = (k < 0 ? -1 : states[state].next[k]);
+  }
+  return state;
+}
+
+
+VXIrecDTMFMatch VXIrecDTMFGrammar::Match(const VXIchar * input,
+                                         const VXIchar ** tag) const
+{
+  int state = Walk(input);
+  if (tag != NULL) *tag = NULL;
+  if (state < 0) return DTMF_NOMATCH;
+  if (!states[state].accept) return DTMF_PARTIAL;
+  if (tag != NULL && states[state].tag >= 0)
+    *tag = tags[states[state].tag].c_str();
+  return (states[state].last ? DTMF_MATCH_FINAL : DTMF_MATCH);
+}
+
+
+bool VXIrecDTMFGrammar::Interpret(const vxistring & input,
+                                  vxistring & result) const
+{
+  const VXIchar * tag;
+  if (Match(input.c_str(), &tag) <= DTMF_PARTIAL) return false;
+  if (interpreter != NULL) {
+    (*interpreter)(input, result);
+    return true;
+  }
+  if (tag == NULL) return false;
+  result = tag;
+  return true;
+}
+
+
+/******************************************
+ * VXIrecBuiltin : Builtin grammar automata
+ ******************************************/
+
+bool VXIrecBuiltin::IsBuiltin(const vxistring & grammar)
+{
+  return grammar.compare(0, 8, L"builtin:") == 0;
+}
+
+
+bool VXIrecBuiltin::Parse(const vxistring & uri, VXIrecBuiltinSpec & spec,
+                          vxistring & error)
+{
+  // (1) Split builtin:<mode>/<type>?<args>; the mode is not used, as
+  // voiceglue takes every grammar as DTMF
+  if (!IsBuiltin(uri)) {
+    error = L"not a builtin grammar";
+    return false;
+  }
+  vxistring::size_type slash = uri.find(L'/', 8);
+  if (slash == vxistring::npos) {
+    error = L"no builtin type in " + uri;
+    return false;
+  }
+  vxistring::size_type query = uri.find(L'?', slash + 1);
+  vxistring type(uri, slash + 1, (query == vxistring::npos ?
+                                  vxistring::npos : query - slash - 1));
+
+  // (2) The <name>=<value> arguments, separated by ;
+  ARGS args;
+  vxistring::size_type pos = query;
+  while (pos != vxistring::npos && pos + 1 < uri.length()) {
+    vxistring::size_type end = uri.find(L';', pos + 1);
+    vxistring arg(uri, pos + 1,
+                  end == vxistring::npos ? vxistring::npos : end - pos - 1);
+    vxistring::size_type eq = arg.find(L'=');
+    if (eq == vxistring::npos || eq == 0) {
+      error = L"cannot parse builtin arg spec " + arg;
+      return false;
+    }
+    args[arg.substr(0, eq)] = arg.substr(eq + 1);
+    pos = end;
+  }
+
+  // (3) The type's parameters
+  spec.minlength = 0;
+  spec.maxlength = 0;
+  spec.yes = 0;
+  spec.no = 0;
+  if (type == L"digits") {
+    spec.type = VXIrecBuiltinSpec::DIGITS;
+    int count, min = 1, max = VXIREC_BUILTIN_MAX_DIGITS;
+    if (GetCount(args, L"length", count)) min = max = count;
+    if (GetCount(args, L"minlength", count)) min = count;
+    if (GetCount(args, L"maxlength", count)) max = count;
+    if (max == 0) {
+      error = L"invalid digits maxlength of 0";
+      return false;
+    }
+    if (max < min) {
+      error = L"invalid digits minlength > maxlength";
+      return false;
+    }
+    // A variable length string stops at MaxVarDigits whatever its maximum
+    if (min < max && min < VXIREC_BUILTIN_MAX_DIGITS &&
+        max > VXIREC_BUILTIN_MAX_DIGITS)
+      max = VXIREC_BUILTIN_MAX_DIGITS;
+    spec.minlength = min;
+    spec.maxlength = max;
+  }
+  else if (type == L"boolean") {
+    spec.type = VXIrecBuiltinSpec::BOOLEAN;
+    spec.yes = L'1';
+    GetBooleanKey(args, L"y", spec.yes);
+    GetBooleanKey(args, L"n", spec.no);
+  }
+  else if (type == L"number")
+    spec.type = VXIrecBuiltinSpec::NUMBER;
+  else if (type == L"currency")
+    spec.type = VXIrecBuiltinSpec::CURRENCY;
+  else if (type == L"date")
+    spec.type = VXIrecBuiltinSpec::DATE;
+  else if (type == L"time")
+    spec.type = VXIrecBuiltinSpec::TIME;
+  else {
+    error = L"unsupported builtin grammar " + type;
+    return false;
+  }
+  return true;
+}
+
+
+VXIrecDTMFGrammar * VXIrecBuiltin::Compile(const VXIrecBuiltinSpec & spec,
+                                           vxistring & error)
+{
+  VXIrecDTMFGrammar * g = new VXIrecDTMFGrammar();
+  if (g == NULL) {
+    error = L"out of memory";
+    return NULL;
+  }
+
+  switch (spec.type) {
+  case VXIrecBuiltinSpec::DIGITS:
+    if (!BuildDigits(spec, *g, error)) {
+      delete g;
+      return NULL;
+    }
+    break;
+  case VXIrecBuiltinSpec::BOOLEAN:
+    BuildBoolean(spec, *g);
+    break;
+  case VXIrecBuiltinSpec::NUMBER:
+  case VXIrecBuiltinSpec::CURRENCY:
+    BuildNumber(*g);
+    g->interpreter = InterpretNumber;
+    break;
+  case VXIrecBuiltinSpec::DATE:
+    BuildDate(*g);
+    g->interpreter = InterpretDate;
+    break;
+  case VXIrecBuiltinSpec::TIME:
+    BuildTime(*g);
+    g->interpreter = InterpretTime;
+    break;
+  }
+
+  Finish(*g);
+  return g;
+}
+
+
+int VXIrecBuiltin::AddState(VXIrecDTMFGrammar & g, bool accept, int tag)
+{
+  VXIrecDTMFGrammar::State s;
+  for (int k = 0; k < VXIREC_DTMF_KEY_COUNT; ++k) s.next[k] = -1;
+  s.tag = tag;
+  s.accept = accept;
+  s.last = false;
+  g.states.push_back(s);
+  return g.states.size() - 1;
+}
+
+
+void VXIrecBuiltin::Link(VXIrecDTMFGrammar & g, int from, const VXIchar * keys,
+                         int to)
+{
+  for (; *keys != L'\0'; ++keys)
+    g.states[from].next[VXIrecDTMFGrammar::KeyIndex(*keys)] = to;
+}
+
+
+// State 0 is the start; accepting states with no way out are final.
+void VXIrecBuiltin::Finish(VXIrecDTMFGrammar & g)
+{
+  g.start = 0;
+  for (unsigned int i = 0; i < g.states.size(); ++i) {
+    VXIrecDTMFGrammar::State & s = g.states[i];
+    bool out = false;
+    for (int k = 0; k < VXIREC_DTMF_KEY_COUNT && !out; ++k)
+      out = (s.next[k] >= 0);
+    s.last = s.accept && !out;
+  }
+}
+
+
+// Digits, with SRGSDTMF's two forms: exactly n digits when the length is
+// fixed, else up to MaxVarDigits digits and an optional #.  Past maxlength
+// a variable string can no longer match, but more keys are still taken,
+// as SRGSDTMF does, so that input ends on a timeout or the termchar.
+bool VXIrecBuiltin::BuildDigits(const VXIrecBuiltinSpec & spec,
+                                VXIrecDTMFGrammar & g, vxistring & error)
+{
+  int min = spec.minlength, max = spec.maxlength;
+
+  if (min == max) {
+    if (min >= VXIREC_DTMF_MAX_STATES) {
+      error = L"digits length too large to compile";
+      return false;
+    }
+    for (int i = 0; i <= min; ++i) AddState(g, i == min);
+    for (int i = 0; i < min; ++i) Link(g, i, DIGIT_KEYS, i + 1);
+    return true;
+  }
+
+  if (min >= VXIREC_BUILTIN_MAX_DIGITS) {
+    error = L"digits minlength too large to compile";
+    return false;
+  }
+  for (int i = 0; i <= VXIREC_BUILTIN_MAX_DIGITS; ++i)
+    AddState(g, i >= min && i <= max);
+  int pound = AddState(g, true);
+  for (int i = 0; i <= VXIREC_BUILTIN_MAX_DIGITS; ++i) {
+    if (i < VXIREC_BUILTIN_MAX_DIGITS) Link(g, i, DIGIT_KEYS, i + 1);
+    if (g.states[i].accept) Link(g, i, L"#", pound);
+  }
+  return true;
+}
+
+
+// One key, true for the y key and false for every other key, the n key
+// winning if both are the same.
+void VXIrecBuiltin::BuildBoolean(const VXIrecBuiltinSpec & spec,
+                                 VXIrecDTMFGrammar & g)
+{
+  g.tags.push_back(L"true");
+  g.tags.push_back(L"false");
+  AddState(g, false);
+  int isTrue = AddState(g, true, 0);
+  int isFalse = AddState(g, true, 1);
+  for (const VXIchar * key = BOOLEAN_KEYS; *key != L'\0'; ++key) {
+    VXIchar k[2] = { *key, L'\0' };
+    Link(g, 0, k, (*key == spec.yes && *key != spec.no) ? isTrue : isFalse);
+  }
+}
+
+
+// Digits, then * and more digits for a fraction, then an optional #, in
+// at most MaxVarDigits keys as SRGSDTMF takes them.  Each state counts
+// the keys taken, so the last key of a full number is final.
+void VXIrecBuiltin::BuildNumber(VXIrecDTMFGrammar & g)
+{
+  const int N = VXIREC_BUILTIN_MAX_DIGITS;
+  std::vector<int> whole(N + 1, -1), point(N + 1, -1), fraction(N + 1, -1);
+
+  AddState(g, false);
+  int pound = AddState(g, true);
+  for (int i = 1; i <= N; ++i) {
+    whole[i] = AddState(g, true);
+    if (i >= 2) point[i] = AddState(g, false);
+    if (i >= 3) fraction[i] = AddState(g, true);
+  }
+
+  Link(g, 0, DIGIT_KEYS, whole[1]);
+  for (int i = 1; i < N; ++i) {
+    Link(g, whole[i], DIGIT_KEYS, whole[i + 1]);
+    Link(g, whole[i], L"*", point[i + 1]);
+    Link(g, whole[i], L"#", pound);
+    if (point[i] >= 0) Link(g, point[i], DIGIT_KEYS, fraction[i + 1]);
+    if (fraction[i] >= 0) {
+      Link(g, fraction[i], DIGIT_KEYS, fraction[i + 1]);
+      Link(g, fraction[i], L"#", pound);
+    }
+  }
+}
+
+
+// yyyymmdd, with a month of 01 to 12 and a day of 01 to 31
+void VXIrecBuiltin::BuildDate(VXIrecDTMFGrammar & g)
+{
+  for (int i = 0; i < 4; ++i) AddState(g, false);
+  int month = AddState(g, false);
+  int month0 = AddState(g, false);
+  int month1 = AddState(g, false);
+  int day = AddState(g, false);
+  int day0 = AddState(g, false);
+  int day12 = AddState(g, false);
+  int day3 = AddState(g, false);
+  int done = AddState(g, true);
+  for (int i = 0; i < 4; ++i) Link(g, i, DIGIT_KEYS, i + 1);
+  Link(g, month, L"0", month0);
+  Link(g, month, L"1", month1);
+  Link(g, month0, L"123456789", day);
+  Link(g, month1, L"012", day);
+  Link(g, day, L"0", day0);
+  Link(g, day, L"12", day12);
+  Link(g, day, L"3", day3);
+  Link(g, day0, L"123456789", done);
+  Link(g, day12, DIGIT_KEYS, done);
+  Link(g, day3, L"01", done);
+}
+
+
+// hhmm, with an hour of 00 to 23 and a minute of 00 to 59
+void VXIrecBuiltin::BuildTime(VXIrecDTMFGrammar & g)
+{
+  AddState(g, false);
+  int hour01 = AddState(g, false);
+  int hour2 = AddState(g, false);
+  int minute = AddState(g, false);
+  int minute1 = AddState(g, false);
+  int done = AddState(g, true);
+  Link(g, 0, L"01", hour01);
+  Link(g, 0, L"2", hour2);
+  Link(g, hour01, DIGIT_KEYS, minute);
+  Link(g, hour2, L"0123", minute);
+  Link(g, minute, L"012345", minute1);
+  Link(g, minute1, DIGIT_KEYS, done);
+}
+
+
+void VXIrecBuiltin::InterpretNumber(const vxistring & input,
+                                    vxistring & result)
+{
+  result.erase();
+  for (vxistring::size_type i = 0; i < input.length(); ++i) {
+    if (input[i] == L'*') result += L'.';
+    else if (input[i] != L'#') result += input[i];
+  }
+}
+
+
+void VXIrecBuiltin::InterpretDate(const vxistring & input, vxistring & result)
+{
+  result = input;
+}
+
+
+void VXIrecBuiltin::InterpretTime(const vxistring & input, vxistring & result)
+{
+  int hour = (input[0] - L'0') * 10 + (input[1] - L'0');
+  result = input;
+  result += ((hour == 0 || hour > 12) ? L'h' : L'?');
+}
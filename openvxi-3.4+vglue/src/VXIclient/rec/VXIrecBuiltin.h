@@ -0,0 +1,161 @@
+
+/****************License************************************************
+ * Vocalocity OpenVXI
+ * Copyright (C) 2004-2005 by Vocalocity, Inc. All Rights Reserved.
+ * vglue mods Copyright 2006,2007 Ampersand Inc., Doug Campbell
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ * Vocalocity, the Vocalocity logo, and VocalOS are trademarks or
+ * registered trademarks of Vocalocity, Inc.
+ * OpenVXI is a trademark of Scansoft, Inc. and used under license
+ * by Vocalocity.
+ ***********************************************************************/
+
+#ifndef _VXIREC_BUILTIN
+#define _VXIREC_BUILTIN
+
+#include <VXIvalue.h>
+#include <string>
+#include <vector>
+typedef std::basic_string<VXIchar> vxistring;
+
+// Builtin grammars (builtin:dtmf/digits?minlength=3;maxlength=5 and so on)
+// built directly as VXIrecDTMFGrammar automata.  voiceglue matches the
+// input; the automata give the values of voiceglue's results.
+//
+// digits and boolean match and interpret keys as SRGSDTMF does.  number,
+// currency, date and time are the VoiceXML 2.0 DTMF forms, with values
+// computed from the keys: number and currency are digits with * as the
+// decimal point and an optional # ("12*5#" is "12.5"), date is yyyymmdd,
+// and time is hhmm, given as "hhmmh" for 24 hour times and "hhmm?" for
+// the ambiguous 01 to 12 hours.
+
+// The longest variable length digit string, SRGSDTMF's MaxVarDigits.
+static const int VXIREC_BUILTIN_MAX_DIGITS = 256;
+
+// The DTMF keys 0-9, *, #, A-D, in transition table order.
+static const int VXIREC_DTMF_KEY_COUNT = 16;
+
+// Grammars whose automaton would exceed this many states are refused.
+static const int VXIREC_DTMF_MAX_STATES = 4096;
+
+// Status of the input so far, the same codes SRGSDTMF::check_rules_match
+// returns.
+enum VXIrecDTMFMatch {
+  DTMF_NOMATCH     = -1,   // no further input can make a match
+  DTMF_PARTIAL     = 0,    // further input could make a match
+  DTMF_MATCH       = 1,    // a match, further input could also match
+  DTMF_MATCH_FINAL = 2     // a match, no further input can match
+};
+
+
+// A builtin grammar as a deterministic automaton over the DTMF keys.
+class VXIrecDTMFGrammar {
+public:
+  static int KeyIndex(VXIchar key);
+  // Returns the transition table index of a DTMF key, or -1.
+
+  VXIrecDTMFMatch Match(const VXIchar * input, const VXIchar ** tag) const;
+  // Matches a whole key sequence from the start state.
+
+  bool Interpret(const vxistring & input, vxistring & result) const;
+  // Sets result to the semantic interpretation of a matching input: the
+  // value a builtin computes from the keys, else the tag.  Returns false
+  // if there is none.
+
+  int GetStateCount() const { return states.size(); }
+
+private:
+  typedef void (*Interpreter)(const vxistring & input, vxistring & result);
+
+  struct State {
+    int  next[VXIREC_DTMF_KEY_COUNT];
+    int  tag;                         // index in tags, -1 for none
+    bool accept;
+    bool last;                        // accept with no way out
+  };
+
+  VXIrecDTMFGrammar() : start(-1), interpreter(NULL) { }
+
+  int Walk(const VXIchar * input) const;
+  // Returns the state after input, -1 if no match is then possible.
+
+  int                    start;
+  std::vector<State>     states;
+  std::vector<vxistring> tags;
+  Interpreter            interpreter;     // builtins valued by their keys
+
+  friend class VXIrecBuiltin;
+};
+
+
+// A builtin grammar type with its parameters.
+struct VXIrecBuiltinSpec {
+  enum Type {
+    DIGITS,
+    BOOLEAN,
+    NUMBER,
+    CURRENCY,
+    DATE,
+    TIME
+  };
+
+  Type    type;
+  int     minlength;       // digits
+  int     maxlength;
+  VXIchar yes;             // boolean: the key for true, 0 for none
+  VXIchar no;              // boolean: the key for false, 0 for none
+
+  vxistring GetKey() const;
+  // Returns the type and parameters in a canonical form, the key compiled
+  // grammars are cached by: "digits?minlength=1;maxlength=4", "date".
+};
+
+
+class VXIrecBuiltin {
+public:
+  static bool IsBuiltin(const vxistring & grammar);
+  // Returns true for a builtin: URI.
+
+  static bool Parse(const vxistring & uri, VXIrecBuiltinSpec & spec,
+                    vxistring & error);
+  // Parses builtin:<mode>/<type>?<name>=<value>;... as SRGSDTMF does,
+  // ignoring unknown parameters and ill formed values.  Returns false and
+  // sets error for other types and conflicting lengths.
+
+  static VXIrecDTMFGrammar * Compile(const VXIrecBuiltinSpec & spec,
+                                     vxistring & error);
+  // Builds the automaton.  Returns NULL and sets error if it would be too
+  // large, leaving the grammar to voiceglue.
+
+private:
+  static int AddState(VXIrecDTMFGrammar & g, bool accept, int tag = -1);
+  static void Link(VXIrecDTMFGrammar & g, int from, const VXIchar * keys,
+                   int to);
+  static void Finish(VXIrecDTMFGrammar & g);
+
+  static bool BuildDigits(const VXIrecBuiltinSpec & spec,
+                          VXIrecDTMFGrammar & g, vxistring & error);
+  static void BuildBoolean(const VXIrecBuiltinSpec & spec,
+                           VXIrecDTMFGrammar & g);
+  static void BuildNumber(VXIrecDTMFGrammar & g);
+  static void BuildDate(VXIrecDTMFGrammar & g);
+  static void BuildTime(VXIrecDTMFGrammar & g);
+
+  static void InterpretNumber(const vxistring & input, vxistring & result);
+  static void InterpretDate(const vxistring & input, vxistring & result);
+  static void InterpretTime(const vxistring & input, vxistring & result);
+};
+
+#endif /* include guard */
@@ -0,0 +1,207 @@
+
+/****************License************************************************
+ * Vocalocity OpenVXI
+ * Copyright (C) 2004-2005 by Vocalocity, Inc. All Rights Reserved.
+ * vglue mods Copyright 2006,2007 Ampersand Inc., Doug Campbell
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ * Vocalocity, the Vocalocity logo, and VocalOS are trademarks or
+ * registered trademarks of Vocalocity, Inc.
+ * OpenVXI is a trademark of Scansoft, Inc. and used under license
+ * by Vocalocity.
+ ***********************************************************************/
+
+// Conformance test for VXIrecBuiltin.  The digits and boolean cases give
+// the match codes and interpretations of SRGSDTMF's builtins; number,
+// currency, date and time give the VoiceXML 2.0 DTMF values.
+//
+//   VXIrecBuiltinTest
+
+#include "VXIrecBuiltin.h"
+#include <stdio.h>
+#include <wchar.h>
+
+static unsigned long failures = 0;
+
+#define CHECK(cond, what, arg) \
+  do { if (!(cond)) { \
+    fprintf(stderr, "%s: %ls\n", what, arg); \
+    failures++; } } while (0)
+
+// URIs and the key each is cached by, NULL if refused
+struct KeyCase {
+  const VXIchar * uri;
+  const VXIchar * key;
+};
+
+static const KeyCase KEYS[] = {
+  { L"builtin:dtmf/digits", L"digits?minlength=1;maxlength=256" },
+  { L"builtin:grammar/digits", L"digits?minlength=1;maxlength=256" },
+  { L"builtin:dtmf/digits?length=4", L"digits?minlength=4;maxlength=4" },
+  { L"builtin:dtmf/digits?maxlength=4;minlength=2",
+    L"digits?minlength=2;maxlength=4" },
+  { L"builtin:dtmf/digits?minlength=2;maxlength=4;",
+    L"digits?minlength=2;maxlength=4" },
+  { L"builtin:dtmf/digits?length=3;minlength=1",
+    L"digits?minlength=1;maxlength=3" },
+  { L"builtin:dtmf/digits?maxlength=1000", L"digits?minlength=1;maxlength=256" },
+  { L"builtin:dtmf/digits?minlength=x;foo=bar",
+    L"digits?minlength=1;maxlength=256" },
+  { L"builtin:dtmf/digits?maxlength=0", NULL },
+  { L"builtin:dtmf/digits?minlength=5;maxlength=4", NULL },
+  { L"builtin:dtmf/digits?minlength", NULL },
+  { L"builtin:dtmf/boolean", L"boolean?y=1" },
+  { L"builtin:dtmf/boolean?y=7;n=9", L"boolean?y=7;n=9" },
+  { L"builtin:dtmf/boolean?y=yes", L"boolean?y=1" },
+  { L"builtin:dtmf/number", L"number" },
+  { L"builtin:dtmf/currency", L"currency" },
+  { L"builtin:dtmf/date", L"date" },
+  { L"builtin:dtmf/time", L"time" },
+  { L"builtin:dtmf/phone", NULL },
+  { L"builtin:digits", NULL }
+};
+static const int KEY_COUNT = sizeof(KEYS) / sizeof(KEYS[0]);
+
+// Inputs with the SRGSDTMF::check_rules_match code and interpretation
+struct MatchCase {
+  const VXIchar * uri;
+  const VXIchar * input;
+  int             match;
+  const VXIchar * interp;
+};
+
+// 255 digits, one less than MaxVarDigits
+#define ONES_5     L"11111"
+#define ONES_25    ONES_5 ONES_5 ONES_5 ONES_5 ONES_5
+#define ONES_125   ONES_25 ONES_25 ONES_25 ONES_25 ONES_25
+#define DIGITS_255 ONES_125 ONES_125 ONES_5
+
+static const MatchCase MATCHES[] = {
+  // SRGSDTMF/t/srgsdtmf.t
+  { L"builtin:dtmf/digits?minlength=0;maxlength=4", L"1", 1, NULL },
+  { L"builtin:dtmf/digits?minlength=0;maxlength=4", L"1234", 1, NULL },
+  { L"builtin:dtmf/digits?minlength=0;maxlength=4", L"1234#", 2, NULL },
+  { L"builtin:dtmf/digits?minlength=0;maxlength=4", L"55#", 2, NULL },
+  { L"builtin:dtmf/digits?minlength=0;maxlength=4", L"#", 2, NULL },
+  // Past maxlength input is taken, but # cannot end it
+  { L"builtin:dtmf/digits?minlength=0;maxlength=4", L"12345", 0, NULL },
+  { L"builtin:dtmf/digits?minlength=0;maxlength=4", L"12345#", -1, NULL },
+  { L"builtin:dtmf/digits?minlength=2;maxlength=4", L"1", 0, NULL },
+  { L"builtin:dtmf/digits?minlength=2;maxlength=4", L"1#", -1, NULL },
+  { L"builtin:dtmf/digits?minlength=2;maxlength=4", L"12*", -1, NULL },
+  { L"builtin:dtmf/digits?length=3", L"12", 0, NULL },
+  { L"builtin:dtmf/digits?length=3", L"123", 2, NULL },
+  { L"builtin:dtmf/digits?length=3", L"123#", -1, NULL },
+  { L"builtin:dtmf/digits?length=3", L"1234", -1, NULL },
+  { L"builtin:dtmf/digits", L"1234567890", 1, NULL },
+  // SRGSDTMF's boolean table: 1 is true, any other key false
+  { L"builtin:dtmf/boolean", L"1", 2, L"true" },
+  { L"builtin:dtmf/boolean", L"2", 2, L"false" },
+  { L"builtin:dtmf/boolean", L"#", 2, L"false" },
+  { L"builtin:dtmf/boolean", L"*", 2, L"false" },
+  { L"builtin:dtmf/boolean", L"A", -1, NULL },
+  { L"builtin:dtmf/boolean", L"12", -1, NULL },
+  { L"builtin:dtmf/boolean?y=7;n=1", L"7", 2, L"true" },
+  { L"builtin:dtmf/boolean?y=7;n=1", L"1", 2, L"false" },
+  { L"builtin:dtmf/boolean?y=7", L"1", 2, L"false" },
+  { L"builtin:dtmf/boolean?y=7", L"7", 2, L"true" },
+  { L"builtin:dtmf/boolean?y=3;n=3", L"3", 2, L"false" },
+  // number and currency
+  { L"builtin:dtmf/number", L"", 0, NULL },
+  { L"builtin:dtmf/number", L"42", 1, L"42" },
+  { L"builtin:dtmf/number", L"42#", 2, L"42" },
+  { L"builtin:dtmf/number", L"3*", 0, NULL },
+  { L"builtin:dtmf/number", L"3*14", 1, L"3.14" },
+  { L"builtin:dtmf/number", L"3*14#", 2, L"3.14" },
+  { L"builtin:dtmf/number", L"*5", -1, NULL },
+  { L"builtin:dtmf/number", L"3*#", -1, NULL },
+  { L"builtin:dtmf/number", L"3*1*4", -1, NULL },
+  { L"builtin:dtmf/currency", L"1999*95#", 2, L"1999.95" },
+  // SRGSDTMF takes at most MaxVarDigits keys, the last one ending it
+  { L"builtin:dtmf/number", DIGITS_255 L"1", 2, DIGITS_255 L"1" },
+  { L"builtin:dtmf/number", DIGITS_255 L"#", 2, DIGITS_255 },
+  { L"builtin:dtmf/number", DIGITS_255 L"*", 0, NULL },
+  { L"builtin:dtmf/number", DIGITS_255 L"11", -1, NULL },
+  { L"builtin:dtmf/currency", DIGITS_255 L"1#", -1, NULL },
+  // date
+  { L"builtin:dtmf/date", L"2007", 0, NULL },
+  { L"builtin:dtmf/date", L"20070320", 2, L"20070320" },
+  { L"builtin:dtmf/date", L"20071231", 2, L"20071231" },
+  { L"builtin:dtmf/date", L"20071301", -1, NULL },
+  { L"builtin:dtmf/date", L"20070001", -1, NULL },
+  { L"builtin:dtmf/date", L"20070100", -1, NULL },
+  { L"builtin:dtmf/date", L"20070132", -1, NULL },
+  { L"builtin:dtmf/date", L"200703201", -1, NULL },
+  // time
+  { L"builtin:dtmf/time", L"09", 0, NULL },
+  { L"builtin:dtmf/time", L"0930", 2, L"0930?" },
+  { L"builtin:dtmf/time", L"1745", 2, L"1745h" },
+  { L"builtin:dtmf/time", L"0005", 2, L"0005h" },
+  { L"builtin:dtmf/time", L"1200", 2, L"1200?" },
+  { L"builtin:dtmf/time", L"2400", -1, NULL },
+  { L"builtin:dtmf/time", L"1260", -1, NULL }
+};
+static const int MATCH_COUNT = sizeof(MATCHES) / sizeof(MATCHES[0]);
+
+
+int main()
+{
+  int i;
+
+  // (1) Parameters and keys
+  for (i = 0; i < KEY_COUNT; ++i) {
+    const KeyCase & c = KEYS[i];
+    VXIrecBuiltinSpec spec;
+    vxistring error;
+    bool ok = VXIrecBuiltin::Parse(c.uri, spec, error);
+    CHECK(ok == (c.key != NULL), "wrong parse", c.uri);
+    if (ok && c.key != NULL)
+      CHECK(spec.GetKey() == c.key, "wrong key", c.uri);
+  }
+
+  // (2) Whole inputs, and their interpretations
+  for (i = 0; i < MATCH_COUNT; ++i) {
+    const MatchCase & c = MATCHES[i];
+    VXIrecBuiltinSpec spec;
+    vxistring error;
+    VXIrecDTMFGrammar * g = NULL;
+    if (VXIrecBuiltin::Parse(c.uri, spec, error))
+      g = VXIrecBuiltin::Compile(spec, error);
+    CHECK(g != NULL, "not compiled", c.uri);
+    if (g == NULL) continue;
+
+    CHECK(g->Match(c.input, NULL) == c.match, "wrong match", c.input);
+
+    vxistring interp;
+    bool got = g->Interpret(c.input, interp);
+    CHECK(got == (c.interp != NULL), "wrong interpretation", c.input);
+    if (got && c.interp != NULL)
+      CHECK(interp == c.interp, "wrong interpretation", c.input);
+    delete g;
+  }
+
+  // (3) Lengths too large are left to voiceglue
+  VXIrecBuiltinSpec spec;
+  vxistring error;
+  VXIrecBuiltin::Parse(L"builtin:dtmf/digits?length=100000", spec, error);
+  CHECK(VXIrecBuiltin::Compile(spec, error) == NULL, "not refused",
+        L"length=100000");
+
+  if (failures > 0) {
+    fprintf(stderr, "%lu failures\n", failures);
+    return 1;
+  }
+  printf("VXIrecBuiltinTest: all tests passed\n");
+  return 0;
+}
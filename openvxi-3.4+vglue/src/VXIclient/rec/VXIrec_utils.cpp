@@ -22,11 +22,13 @@
  * by Vocalocity.
  ***********************************************************************/
 
+#include <map>
 #include <sstream>
 
 #include <VXIvalue.h>
 #include <VXItrd.h>
 #include "VXIrec_utils.h"
+#include "VXIrecBuiltin.h"
 #include "XMLChConverter.hpp"
 #include "LogBlock.hpp"
 
@@ -57,6 +59,7 @@ public:
   GRAMMARINFOLIST * grammarInfoList;
   bool enabled;
   GTYPE gtype;
+  const VXIrecDTMFGrammar * dtmfGrammar;   // builtins only, shared
 
 public:
 
@@ -68,6 +71,8 @@ public: // VXIrecGrammar fuctions...
                               VXIrecGrammarInfo ** gramInfo) const;
   virtual VXIString * GetGrammarWords() const;
   virtual bool IsDtmf() const { return gtype == GTYPE_DTMF; }
+  virtual const VXIrecDTMFGrammar * GetDTMFGrammar() const
+  { return dtmfGrammar; }
 
 public:
   VXIrecWordList();
@@ -75,7 +80,8 @@ public:
 };
 
 VXIrecWordList::VXIrecWordList()
-  : enabled(false), gtype(VXIrecWordList::GTYPE_NONE), grammarInfoList(NULL)
+  : enabled(false), gtype(VXIrecWordList::GTYPE_NONE), grammarInfoList(NULL),
+    dtmfGrammar(NULL)
 { }
 
 
@@ -172,6 +178,11 @@ static VXIlogInterface* gblLog = NULL;
 static VXIulong GRAM_ROOT_COUNTER = 0;
 static const VXIchar * const GRAM_ROOT_PREFIX  = L"_GRAMROOT_";
 
+// Compiled builtin grammars by VXIrecBuiltinSpec key, shared by all
+// channels and kept until ShutDown; NULL for those not compiled
+typedef std::map<vxistring, VXIrecDTMFGrammar *> BUILTINS;
+static BUILTINS gblBuiltins;
+
 // recursively replace all occurence of sstr with rstr
 static vxistring::size_type ReplaceChar(vxistring &modstr,
                                         const vxistring &sstr,
@@ -440,6 +451,10 @@ int VXIrecData::Initialize(VXIlogInterface* log, VXIunsigned diagBase)
 
 int VXIrecData::ShutDown()
 {
+  for (BUILTINS::iterator i = gblBuiltins.begin(); i != gblBuiltins.end(); ++i)
+    delete (*i).second;
+  gblBuiltins.clear();
+
   if( gblMutex != NULL ) {
     VXItrdMutexDestroy(&gblMutex);
     gblMutex = NULL;
@@ -632,9 +647,54 @@ VXIrecGrammar * VXIrecData::ParseSRGSGrammar(const vxistring & srgsgram,
                            VXIrecWordList::GTYPE_SPEECH);
   newGrammarPtr->grammarInfoList = xmlHandler->AcquireGrammarInfoList();
   */
+
+  // Builtins are built once for each set of parameters and shared, to
+  // give the values of voiceglue's results for them
+  if( VXIrecBuiltin::IsBuiltin(srgsgram) )
+    newGrammarPtr->dtmfGrammar = GetBuiltinGrammar(srgsgram);
+  if( newGrammarPtr->dtmfGrammar != NULL )
+    newGrammarPtr->gtype = VXIrecWordList::GTYPE_DTMF;
   return newGrammarPtr;
 }
 
+const VXIrecDTMFGrammar * VXIrecData::GetBuiltinGrammar(const vxistring & uri)
+{
+  const VXIchar* fnname = L"GetBuiltinGrammar";
+  LogBlock logger(log, VXIrecData::diagLogBase, fnname, VXIREC_MODULE);
+
+  VXIrecBuiltinSpec spec;
+  vxistring error;
+  if( !VXIrecBuiltin::Parse(uri, spec, error) ) {
+    logger.logDiag(DIAG_TAG_GRAMMARS, L"%s%s", L"Builtin grammar not "
+                   L"compiled: ", error.c_str());
+    return NULL;
+  }
+
+  // (1) Compiled before, or refused before
+  vxistring key = spec.GetKey();
+  VXItrdMutexLock(gblMutex);
+  BUILTINS::iterator i = gblBuiltins.find(key);
+  if( i != gblBuiltins.end() ) {
+    const VXIrecDTMFGrammar * g = (*i).second;
+    VXItrdMutexUnlock(gblMutex);
+    return g;
+  }
+
+  // (2) Compile it; these are small, so this is done under the lock
+  VXIrecDTMFGrammar * g = VXIrecBuiltin::Compile(spec, error);
+  gblBuiltins[key] = g;
+  VXItrdMutexUnlock(gblMutex);
+
+  if( g == NULL )
+    logger.logDiag(DIAG_TAG_GRAMMARS, L"%s%s%s%s", L"Builtin grammar ",
+                   key.c_str(), L" not compiled: ", error.c_str());
+  else
+    logger.logDiag(DIAG_TAG_GRAMMARS, L"%s%s%s%d%s", L"Builtin grammar ",
+                   key.c_str(), L" compiled to ", g->GetStateCount(),
+                   L" states");
+  return g;
+}
+
 void VXIrecData::Clear()
 {
   if( !grammars.empty() )
@@ -853,6 +913,51 @@ bool VXIrecData::ProcessSemanticInterp(vxistring & result, const VXIrecGrammarIn
   return true;
 }
 
+void VXIrecData::InterpretDTMFResult(vxistring & nlsmlresult)
+{
+  const VXIchar* fnname = L"InterpretDTMFResult";
+  LogBlock logger(log, VXIrecData::diagLogBase, fnname, VXIREC_MODULE);
+
+  // (1) The grammar, input and instance of voiceglue's result
+  static const VXIchar GRAMMAR_ATTR[] = L"grammar=\"";
+  static const VXIchar INPUT_START[] = L"<input mode=\"dtmf\">";
+  static const VXIchar INSTANCE_START[] = L"<instance>";
+  static const VXIchar INSTANCE_END[] = L"</instance>";
+  vxistring::size_type gram = nlsmlresult.find(GRAMMAR_ATTR);
+  vxistring::size_type input = nlsmlresult.find(INPUT_START);
+  vxistring::size_type inst = nlsmlresult.find(INSTANCE_START);
+  if( gram == vxistring::npos || input == vxistring::npos ||
+      inst == vxistring::npos )
+    return;
+  gram += wcslen(GRAMMAR_ATTR);
+  input += wcslen(INPUT_START);
+  inst += wcslen(INSTANCE_START);
+  vxistring::size_type gramEnd = nlsmlresult.find(L'"', gram);
+  vxistring::size_type inputEnd = nlsmlresult.find(L'<', input);
+  if( gramEnd == vxistring::npos || inputEnd == vxistring::npos ||
+      nlsmlresult.compare(inst, wcslen(INSTANCE_END), INSTANCE_END) != 0 )
+    return;
+  vxistring gramid(nlsmlresult, gram, gramEnd - gram);
+  vxistring keys(nlsmlresult, input, inputEnd - input);
+
+  // (2) Only builtins valued by their keys have an interpretation that
+  // voiceglue leaves empty
+  for (GRAMMARS::iterator i = activeGrammars.begin(); i != activeGrammars.end(); ++i) {
+    VXIchar id[64];
+    SWIswprintf(id, 64, L"%p", *i);
+    if( gramid != id ) continue;
+    const VXIrecDTMFGrammar * g = (*i)->GetDTMFGrammar();
+    if( g == NULL ) return;
+
+    vxistring instance;
+    if( !g->Interpret(keys, instance) ) return;
+    nlsmlresult.insert(inst, instance);
+    logger.logDiag(DIAG_TAG_RECOGNITION, L"%s%s%s%s", L"DTMF input ",
+                   keys.c_str(), L" interpreted as ", instance.c_str());
+    return;
+  }
+}
+
 bool VXIrecData::ConstructNLSMLForInput(const VXIchar* input, vxistring & nlsmlresult)
 {
   const VXIchar* fnname = L"ConstructNLSMLForInput";
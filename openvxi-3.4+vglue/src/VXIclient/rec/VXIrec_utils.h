@@ -42,6 +42,7 @@ using namespace xercesc;
 #include <list>
 #include <string>
 typedef std::basic_string<VXIchar> vxistring;
+#include "VXIrecBuiltin.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -99,6 +100,9 @@ public:
   virtual VXIString * GetGrammarWords() const = 0;
   virtual bool IsDtmf() const = 0;
 
+  virtual const VXIrecDTMFGrammar * GetDTMFGrammar() const = 0;
+  // Returns the automaton of a builtin grammar, or NULL if there is none.
+
 };
 
 
@@ -134,6 +138,13 @@ public:
   // Return true if grammar found for the input and the nlsml is constructed
   bool ConstructNLSMLForInput(const VXIchar* input, vxistring & nlsmlresult);
 
+  // Return the shared automaton for a builtin: grammar, NULL if not compiled
+  const VXIrecDTMFGrammar * GetBuiltinGrammar(const vxistring & uri);
+
+  // Fill in the empty instance of a voiceglue DTMF result matched by a
+  // builtin whose value comes from the keys, such as number or date
+  void InterpretDTMFResult(vxistring & nlsmlresult);
+
   
   // Conversion functions
   bool JSGFToSRGS(const vxistring & incoming,
@@ -296,7 +296,7 @@ VXItelResult VXItelDisconnect(VXItelInterface * pThis,const VXIMap *namelist)
   VXItelImpl *impl = ToVXItelImpl(pThis);
   Diag(impl, DIAG_TAG_SIGNALING, NULL, L"Disconnect");
   impl->SetLineStatus(VXItel_STATUS_INACTIVE); 
-  voiceglue_sendipcmsg ("Disconnect\n");
+  voiceglue_disconnect ();
   return VXItel_RESULT_SUCCESS;
 }
 
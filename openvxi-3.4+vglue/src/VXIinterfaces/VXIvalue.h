@@ -251,6 +251,52 @@ VXIVALUE_API void VXIValueDestroy(VXIValue **v);
  */
 VXIVALUE_API VXIValue *VXIValueClone(const VXIValue *v);
 
+/**
+ * Begin a value allocation arena scope for the calling thread
+ *
+ * Until the matching VXIValueArenaEnd( ), values created by this
+ * thread (including the storage of Strings, Maps and Vectors) are
+ * allocated from an arena that is released in bulk, which is much
+ * cheaper for the many short lived values of a single operation.
+ * Values may still be kept or destroyed after the scope ends, and by
+ * other threads, but each one keeps its whole 32 KB arena chunk
+ * allocated until then. Values meant to be cached beyond the scope
+ * should therefore be created between VXIValueArenaPause( ) and
+ * VXIValueArenaResume( ). Scopes may be nested, only the outermost
+ * one has an effect.
+ *
+ * @return   VXIvalue_RESULT_SUCCESS on success
+ */
+VXIVALUE_API VXIvalueResult VXIValueArenaBegin(void);
+
+/**
+ * End a value allocation arena scope for the calling thread
+ *
+ * @return   VXIvalue_RESULT_SUCCESS on success, VXIvalue_RESULT_FAILURE
+ *           if no scope is open
+ */
+VXIVALUE_API VXIvalueResult VXIValueArenaEnd(void);
+
+/**
+ * Suspend the calling thread's arena scope, if any
+ *
+ * Until the matching VXIValueArenaResume( ), values created by this
+ * thread are allocated from the heap as if no scope were open. Used
+ * for long lived values created within a scope, so that they do not
+ * pin an arena chunk. Pauses may be nested.
+ *
+ * @return   VXIvalue_RESULT_SUCCESS on success
+ */
+VXIVALUE_API VXIvalueResult VXIValueArenaPause(void);
+
+/**
+ * Resume the calling thread's arena scope after VXIValueArenaPause( )
+ *
+ * @return   VXIvalue_RESULT_SUCCESS on success, VXIvalue_RESULT_FAILURE
+ *           if the arena is not paused
+ */
+VXIVALUE_API VXIvalueResult VXIValueArenaResume(void);
+
 /**
  * Create a Boolean from a VXIbool
  *
@@ -831,6 +877,26 @@ VXIVALUE_API VXIvalueResult VXIMapGetNextProperty(VXIMapIterator  *it,
  */
 VXIVALUE_API void VXIMapIteratorDestroy(VXIMapIterator **it);
 
+/**
+ * Register well known map keys for interning
+ *
+ * Maps reference these keys rather than copying them, and lookups
+ * that pass one of these pointers compare it before the characters.
+ * Registering a key with the same characters as one already registered
+ * has no effect. Implementations may ignore this, it never changes
+ * the results of other map operations.
+ *
+ * Note: this is meant for string constants. The keys must remain
+ * valid for as long as any map may use them, and this must be called
+ * during initialization, before maps are used by multiple threads.
+ *
+ * @param   keys      Array of NULL terminated keys
+ * @param   numKeys   Number of keys in the array
+ * @return            VXIvalue_RESULT_SUCCESS on success
+ */
+VXIVALUE_API VXIvalueResult VXIMapInternKeys(const VXIchar *const *keys,
+                                             VXIunsigned           numKeys);
+
 /**
  * Create an empty Vector
  *
@@ -1007,6 +1073,67 @@ VXIVALUE_API VXIString *VXIValueToString(const VXIValue      *v,
 					 const VXIchar       *name,
 					 VXIValueStringFormat format);
 
+
+/**
+ * MIME content type of the VXIContent produced by VXIValueSerialize( )
+ */
+#define VXI_MIME_VXIVALUE L"application/x-vxivalue"
+
+/**
+ * Generic Value serialization to a compact binary format
+ *
+ * Unlike VXIValueToString( ), this encoding preserves the exact type
+ * and value of every element, so VXIValueDeserialize( ) rebuilds an
+ * identical tree. It is intended for IPC payloads, cache persistence,
+ * and call state snapshots.
+ *
+ * The stream starts with a magic number and a format version,
+ * followed by the value itself as a one byte type tag and its
+ * payload. Integers use variable length encoding, floating point
+ * values are little endian IEEE 754, strings and map keys are UTF-8,
+ * and Content carries its MIME type, transfer encoding, and bytes.
+ * Map properties are written in iteration order. The encoding is the
+ * same on every platform, independent of byte order and of the size
+ * of VXIchar and VXIlong.
+ *
+ * The output is sized before it is written, so exactly one buffer is
+ * allocated for the result.
+ *
+ * @param   v       Value to serialize
+ * @param   result  Returns a Content of type VXI_MIME_VXIVALUE holding
+ *                  the serialized bytes, the caller must release it
+ *                  using VXIContentDestroy( )
+ * @return          VXIvalue_RESULT_SUCCESS on success,
+ *                  VXIvalue_RESULT_UNSUPPORTED if the tree contains a
+ *                  VXIPtr or maps and vectors nested more than 64 deep,
+ *                  or another VXIvalueResult error code on failure
+ */
+VXIVALUE_API VXIvalueResult VXIValueSerialize(const VXIValue  *v,
+					      VXIContent     **result);
+
+/**
+ * Generic Value deserialization from the VXIValueSerialize( ) format
+ *
+ * The input is treated as untrusted: every length and element count
+ * is validated against the remaining input before anything is
+ * allocated, and nesting is limited to the same depth the encoder
+ * accepts, so malformed or truncated input fails cleanly with memory
+ * use bounded by the input size. Content bytes are copied, the input
+ * buffer may be released as soon as this returns.
+ *
+ * @param   data    Serialized bytes
+ * @param   size    Number of bytes in data
+ * @param   result  Returns the rebuilt value, the caller must release
+ *                  it using VXIValueDestroy( )
+ * @return          VXIvalue_RESULT_SUCCESS on success,
+ *                  VXIvalue_RESULT_FAILURE if the input is malformed,
+ *                  VXIvalue_RESULT_UNSUPPORTED for an unknown format
+ *                  version, or another VXIvalueResult error code
+ */
+VXIVALUE_API VXIvalueResult VXIValueDeserialize(const VXIbyte  *data,
+						VXIulong        size,
+						VXIValue      **result);
+
 #ifdef __cplusplus
 } /* This ends the extern "C". */
 
@@ -1100,6 +1227,52 @@ private:
   VXIMap * _map;
 };
 
+/**
+ * C++ wrapper class that keeps a value allocation arena scope open
+ * for its lifetime, see VXIValueArenaBegin( ). For instance:<p>
+ * \code
+ *   void Recognize(void)
+ *   {
+ *     VXIValueArenaScope arena;
+ *     DoStuff();  // this code may throw an exception.
+ *   }
+ * \endcode
+ */
+class VXIValueArenaScope {
+public:
+  VXIValueArenaScope()           { VXIValueArenaBegin(); }
+  ~VXIValueArenaScope()          { VXIValueArenaEnd(); }
+
+private:
+  // do not allow these operations
+  VXIValueArenaScope(const VXIValueArenaScope &);
+  VXIValueArenaScope & operator=(const VXIValueArenaScope &);
+};
+
+/**
+ * C++ wrapper class that keeps the calling thread's arena scope
+ * paused for its lifetime, see VXIValueArenaPause( ). For instance:<p>
+ * \code
+ *   const VXIMap * GetCache(void)
+ *   {
+ *     VXIValueHeapScope heap;
+ *     if (cache == NULL) cache = BuildCache();
+ *     return cache;
+ *   }
+ * \endcode
+ */
+class VXIValueHeapScope {
+public:
+  VXIValueHeapScope()            { VXIValueArenaPause(); }
+  ~VXIValueHeapScope()           { VXIValueArenaResume(); }
+
+private:
+  // do not allow these operations
+  VXIValueHeapScope(const VXIValueHeapScope &);
+  VXIValueHeapScope & operator=(const VXIValueHeapScope &);
+};
+
+
 /**
  * C++ wrapper class that makes it easier to work with VXIContent.
  */
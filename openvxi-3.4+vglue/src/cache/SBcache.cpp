@@ -287,9 +287,17 @@ SBcacheInterface::Close (VXIbool keepEntry,
 	rc = rc2;
     }
     
+    bool written = ((*stream)->GetMode( ) == CACHE_MODE_WRITE);
     rc2 = (*stream)->Close (keepEntry ? false : true);
-    if ( rc2 != VXIcache_RESULT_SUCCESS )
+    if ( rc2 != VXIcache_RESULT_SUCCESS ) {
       rc = rc2;
+    } else if (( keepEntry ) && ( written )) {
+      // Record the completed entry in the cache index, ignore all but
+      // fatal errors as for the delete above
+      rc2 = gblCacheMgr->CloseNotification (GetLog( ), (*stream)->GetKey( ));
+      if ( rc2 < VXIcache_RESULT_SUCCESS )
+	rc = rc2;
+    }
 
     delete *stream;
     *stream = NULL;
@@ -135,6 +135,9 @@ public:
   // Close
   virtual VXIcacheResult Close(bool invalidate);
 
+  // Get the open mode
+  virtual VXIcacheOpenMode GetMode( ) const { return _mode; }
+
 private:
   SBcacheStream(const SBcacheStream &s);
   const SBcacheStream &operator=(const SBcacheStream &s);
@@ -286,7 +289,7 @@ public:
     _rwMutex(refCountMutex),
     _creationCost(CACHE_CREATION_COST_DEFAULT), _lastModified(0),
     _lastAccessed(0), _flags(CACHE_FLAG_NULL), _key(), _path(), _sizeBytes(0),
-    _fileExists(false), _invalidated(false) { }
+    _fileExists(false), _invalidated(false), _writing(false) { }
   virtual ~SBcacheEntryDetails( );
 
   // Release the cache entry
@@ -308,9 +311,24 @@ public:
 		      VXIMap                *streamInfo,
 		      VXIcacheStream       **stream);
 
+  // Restore the entry from the cache index, the file is complete
+  void Restore(const SBcacheKey &key, const SBcachePath &path,
+	       VXIunsigned sizeBytes, time_t lastModified,
+	       time_t lastAccessed) {
+    _key = key;
+    _path = path;
+    _sizeBytes = sizeBytes;
+    _lastModified = lastModified;
+    _lastAccessed = lastAccessed;
+    _fileExists = true;
+  }
+
   // Unlock the entry
   VXIcacheResult Unlock(VXIlogInterface  *log);
 
+  // Invalidate the entry, see Close( ) for why this is only a flag
+  void Invalidate( ) { _invalidated = true; }
+
   // Accessors
   bool IsLocked( ) const {
     return ((_flags & (CACHE_FLAG_LOCK | CACHE_FLAG_LOCK_MEMORY)) != 0); }
@@ -327,6 +345,9 @@ public:
 
   const SBcacheKey &GetKey( ) const { return _key; }
   const SBcachePath &GetPath( ) const { return _path; }
+  time_t GetLastModified( ) const { return _lastModified; }
+  time_t GetLastAccessed( ) const { return _lastAccessed; }
+  bool IsWriting( ) const { return _writing; }
 
   VXIulong GetSizeBytes (bool haveEntryOpen) const {
     VXIulong size = 0;
@@ -410,19 +431,16 @@ private:
   VXIunsigned              _sizeBytes;       // (4)
   bool                     _fileExists;      // (2?)
   bool                     _invalidated;     // (2?)
+  bool                     _writing;         // (2?)
 };
 
 
 // Destructor
 SBcacheEntryDetails::~SBcacheEntryDetails( )
 {
-  // Delete the on-disk file if appropriate
-  // TBD make this conditional by removing the #if 0 once
-  // persistant caching across process restarts (saving/loading
-  // the index file) is implemented
-#if 0
+  // Delete the on-disk file if appropriate, valid entries are kept
+  // for the next process as recorded in the cache index
   if ( _invalidated )
-#endif
     DeleteFile( );
 }
 
@@ -496,6 +514,7 @@ VXIcacheResult SBcacheEntryDetails::Open(VXIlogInterface       *log,
 	_creationCost = CACHE_CREATION_COST_DEFAULT;
 	_flags = flags;
 	_sizeBytes = 0;
+	_writing = true;
 
         // Only set the path and key if they differ
         if (path != _path || key != _key) {
@@ -616,6 +635,7 @@ VXIcacheResult SBcacheEntryDetails::Close(VXIlogInterface   *log,
   switch ( mode ) {
   case CACHE_MODE_WRITE:
     _sizeBytes = sizeBytes;
+    _writing = false;
 
     if ( _rwMutex.Unlock( ) != VXItrd_RESULT_SUCCESS ) {
       Error (log, 111, L"%s%s", L"mutex", L"cache entry rw mutex, writer");
@@ -739,6 +759,23 @@ VXIcacheResult SBcacheEntry::Create(VXIlogInterface *log,
 }
 
 
+// Restore the entry
+VXIcacheResult SBcacheEntry::Restore(VXIlogInterface    *log,
+				     VXIunsigned         diagTagBase,
+				     SBcacheMutex       *refCountMutex,
+				     const SBcacheKey   &key,
+				     const SBcachePath  &path,
+				     VXIulong            sizeBytes,
+				     time_t              lastModified,
+				     time_t              lastAccessed)
+{
+  VXIcacheResult rc = Create (log, diagTagBase, refCountMutex);
+  if ( rc == VXIcache_RESULT_SUCCESS )
+    _details->Restore (key, path, sizeBytes, lastModified, lastAccessed);
+  return rc;
+}
+
+
 // Open the entry
 VXIcacheResult SBcacheEntry::Open(VXIlogInterface       *log,
 				  const SBcacheString   &moduleName,
@@ -776,6 +813,14 @@ VXIcacheResult SBcacheEntry::Unlock(VXIlogInterface       *log)
 }
 
 
+// Invalidate the entry
+void SBcacheEntry::Invalidate( ) const
+{
+  if ( _details )
+    _details->Invalidate( );
+}
+
+
 // Accessors
 bool SBcacheEntry::IsLocked( ) const
 {
@@ -803,6 +848,21 @@ VXIulong SBcacheEntry::GetSizeBytes (bool haveEntryOpen) const
   return _details->GetSizeBytes (haveEntryOpen);
 }
 
+time_t SBcacheEntry::GetLastModified( ) const
+{
+  return _details->GetLastModified( );
+}
+
+time_t SBcacheEntry::GetLastAccessed( ) const
+{
+  return _details->GetLastAccessed( );
+}
+
+bool SBcacheEntry::IsWriting( ) const
+{
+  return _details->IsWriting( );
+}
+
 
 // Error logging
 VXIlogResult SBcacheEntry::LogIOError (VXIunsigned errorID) const
@@ -61,15 +61,34 @@ public:
 		      VXIMap                *streamInfo,
 		      VXIcacheStream       **stream);
 
+  // Restore a complete entry recorded in the cache index
+  VXIcacheResult Restore(VXIlogInterface    *log,
+			 VXIunsigned         diagTagBase,
+			 SBcacheMutex       *refCountMutex,
+			 const SBcacheKey   &key,
+			 const SBcachePath  &path,
+			 VXIulong            sizeBytes,
+			 time_t              lastModified,
+			 time_t              lastAccessed);
+
   // Unlock the entry
   VXIcacheResult Unlock(VXIlogInterface     *log);
 
+  // Invalidate the entry, the on-disk file is deleted along with the
+  // last reference to the entry
+  void Invalidate( ) const;
+
   // Accessors
   bool IsLocked( ) const;
   bool IsExpired (time_t cutoffTime, time_t *lastAccessed) const;
   const SBcacheKey & GetKey( ) const;
   const SBcachePath & GetPath( ) const;
   VXIulong GetSizeBytes (bool haveEntryOpen = false) const;
+  time_t GetLastModified( ) const;
+  time_t GetLastAccessed( ) const;
+  // True from an open for write until its close, read without the
+  // entry lock like GetSizeBytes (true)
+  bool IsWriting( ) const;
 
   // Error logging
   VXIlogResult LogIOError (VXIunsigned errorID) const;
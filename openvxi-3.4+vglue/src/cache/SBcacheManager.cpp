@@ -31,6 +31,10 @@
 #include <vector>                  // for STL list template class
 #include <algorithm>
 #include <limits.h>              // for ULONG_MAX
+#include <stdio.h>               // for FILE, fopen( ), rename( ), etc
+#include <stdlib.h>              // for strtoul( )
+#include <errno.h>               // for errno to report fopen( ) errors
+#include <string.h>              // for strerror( )
 
 #if defined(__GNUC__) && (__GNUC__ == 3) && (__GNUC_MINOR__ < 2)
 #include <strstream>
@@ -42,32 +46,224 @@ static const int CACHE_REF_COUNT_MUTEX_POOL_SIZE = 256;
 static const int CACHE_MAX_DIR_ENTRIES = 256;
 static const char CACHE_ENTRY_FILE_EXTENSION[] = ".sbc";
 
+// The cleaner thread checks the cache size at least this often, and
+// evicts in batches of at most this many entries with a pause between
+// them to keep lock hold times short and rate limit the file deletes
+static const VXIint CACHE_CLEANER_INTERVAL_MS = 1000;
+static const int CACHE_CLEANUP_BATCH_ENTRIES = 16;
+static const VXIint CACHE_CLEANUP_BATCH_DELAY_MS = 10;
+
+// The index is a journal, a version line followed by one record per
+// line that is appended as entries are written and deleted:
+//
+//   P <lastAccessed> <lastModified> <sizeBytes> <path> <key>
+//   W <lastAccessed> <lastModified> <path> <key>
+//   D <key>
+//
+// with tab separated fields, the path relative to the cache directory
+// and the key with '%' and characters outside printable ASCII written
+// as '%' and 8 hex digits.  A P record is a complete entry, possibly
+// empty, and a W record an entry still being written.  Version 1
+// indexes had no W records and used P records of size 0 for them.
+// Accesses are only kept in memory, the index is
+// rewritten with one record per entry in LRU order when the journal
+// grows past CACHE_INDEX_COMPACT_RATIO records per entry and at
+// shutdown, so after a crash the entries are restored in the order
+// they were last compacted or written.
+static const char CACHE_INDEX_FILE_NAME[] = "SBcacheIndex.sbi";
+static const char CACHE_INDEX_VERSION[] = "SBcacheIndex 2";
+static const char CACHE_INDEX_VERSION_1[] = "SBcacheIndex 1";
+static const VXIulong CACHE_INDEX_COMPACT_MIN = 1024;
+static const VXIulong CACHE_INDEX_COMPACT_RATIO = 4;
+
+// An entry as replayed from the index journal
+struct SBcacheIndexRecord {
+  SBcacheKey      key;
+  SBcacheNString  path;
+  VXIulong        sizeBytes;
+  time_t          lastModified;
+  time_t          lastAccessed;
+  bool            complete;
+};
+
+// Read a line of the index, false at the end of the file including for
+// a last line cut short by a crash
+static bool ReadIndexLine(FILE *fp, SBcacheNString &line)
+{
+  line.erase( );
+  int c;
+  while ((c = getc (fp)) != EOF) {
+    if ( c == '\n' )
+      return true;
+    line += static_cast<char>(c);
+  }
+  return false;
+}
+
+// Split a line of the index on tabs
+static void SplitIndexLine(const SBcacheNString &line,
+			   std::vector<SBcacheNString> &fields)
+{
+  fields.clear( );
+  SBcacheNString::size_type start = 0, end;
+  while ((end = line.find ('\t', start)) != SBcacheNString::npos) {
+    fields.push_back (line.substr (start, end - start));
+    start = end + 1;
+  }
+  fields.push_back (line.substr (start));
+}
+
+// Parse an unsigned decimal field of the index
+static bool ParseIndexNumber(const SBcacheNString &field, VXIulong &value)
+{
+  if (( field.empty( ) ) || ( field[0] < '0' ) || ( field[0] > '9' ))
+    return false;
+  char *end = NULL;
+  value = strtoul (field.c_str( ), &end, 10);
+  return (*end == '\0');
+}
+
+// Encode and decode a key for the index
+static SBcacheNString EncodeIndexKey(const SBcacheKey &key)
+{
+  SBcacheNString str;
+  char buf[16];
+  for (SBcacheKey::size_type i = 0; i < key.length( ); i++) {
+    if (( key[i] > L' ' ) && ( key[i] < 0x7F ) && ( key[i] != L'%' )) {
+      str += static_cast<char>(key[i]);
+    } else {
+      sprintf (buf, "%%%08lx", static_cast<unsigned long>(key[i]));
+      str += buf;
+    }
+  }
+  return str;
+}
+
+static bool DecodeIndexKey(const SBcacheNString &str, SBcacheKey &key)
+{
+  key.erase( );
+  for (SBcacheNString::size_type i = 0; i < str.length( ); i++) {
+    if ( str[i] != '%' ) {
+      key += static_cast<VXIchar>(static_cast<unsigned char>(str[i]));
+    } else {
+      SBcacheNString hex (str.substr (i + 1, 8));
+      char *end = NULL;
+      unsigned long c = strtoul (hex.c_str( ), &end, 16);
+      if (( hex.length( ) != 8 ) || ( *end != '\0' ))
+	return false;
+      key += static_cast<VXIchar>(c);
+      i += 8;
+    }
+  }
+  return ( ! key.empty( ) );
+}
+
+// Make the P record for an entry, or the W record if it is being
+// written. The entry lock isn't needed, see GetSizeBytes( ).
+static SBcacheNString MakeIndexRecord(const SBcacheEntry &entry)
+{
+  char buf[96];
+  if ( entry.IsWriting( ) )
+    sprintf (buf, "W\t%lu\t%lu\t",
+	     static_cast<unsigned long>(entry.GetLastAccessed( )),
+	     static_cast<unsigned long>(entry.GetLastModified( )));
+  else
+    sprintf (buf, "P\t%lu\t%lu\t%lu\t",
+	     static_cast<unsigned long>(entry.GetLastAccessed( )),
+	     static_cast<unsigned long>(entry.GetLastModified( )),
+	     static_cast<unsigned long>(entry.GetSizeBytes (true)));
+  return buf + entry.GetPath( ).relative( ) + "\t" +
+    EncodeIndexKey (entry.GetKey( ));
+}
+
+// Get the sequence number of an entry path relative to the cache
+// directory, see GetNewEntryPath( ), or 0 if it isn't one of ours
+static VXIulong GetPathSeqNum(const SBcacheNString &path)
+{
+  SBcacheNString::size_type fileSep = path.rfind (SBcachePath::PATH_SEPARATOR);
+  if (( fileSep == SBcacheNString::npos ) || ( fileSep == 0 ))
+    return 0;
+  SBcacheNString::size_type dirSep =
+    path.rfind (SBcachePath::PATH_SEPARATOR, fileSep - 1);
+  if (( dirSep == SBcacheNString::npos ) || ( dirSep == 0 ))
+    return 0;
+
+  SBcacheNString module (path.substr (0, dirSep));
+  if (( module == "." ) || ( module == ".." ))
+    return 0;
+  for (SBcacheNString::size_type i = 0; i < module.length( ); i++) {
+    char c = module[i];
+    if ((( c < '0' ) || ( c > '9' )) && (( c < 'A' ) || ( c > 'Z' )) &&
+	(( c < 'a' ) || ( c > 'z' )) && ( c != '.' ) && ( c != '_' ))
+      return 0;
+  }
+
+  SBcacheNString file (path.substr (fileSep + 1));
+  SBcacheNString::size_type extLen = sizeof(CACHE_ENTRY_FILE_EXTENSION) - 1;
+  if (( file.length( ) <= extLen ) ||
+      ( file.compare (file.length( ) - extLen, extLen,
+		      CACHE_ENTRY_FILE_EXTENSION) != 0 ))
+    return 0;
+
+  VXIulong dir, index;
+  if (( ! ParseIndexNumber (path.substr (dirSep + 1, fileSep - dirSep - 1),
+			    dir) ) ||
+      ( ! ParseIndexNumber (file.substr (0, file.length( ) - extLen),
+			    index) ) ||
+      ( index >= (VXIulong) CACHE_MAX_DIR_ENTRIES ))
+    return 0;
+
+  return dir * CACHE_MAX_DIR_ENTRIES + index;
+}
+
 // -----1=0-------2=0-------3=0-------4=0-------5=0-------6=0-------7=0-------8
 
 
 // Shut down the manager
 SBcacheManager::~SBcacheManager( )
 {
-  if ( _cacheDir.length( ) > 0 ) {
-    // Lock to be paranoid, makes sure everyone else is done
-    if ( _entryTableMutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
-      Error (110, L"%s%s", L"mutex", L"entry table mutex");
-    } else {
-      // Write out the index file
-      WriteIndex( );
+  // Stop the cleaner thread, it finishes the batch it is working on
+  if ( _cleanerThread ) {
+    VXItrdThreadArg status;
+    _cleanerExit = true;
+    VXItrdTimerWake (_cleanerTimer);
+    VXItrdThreadJoin (_cleanerThread, &status, -1);
+    VXItrdThreadDestroyHandle (&_cleanerThread);
+  }
+  if ( _cleanerTimer )
+    VXItrdTimerDestroy (&_cleanerTimer);
 
-      // Clear the cache entries
-      _entryTable.erase (_entryTable.begin( ), _entryTable.end( ));
-      _entryLRUList.erase(_entryLRUList.begin(), _entryLRUList.end());
-      _curSizeBytes.Reset (0);
+  if ( _cacheDir.length( ) > 0 ) {
+    // Write out the index file
+    WriteIndex( );
+    if ( _indexFile ) {
+      fclose (_indexFile);
+      _indexFile = NULL;
+    }
 
-      // Clear the directory name
-      _cacheDir = "";
+    // Lock to be paranoid, makes sure everyone else is done, and
+    // clear the cache entries
+    for (int i = 0; i < ENTRY_TABLE_SHARDS; i++) {
+      SBcacheEntryShard &shard = *_shards[i];
+      if ( shard.mutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
+	Error (110, L"%s%s", L"mutex", L"entry table mutex");
+      } else {
+	shard.table.erase (shard.table.begin( ), shard.table.end( ));
+	shard.lruList.erase (shard.lruList.begin( ), shard.lruList.end( ));
 
-      if ( _entryTableMutex.Unlock( ) != VXItrd_RESULT_SUCCESS )
-	Error (111, L"%s%s", L"mutex", L"entry table mutex");
+	if ( shard.mutex.Unlock( ) != VXItrd_RESULT_SUCCESS )
+	  Error (111, L"%s%s", L"mutex", L"entry table mutex");
+      }
     }
+    _curSizeBytes.Reset (0);
+    _numEntries.Reset (0);
+
+    // Clear the directory name
+    _cacheDir = "";
   }
+
+  for (int i = 0; i < ENTRY_TABLE_SHARDS; i++)
+    delete _shards[i];
 }
 
 
@@ -94,11 +290,22 @@ VXIcacheResult SBcacheManager::Create(const SBcacheNString &cacheDir,
     rc = VXIcache_RESULT_SYSTEM_ERROR;
   }
 
-  // Create the entry table mutex
+  // Create the entry table shard mutexes
+  for (int i = 0; ( rc == VXIcache_RESULT_SUCCESS ) &&
+	 ( i < ENTRY_TABLE_SHARDS ); i++) {
+    if ( _shards[i]->mutex.Create(L"SBcacheManager entry table mutex") !=
+	 VXItrd_RESULT_SUCCESS ) {
+      Error (109, L"%s%s", L"mutex", L"entry table mutex");
+      rc = VXIcache_RESULT_SYSTEM_ERROR;
+    }
+  }
+
+  // Create the entry count and index mutex
   if (( rc == VXIcache_RESULT_SUCCESS ) &&
-      ( _entryTableMutex.Create(L"SBcacheManager entry table mutex") !=
-	VXItrd_RESULT_SUCCESS )) {
-    Error (109, L"%s%s", L"mutex", L"entry table mutex");
+      (( _numEntries.Create( ) != VXItrd_RESULT_SUCCESS ) ||
+       ( _indexMutex.Create(L"SBcacheManager index mutex") !=
+	 VXItrd_RESULT_SUCCESS ))) {
+    Error (109, L"%s%s", L"mutex", L"index mutex");
     rc = VXIcache_RESULT_SYSTEM_ERROR;
   }
 
@@ -141,6 +348,27 @@ VXIcacheResult SBcacheManager::Create(const SBcacheNString &cacheDir,
     _maxSizeBytes = cacheMaxSizeBytes;
     _entryMaxSizeBytes = entryMaxSizeBytes;
     _lowWaterBytes = cacheLowWaterBytes;
+
+    // The cleaner starts halfway between the low water mark and the
+    // size limit, leaving room for writes made while it catches up
+    _highWaterBytes = _lowWaterBytes + (_maxSizeBytes - _lowWaterBytes) / 2;
+
+    // Compact the index read above and open it for appending, errors
+    // are reported and leave the cache running without persistence
+    WriteIndex( );
+  }
+
+  // Start the cleaner thread
+  if ( rc == VXIcache_RESULT_SUCCESS ) {
+    if (( VXItrdTimerCreate (&_cleanerTimer) != VXItrd_RESULT_SUCCESS ) ||
+	( VXItrdThreadCreate (&_cleanerThread, CleanerThread,
+			      (VXItrdThreadArg) this) !=
+	  VXItrd_RESULT_SUCCESS )) {
+      Error (115, NULL);
+      rc = VXIcache_RESULT_SYSTEM_ERROR;
+    } else if ( _curSizeBytes.Get( ) > _highWaterBytes ) {
+      WakeCleaner( );
+    }
   }
 
   _entryReserve = 0;
@@ -196,38 +424,59 @@ void SBcacheManager::EntryRemoved()
   }
 }
 
-// Synchronized table and LRU list
+// Find the shard of the entry table for a key
+SBcacheManager::SBcacheEntryShard &
+SBcacheManager::GetShard(const SBcacheKey& key) const
+{
+  unsigned long hash = 0;
+  for (SBcacheKey::size_type i = 0; i < key.length(); i++)
+    hash = hash * 31 + (unsigned long) key[i];
+  return *_shards[hash % ENTRY_TABLE_SHARDS];
+}
+
+// Synchronized table and LRU list. Note that the preallocation above
+// is disabled, EntryAdded( ) and EntryRemoved( ) would need their own
+// lock now that each shard is locked separately.
 //
-bool SBcacheManager::InsertEntry(SBcacheEntry& entry)
+bool SBcacheManager::InsertEntry(SBcacheEntryShard& shard,
+				 SBcacheEntry& entry)
 {
   SBcacheEntryTable::value_type tableEntry (entry.GetKey(), entry);
-  if ( ! _entryTable.insert (tableEntry).second )
+  if ( ! shard.table.insert (tableEntry).second )
     return false;
-  _entryLRUList.push_back(entry);
+  shard.lruList.push_back(entry);
+  _numEntries.IncrementTest(1, ULONG_MAX);
   EntryAdded();
   return true;
 }
 
-void SBcacheManager::RemoveEntry(const SBcacheEntry& entry)
+void SBcacheManager::RemoveEntry(SBcacheEntryShard& shard,
+				 const SBcacheEntry& entry)
 {
-  SBcacheEntryTable::iterator te = _entryTable.find(entry.GetKey());
-  _entryTable.erase(te);
-  SBcacheEntryList::iterator vi = _entryLRUList.begin();
-  for (; vi != _entryLRUList.end(); ++vi)
+  SBcacheEntryTable::iterator te = shard.table.find(entry.GetKey());
+  shard.table.erase(te);
+  SBcacheEntryList::iterator vi = shard.lruList.begin();
+  for (; vi != shard.lruList.end(); ++vi)
     if (entry.Equivalent(*vi)) {
-      _entryLRUList.erase(vi);
+      shard.lruList.erase(vi);
       break;
     }
+  _numEntries.Decrement(1);
   EntryRemoved();
+
+  // The on-disk file goes with the last reference to the entry
+  entry.Invalidate();
+  AppendIndexDelete(entry.GetKey());
 }
 
-void SBcacheManager::TouchEntry(const SBcacheEntry& entry)
+void SBcacheManager::TouchEntry(SBcacheEntryShard& shard,
+				const SBcacheEntry& entry)
 {
-  SBcacheEntryList::iterator vi = _entryLRUList.begin();
-  for (; vi != _entryLRUList.end(); ++vi)
+  SBcacheEntryList::iterator vi = shard.lruList.begin();
+  for (; vi != shard.lruList.end(); ++vi)
     if (entry.Equivalent(*vi)) {
-      _entryLRUList.erase(vi);
-      _entryLRUList.push_back(entry);
+      shard.lruList.erase(vi);
+      shard.lruList.push_back(entry);
       break;
     }
 }
@@ -235,12 +484,14 @@ void SBcacheManager::TouchEntry(const SBcacheEntry& entry)
 
 //#######################################################################
 // Note about locking protocol.  THere are three locks in this code:
-//   A. The entrytable lock (_entryTableMutex)
+//   A. The entrytable lock (the mutex of the key's shard)
 //   B. a lock per entry  (GetSizeBytes, Open, Close)
 //   C. a lock of _curSizeBytes (atomic operations)
 // Currently, both locks A & C are held inside of lock B because an open
 // obtains a lock and holds it until the entry is closed.  Therefore,
 // a B lock must never be obtained while an A or C lock is held!
+// Only WriteIndex( ) holds more than one A lock, read locks taken in
+// shard order, and the index mutex is taken last of all.
 //#######################################################################
 
 // Open an entry
@@ -254,6 +505,7 @@ VXIcacheResult SBcacheManager::Open(VXIlogInterface       *log,
 				    VXIcacheStream       **stream)
 {
   VXIcacheResult rc = VXIcache_RESULT_SUCCESS;
+  SBcacheEntryShard &shard = GetShard (key);
 
   // Big loop where we attempt to open and re-open the cache entry for
   // as long as we get recoverable errors
@@ -262,7 +514,7 @@ VXIcacheResult SBcacheManager::Open(VXIlogInterface       *log,
     finalMode = mode;
     rc = VXIcache_RESULT_SUCCESS;
 
-    if ( _entryTableMutex.StartRead( ) != VXItrd_RESULT_SUCCESS ) {
+    if ( shard.mutex.StartRead( ) != VXItrd_RESULT_SUCCESS ) {
       Error (log, 110, L"%s%s", L"mutex", L"entry table mutex");
       return VXIcache_RESULT_SYSTEM_ERROR;
     }
@@ -270,15 +522,15 @@ VXIcacheResult SBcacheManager::Open(VXIlogInterface       *log,
     // Find the entry and open it, only need read permission
     bool entryOpened = false;
     SBcacheEntry entry;
-    SBcacheEntryTable::iterator vi = _entryTable.find (key);
-    if ( vi == _entryTable.end( ) ) {
+    SBcacheEntryTable::iterator vi = shard.table.find (key);
+    if ( vi == shard.table.end( ) ) {
       rc = VXIcache_RESULT_NOT_FOUND;
     } else {
       entry = (*vi).second;
       finalMode = (mode == CACHE_MODE_READ_CREATE ? CACHE_MODE_READ : mode);
     }
 
-    if ( _entryTableMutex.EndRead( ) != VXItrd_RESULT_SUCCESS ) {
+    if ( shard.mutex.EndRead( ) != VXItrd_RESULT_SUCCESS ) {
       Error (log, 111, L"%s%s", L"mutex", L"entry table mutex");
       rc = VXIcache_RESULT_SYSTEM_ERROR;
     }
@@ -289,13 +541,13 @@ VXIcacheResult SBcacheManager::Open(VXIlogInterface       *log,
       rc = VXIcache_RESULT_SUCCESS;
 
       // Get write permission
-      if ( _entryTableMutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
+      if ( shard.mutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
 	Error (log, 110, L"%s%s", L"mutex", L"entry table mutex");
 	rc = VXIcache_RESULT_SYSTEM_ERROR;
       } else {
 	// Try to find the entry again, it may have been created by now
-	vi = _entryTable.find (key);
-	if ( vi != _entryTable.end( ) ) {
+	vi = shard.table.find (key);
+	if ( vi != shard.table.end( ) ) {
 	  // Found it this time
 	  entry = (*vi).second;
 	  finalMode = (mode == CACHE_MODE_READ_CREATE ? CACHE_MODE_READ : mode);
@@ -322,7 +574,7 @@ VXIcacheResult SBcacheManager::Open(VXIlogInterface       *log,
 	    entryOpened = true;
 
 	    SBcacheEntryTable::value_type tableEntry (key, entry);
-	    if ( !InsertEntry(entry)) {
+	    if ( !InsertEntry(shard, entry)) {
 	      Error (log, 100, NULL);
 	      (*stream)->Close (true);
 	      *stream = NULL;
@@ -331,7 +583,7 @@ VXIcacheResult SBcacheManager::Open(VXIlogInterface       *log,
 	  }
 	}
 
-	if ( _entryTableMutex.Unlock( ) != VXItrd_RESULT_SUCCESS ) {
+	if ( shard.mutex.Unlock( ) != VXItrd_RESULT_SUCCESS ) {
 	  Error (log, 111, L"%s%s", L"mutex", L"entry table mutex");
 	  rc = VXIcache_RESULT_SYSTEM_ERROR;
 	}
@@ -367,13 +619,21 @@ VXIcacheResult SBcacheManager::Open(VXIlogInterface       *log,
     }
 
     // Accessed, so move it to the top of the LRU list
-    if ( _entryTableMutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
+    if ( shard.mutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
       Error (log, 110, L"%s%s", L"mutex", L"entry table mutex");
       rc = VXIcache_RESULT_SYSTEM_ERROR;
     } else {
-      if (rc == VXIcache_RESULT_SUCCESS)
-        TouchEntry(entry);
-      if ( _entryTableMutex.Unlock( ) != VXItrd_RESULT_SUCCESS ) {
+      if (rc == VXIcache_RESULT_SUCCESS) {
+        TouchEntry(shard, entry);
+
+        // Journal new or rewritten entries as in progress until
+        // CloseNotification( ). Reads are not journaled, the access
+        // order kept in the LRU lists is written when the index is
+        // compacted or written at shutdown.
+        if (finalMode == CACHE_MODE_WRITE)
+          AppendIndex(entry);
+      }
+      if ( shard.mutex.Unlock( ) != VXItrd_RESULT_SUCCESS ) {
         Error (log, 111, L"%s%s", L"mutex", L"entry table mutex");
         rc = VXIcache_RESULT_SYSTEM_ERROR;
       }
@@ -396,14 +656,6 @@ VXIcacheResult SBcacheManager::Open(VXIlogInterface       *log,
       ( mode == CACHE_MODE_READ_CREATE ) && ( finalMode == CACHE_MODE_WRITE ))
     rc = VXIcache_RESULT_ENTRY_CREATED;
 
-  // Maybe do cleanup, ignore all but fatal errors
-  VXIcacheResult rc2 = Cleanup (false, key);
-  if ( rc2 < VXIcache_RESULT_SUCCESS ) {
-    (*stream)->Close (true);
-    *stream = NULL;
-    rc = rc2;
-  }
-
   Diag (log, SBCACHE_MGR_TAGID, L"Open", L"%s: rc = %d", key.c_str( ), rc);
   return rc;
 }
@@ -422,14 +674,45 @@ SBcacheManager::WriteNotification (VXIlogInterface     *log,
   // configuring the cache with specific cache allocations on a
   // per-module basis
 
-  // Note that _curSizeBytes is a thread-safe object, intentionally
-  // ignore cleanup errors unless fatal
-  if ( _curSizeBytes.IncrementTest (nwritten, _maxSizeBytes) > 0 ) {
-    VXIcacheResult rc2 = Cleanup (true, key);
-    if ( rc2 < VXIcache_RESULT_SUCCESS )
-      rc = rc2;
+  // Note that _curSizeBytes is a thread-safe object. Eviction is left
+  // to the cleaner thread so that writers never wait on it, the cache
+  // may briefly exceed its size limit when writes outpace the cleaner.
+  if ( _curSizeBytes.IncrementTest (nwritten, _highWaterBytes) > 0 )
+    WakeCleaner( );
+
+  return rc;
+}
+
+
+// Notification of a completed write
+VXIcacheResult SBcacheManager::CloseNotification (VXIlogInterface     *log,
+						  const SBcacheKey    &key)
+{
+  VXIcacheResult rc = VXIcache_RESULT_SUCCESS;
+  SBcacheEntryShard &shard = GetShard (key);
+
+  // Record the entry with its final size. The entry lock can't be
+  // taken here (see the locking protocol note above), if another
+  // writer has opened the entry in the meantime it is recorded as in
+  // progress, which is right.
+  if ( shard.mutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
+    Error (log, 110, L"%s%s", L"mutex", L"entry table mutex");
+    rc = VXIcache_RESULT_SYSTEM_ERROR;
+  } else {
+    SBcacheEntryTable::iterator vi = shard.table.find (key);
+    if ( vi != shard.table.end( ) )
+      AppendIndex ((*vi).second);
+    else
+      rc = VXIcache_RESULT_NOT_FOUND;
+
+    if ( shard.mutex.Unlock( ) != VXItrd_RESULT_SUCCESS ) {
+      Error (log, 111, L"%s%s", L"mutex", L"entry table mutex");
+      rc = VXIcache_RESULT_SYSTEM_ERROR;
+    }
   }
 
+  Diag (log, SBCACHE_MGR_TAGID, L"CloseNotification", L"%s: rc = %d",
+	key.c_str( ), rc);
   return rc;
 }
 
@@ -439,20 +722,21 @@ VXIcacheResult SBcacheManager::Unlock(VXIlogInterface   *log,
 				      const SBcacheKey  &key)
 {
   VXIcacheResult rc = VXIcache_RESULT_SUCCESS;
+  SBcacheEntryShard &shard = GetShard (key);
 
-  if ( _entryTableMutex.StartRead( ) != VXItrd_RESULT_SUCCESS ) {
+  if ( shard.mutex.StartRead( ) != VXItrd_RESULT_SUCCESS ) {
     Error (log, 110, L"%s%s", L"mutex", L"entry table mutex");
     rc = VXIcache_RESULT_SYSTEM_ERROR;
   } else {
     // Find the entry and unlock it, only need read permission
-    SBcacheEntryTable::iterator vi = _entryTable.find (key);
-    if ( vi != _entryTable.end( ) ) {
+    SBcacheEntryTable::iterator vi = shard.table.find (key);
+    if ( vi != shard.table.end( ) ) {
       rc = (*vi).second.Unlock (log);
     } else {
       rc = VXIcache_RESULT_NOT_FOUND;
     }
 
-    if ( _entryTableMutex.EndRead( ) != VXItrd_RESULT_SUCCESS ) {
+    if ( shard.mutex.EndRead( ) != VXItrd_RESULT_SUCCESS ) {
       Error (log, 111, L"%s%s", L"mutex", L"entry table mutex");
       rc = VXIcache_RESULT_SYSTEM_ERROR;
     }
@@ -469,6 +753,7 @@ VXIcacheResult SBcacheManager::Delete(VXIlogInterface   *log,
 				      bool               haveEntryOpen)
 {
   VXIcacheResult rc = VXIcache_RESULT_SUCCESS;
+  SBcacheEntryShard &shard = GetShard (key);
 
   // Find the entry and delete it, only need read permission. Note
   // that we need to hold a reference to the entry in order to make
@@ -478,19 +763,19 @@ VXIcacheResult SBcacheManager::Delete(VXIlogInterface   *log,
   {
     SBcacheEntry entry;
 
-    if ( _entryTableMutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
+    if ( shard.mutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
       Error (log, 110, L"%s%s", L"mutex", L"entry table mutex");
       rc = VXIcache_RESULT_SYSTEM_ERROR;
     } else {
-      SBcacheEntryTable::iterator vi = _entryTable.find (key);
-      if ( vi != _entryTable.end( ) ) {
+      SBcacheEntryTable::iterator vi = shard.table.find (key);
+      if ( vi != shard.table.end( ) ) {
 	entry = (*vi).second;
-        RemoveEntry(entry);
+        RemoveEntry(shard, entry);
       } else {
 	rc = VXIcache_RESULT_NOT_FOUND;
       }
 
-      if ( _entryTableMutex.Unlock( ) != VXItrd_RESULT_SUCCESS ) {
+      if ( shard.mutex.Unlock( ) != VXItrd_RESULT_SUCCESS ) {
 	Error (log, 111, L"%s%s", L"mutex", L"entry table mutex");
 	rc = VXIcache_RESULT_SYSTEM_ERROR;
       }
@@ -516,9 +801,117 @@ VXIcacheResult SBcacheManager::WriteIndex( )
   VXIcacheResult rc = VXIcache_RESULT_SUCCESS;
   Diag (SBCACHE_MGR_TAGID, L"WriteIndex", L"entering");
 
-  // TBD write the index from the entry table, schedule periodically?
+  if ( _cacheDir.length( ) > 0 ) {
+    // Read lock every shard, in order, for a consistent view of the
+    // entry table, then lock the journal
+    int locked = 0;
+    while (( locked < ENTRY_TABLE_SHARDS ) &&
+	   ( _shards[locked]->mutex.StartRead( ) == VXItrd_RESULT_SUCCESS ))
+      locked++;
+
+    if ( locked < ENTRY_TABLE_SHARDS ) {
+      Error (110, L"%s%s", L"mutex", L"entry table mutex");
+      rc = VXIcache_RESULT_SYSTEM_ERROR;
+    } else if ( _indexMutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
+      Error (110, L"%s%s", L"mutex", L"index mutex");
+      rc = VXIcache_RESULT_SYSTEM_ERROR;
+    } else {
+      rc = CompactIndex( );
+      _indexCompact = false;
+
+      if ( _indexMutex.Unlock( ) != VXItrd_RESULT_SUCCESS ) {
+	Error (111, L"%s%s", L"mutex", L"index mutex");
+	rc = VXIcache_RESULT_SYSTEM_ERROR;
+      }
+    }
+
+    for (int i = 0; i < locked; i++) {
+      if ( _shards[i]->mutex.EndRead( ) != VXItrd_RESULT_SUCCESS ) {
+	Error (111, L"%s%s", L"mutex", L"entry table mutex");
+	rc = VXIcache_RESULT_SYSTEM_ERROR;
+      }
+    }
+  }
+
+  Diag (SBCACHE_MGR_TAGID, L"WriteIndex", L"exiting: rc = %d, %lu records",
+	rc, _indexRecords);
+  return rc;
+}
+
+
+// Order entries by last access for the index
+static bool IsLessRecentlyUsed(const SBcacheEntry &a, const SBcacheEntry &b)
+{
+  return ( a.GetLastAccessed( ) < b.GetLastAccessed( ) );
+}
+
+
+// Rewrite the index with one record per entry, the shards are read
+// locked and the index mutex is held
+VXIcacheResult SBcacheManager::CompactIndex( )
+{
+  VXIcacheResult rc = VXIcache_RESULT_SUCCESS;
+
+  // (1) Close the journal, the compacted index replaces it
+  if ( _indexFile ) {
+    fclose (_indexFile);
+    _indexFile = NULL;
+  }
+
+  // (2) Merge the LRU lists of the shards by last access
+  std::vector<SBcacheEntry> entries;
+  for (int i = 0; i < ENTRY_TABLE_SHARDS; i++)
+    entries.insert (entries.end( ), _shards[i]->lruList.begin( ),
+		    _shards[i]->lruList.end( ));
+  std::stable_sort (entries.begin( ), entries.end( ), IsLessRecentlyUsed);
+
+  // (3) Write a record per entry in LRU order to a temporary file
+  // then rename it over the index, so that a crash leaves either the
+  // old or the new index but never a partial one. Sizes are read
+  // without the entry lock as Cleanup( ) does, entries being written
+  // are recorded as in progress.
+  SBcacheNString indexPath (SBcachePath (_cacheDir,
+					 CACHE_INDEX_FILE_NAME).str( ));
+  SBcacheNString tempPath (indexPath + ".tmp");
+  FILE *fp = fopen (tempPath.c_str( ), "wb");
+  if ( ! fp ) {
+    LogIOError (217, tempPath);
+    rc = VXIcache_RESULT_IO_ERROR;
+  } else {
+    bool ok = (fprintf (fp, "%s\n", CACHE_INDEX_VERSION) >= 0);
+    VXIulong records = 0;
+    std::vector<SBcacheEntry>::const_iterator ei;
+    for (ei = entries.begin( ); ok && ei != entries.end( ); ++ei) {
+      SBcacheNString record (MakeIndexRecord (*ei));
+      ok = (fprintf (fp, "%s\n", record.c_str( )) >= 0);
+      records++;
+    }
+    if ( fclose (fp) != 0 )
+      ok = false;
+
+#ifdef WIN32
+    // rename( ) does not replace existing files on Windows
+    if ( ok )
+      remove (indexPath.c_str( ));
+#endif
+    if (( ! ok ) || ( rename (tempPath.c_str( ), indexPath.c_str( )) != 0 )) {
+      LogIOError (218, indexPath);
+      remove (tempPath.c_str( ));
+      rc = VXIcache_RESULT_IO_ERROR;
+    } else {
+      _indexRecords = records;
+    }
+  }
+
+  // (4) Reopen the index to append to the journal
+  if ( rc == VXIcache_RESULT_SUCCESS ) {
+    _indexFile = fopen (indexPath.c_str( ), "ab");
+    if ( ! _indexFile ) {
+      LogIOError (217, indexPath);
+      rc = VXIcache_RESULT_IO_ERROR;
+    }
+  }
 
-  Diag (SBCACHE_MGR_TAGID, L"WriteIndex", L"exiting: rc = %d", rc);
   return rc;
 }
 
@@ -529,16 +922,175 @@ VXIcacheResult SBcacheManager::ReadIndex(const SBcacheNString  &cacheDir)
   VXIcacheResult rc = VXIcache_RESULT_SUCCESS;
   Diag (SBCACHE_MGR_TAGID, L"ReadIndex", L"entering: %S", cacheDir.c_str( ));
 
-  // TBD, read the index to create the entry table
+  typedef std::list<SBcacheIndexRecord> SBcacheIndexList;
+  typedef std::map<SBcacheKey, SBcacheIndexList::iterator> SBcacheIndexMap;
+  SBcacheIndexList records;
+  SBcacheIndexMap recordTable;
+  VXIulong skipped = 0;
+
+  // (1) Replay the journal, a later record for a key replaces the
+  // earlier one and moves it to the most recently used end. A missing
+  // index is a cold start, lines cut short by a crash are skipped.
+  SBcacheNString indexPath (SBcachePath (cacheDir,
+					 CACHE_INDEX_FILE_NAME).str( ));
+  FILE *fp = fopen (indexPath.c_str( ), "rb");
+  if ( fp ) {
+    SBcacheNString line;
+    bool version1 = false;
+    if (( ! ReadIndexLine (fp, line) ) ||
+	(( line != CACHE_INDEX_VERSION ) &&
+	 ( ! (version1 = (line == CACHE_INDEX_VERSION_1)) ))) {
+      Error (219, L"%s%S", L"path", indexPath.c_str( ));
+    } else {
+      std::vector<SBcacheNString> fields;
+      while ( ReadIndexLine (fp, line) ) {
+	SplitIndexLine (line, fields);
+	SBcacheIndexRecord record;
+	VXIulong lastAccessed, lastModified;
+	// W records have no size field, path and key are the last two
+	bool isPut = (( fields.size( ) == 6 ) && ( fields[0] == "P" ) &&
+		      ( ParseIndexNumber (fields[3], record.sizeBytes) ));
+	bool isWrite = (( ! version1 ) &&
+			( fields.size( ) == 5 ) && ( fields[0] == "W" ));
+	if ( isWrite )
+	  record.sizeBytes = 0;
+	if (( isPut || isWrite ) &&
+	    ( ParseIndexNumber (fields[1], lastAccessed) ) &&
+	    ( ParseIndexNumber (fields[2], lastModified) ) &&
+	    ( GetPathSeqNum (fields[fields.size( ) - 2]) > 0 ) &&
+	    ( DecodeIndexKey (fields[fields.size( ) - 1], record.key) )) {
+	  record.path = fields[fields.size( ) - 2];
+	  record.complete = (isPut && (( ! version1 ) ||
+				       ( record.sizeBytes > 0 )));
+	  record.lastAccessed = static_cast<time_t>(lastAccessed);
+	  record.lastModified = static_cast<time_t>(lastModified);
+	  SBcacheIndexMap::iterator ri = recordTable.find (record.key);
+	  if ( ri != recordTable.end( ) ) {
+	    // A different path means the old file was replaced, this
+	    // can only happen when a delete record was lost
+	    if ( (*(*ri).second).path != record.path )
+	      remove (SBcachePath (cacheDir, (*(*ri).second).path).c_str( ));
+	    records.erase ((*ri).second);
+	  }
+	  recordTable[record.key] = records.insert (records.end( ), record);
+	} else if (( fields.size( ) == 2 ) && ( fields[0] == "D" ) &&
+		   ( DecodeIndexKey (fields[1], record.key) )) {
+	  SBcacheIndexMap::iterator ri = recordTable.find (record.key);
+	  if ( ri != recordTable.end( ) ) {
+	    records.erase ((*ri).second);
+	    recordTable.erase (ri);
+	  }
+	} else {
+	  skipped++;
+	}
+      }
+    }
+    fclose (fp);
+  }
+
+  // (2) Restore the entries in LRU order. Only the size of each file
+  // is checked, an entry that was being written, or whose file is
+  // missing or does not have the recorded size because it was replaced
+  // when the process stopped, has its file deleted.
+  VXIulong totalBytes = 0, maxSeqNum = 0, restored = 0;
+  SBcacheIndexList::const_iterator ri;
+  for (ri = records.begin( ); ri != records.end( ); ++ri) {
+    const SBcacheIndexRecord &record = *ri;
+    SBcachePath path (cacheDir, record.path);
+    VXIulong seqNum = GetPathSeqNum (record.path);
+    if ( seqNum > maxSeqNum )
+      maxSeqNum = seqNum;
 
-  // TBD, purge files with our extension that aren't in the index but
-  // are in the cache, warn about those without our extension
+    SBcacheStatInfo statInfo;
+    bool valid = (( record.complete ) &&
+		  ( SBcacheStat (path.str( ), &statInfo) ) &&
+		  ( ! SBcacheIsDir (statInfo) ) &&
+		  ( (VXIulong) statInfo.st_size == record.sizeBytes ));
+
+    SBcacheEntry entry;
+    if (( valid ) &&
+	( entry.Restore (GetLog( ), GetDiagBase( ),
+			 _refCntMutexPool.GetMutex( ), record.key, path,
+			 record.sizeBytes, record.lastModified,
+			 record.lastAccessed) == VXIcache_RESULT_SUCCESS ) &&
+	( InsertEntry (GetShard (record.key), entry) )) {
+      totalBytes += record.sizeBytes;
+      restored++;
+    } else {
+      remove (path.c_str( ));
+    }
+  }
 
-  Diag (SBCACHE_MGR_TAGID, L"ReadIndex", L"exiting: rc = %d", rc);
+  // (3) Account for the restored entries and make sure new entries
+  // don't reuse their paths
+  _curSizeBytes.Reset (totalBytes);
+  if ( maxSeqNum >= _pathSeqNum.Get( ) )
+    _pathSeqNum.Reset (maxSeqNum + 1);
+
+  Diag (SBCACHE_MGR_TAGID, L"ReadIndex",
+	L"exiting: rc = %d, restored %lu entries, %lu bytes, "
+	L"%lu records skipped", rc, restored, totalBytes, skipped);
   return rc;
 }
 
 
+// Append an entry record to the index journal
+void SBcacheManager::AppendIndex(const SBcacheEntry &entry)
+{
+  AppendIndexRecord (MakeIndexRecord (entry));
+}
+
+
+// Append a delete record to the index journal
+void SBcacheManager::AppendIndexDelete(const SBcacheKey &key)
+{
+  AppendIndexRecord ("D\t" + EncodeIndexKey (key));
+}
+
+
+// Append a record to the index journal, having it compacted once it
+// has grown well past the number of entries
+void SBcacheManager::AppendIndexRecord(const SBcacheNString &record)
+{
+  if ( _indexMutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
+    Error (110, L"%s%s", L"mutex", L"index mutex");
+    return;
+  }
+
+  // Each record is flushed so it survives a crash of the process. On
+  // an error stop journaling, the index replayed at the next startup
+  // is still consistent since entries are validated against their
+  // files.
+  if ( ! _indexFile ) {
+    // Not journaling
+  } else if (( fprintf (_indexFile, "%s\n", record.c_str( )) < 0 ) ||
+	     ( fflush (_indexFile) != 0 )) {
+    LogIOError (218, SBcachePath (_cacheDir, CACHE_INDEX_FILE_NAME).str( ));
+    fclose (_indexFile);
+    _indexFile = NULL;
+  } else if (( ++_indexRecords > CACHE_INDEX_COMPACT_MIN ) &&
+	     ( _indexRecords > CACHE_INDEX_COMPACT_RATIO * _numEntries.Get( ) ) &&
+	     ( ! _indexCompact )) {
+    // Compacting locks every shard while one is held here, so leave
+    // it to the cleaner thread
+    _indexCompact = true;
+    WakeCleaner( );
+  }
+
+  if ( _indexMutex.Unlock( ) != VXItrd_RESULT_SUCCESS )
+    Error (111, L"%s%s", L"mutex", L"index mutex");
+}
+
+
+// Error logging for the index file
+VXIlogResult SBcacheManager::LogIOError (VXIunsigned errorID,
+					 const SBcacheNString &path) const
+{
+  return Error (errorID, L"%s%S%s%S%s%d", L"path", path.c_str( ),
+		L"errnoStr", strerror(errno), L"errno", errno);
+}
+
+
 // Get a new path for an entry
 SBcachePath SBcacheManager::GetNewEntryPath(const SBcacheString &moduleName,
 					    const SBcacheKey    &key)
@@ -597,14 +1149,44 @@ SBcachePath SBcacheManager::GetNewEntryPath(const SBcacheString &moduleName,
   return path;
 }
 
+// Cleaner thread
+VXITRD_DEFINE_THREAD_FUNC(SBcacheManager::CleanerThread, userData)
+{
+  SBcacheManager *mgr = static_cast<SBcacheManager *>(userData);
+
+  // Sleep until woken by a writer, checking periodically as well in
+  // case the cache was over the high water mark with nothing to evict
+  while ( ! mgr->_cleanerExit ) {
+    VXItrdTimerSleep (mgr->_cleanerTimer, CACHE_CLEANER_INTERVAL_MS, NULL);
+    if ( ! mgr->_cleanerExit )
+      mgr->Cleanup( );
+    if (( ! mgr->_cleanerExit ) && ( mgr->_indexCompact ))
+      mgr->WriteIndex( );
+  }
+
+  return NULL;
+}
+
+
+// Wake the cleaner thread
+void SBcacheManager::WakeCleaner( )
+{
+  if ( _cleanerTimer )
+    VXItrdTimerWake (_cleanerTimer);
+}
+
+
 // Clean up the cache to eliminate expired entries and if neccessary
-// delete other entries to remain within the allocated size
-VXIcacheResult SBcacheManager::Cleanup (bool forcedCleanup, 
-    const SBcacheKey& writingKey)
+// delete other entries to remain within the allocated size. Runs once
+// the cache is over the high water mark and evicts down to the low
+// water mark, a batch at a time: the entry table lock is only held to
+// pick and remove each batch, the files are deleted once it has been
+// released.
+VXIcacheResult SBcacheManager::Cleanup( )
 {
   VXIcacheResult rc = VXIcache_RESULT_SUCCESS;
 
-  if (_curSizeBytes.Get() <= _maxSizeBytes)
+  if (_curSizeBytes.Get() <= _highWaterBytes)
     return rc;
 
   // Log to Mgr and Cleanup logs, and emit an warning the first time
@@ -624,51 +1206,69 @@ VXIcacheResult SBcacheManager::Cleanup (bool forcedCleanup,
     } 
   }
 
-  int bytesToExpire = _curSizeBytes.Get() - _lowWaterBytes;
-  time_t now = time(0);
-  SBcacheEntryTable::iterator vi;
-  SBcacheEntryList::iterator li;
-  SBcacheEntryList expiredEntries;
   VXIulong totalBytesFreed = 0;
-  time_t oldestAccessed = now;
   int entriesFreed = 0;
+  int idleShards = 0;
+
+  while (( idleShards < ENTRY_TABLE_SHARDS ) && ( ! _cleanerExit ) &&
+	 ( rc == VXIcache_RESULT_SUCCESS ) &&
+	 ( _curSizeBytes.Get( ) > _lowWaterBytes )) {
+    VXIulong bytesToExpire = _curSizeBytes.Get( ) - _lowWaterBytes;
+    time_t now = time(0);
+    time_t oldestAccessed = now;
+    SBcacheEntryList::iterator li;
+    SBcacheEntryList expiredEntries;
+    VXIulong batchBytes = 0;
+    int batchEntries = 0;
+
+    // (1) Lock the next shard in turn and transfer a batch of entries
+    // from its least recently used end to our temporary list, skipping
+    // those being written (size 0) or locked. Taking batches from the
+    // shards round robin approximates a global LRU order.
+    SBcacheEntryShard &shard = *_shards[_cleanupShard];
+    _cleanupShard = (_cleanupShard + 1) % ENTRY_TABLE_SHARDS;
+    if ( shard.mutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
+      Error (110, L"%s%s", L"mutex", L"entry table mutex");
+      rc = VXIcache_RESULT_SYSTEM_ERROR;
+    } else {
+      for (li = shard.lruList.begin();
+	   (li != shard.lruList.end()) && (batchBytes < bytesToExpire) &&
+	     (batchEntries < CACHE_CLEANUP_BATCH_ENTRIES); ++li) {
+	VXIulong entrySize = (*li).GetSizeBytes(true);
+	if (0 < entrySize && (*li).IsExpired(now, &oldestAccessed)) {
+	  expiredEntries.push_back(*li);
+	  batchBytes += entrySize;
+	  batchEntries++;
+	}
+      }
 
-  // Lock cache and transfer enough entries from the cache to our temporary
-  // list to get us below the cache low water mark.
-  // 
-  if ( _entryTableMutex.Lock( ) != VXItrd_RESULT_SUCCESS ) {
-    Error (110, L"%s%s", L"mutex", L"entry table mutex");
-    rc = VXIcache_RESULT_SYSTEM_ERROR;
-  } else {
-    // Copy entries to our temporary list
-    for (li = _entryLRUList.begin(); li != _entryLRUList.end(); ++li) {
-      if (bytesToExpire <= 0) break;
-      int entrySize = (*li).GetSizeBytes(true);
-      if ((*li).GetKey() != writingKey && 
-          0 < entrySize &&
-          (*li).IsExpired(now, &oldestAccessed)) {
-        expiredEntries.push_back(*li);
-        totalBytesFreed += entrySize;
-        bytesToExpire -= entrySize;
-        entriesFreed++;
+      // Remove them from cache
+      for (li = expiredEntries.begin(); li != expiredEntries.end(); ++li)
+	RemoveEntry(shard, *li);
+
+      if ( shard.mutex.Unlock( ) != VXItrd_RESULT_SUCCESS ) {
+	Error (111, L"%s%s", L"mutex", L"entry table mutex");
+	rc = VXIcache_RESULT_SYSTEM_ERROR;
       }
     }
 
-    // Remove them from cache
-    for (li = expiredEntries.begin(); li != expiredEntries.end(); ++li)
-      RemoveEntry(*li);
-
-    if ( _entryTableMutex.Unlock( ) != VXItrd_RESULT_SUCCESS ) {
-      Error (111, L"%s%s", L"mutex", L"entry table mutex");
-      rc = VXIcache_RESULT_SYSTEM_ERROR;
+    // (2) Now that we're outside the cache lock, actually remove all
+    // the entries by removing the last reference to them in our list.
+    expiredEntries.erase(expiredEntries.begin(), expiredEntries.end());
+    _curSizeBytes.Decrement(batchBytes);
+    totalBytesFreed += batchBytes;
+    entriesFreed += batchEntries;
+
+    // (3) Pause before the next batch, stop once no shard has anything
+    // left to evict
+    if ( batchEntries == 0 ) {
+      idleShards++;
+    } else {
+      idleShards = 0;
+      VXItrdTimerSleep (_cleanerTimer, CACHE_CLEANUP_BATCH_DELAY_MS, NULL);
     }
   }
 
-  // Now that we're outside the cache lock, actually remove all the
-  // entries by removing the last reference to them in our list.
-  expiredEntries.erase(expiredEntries.begin(), expiredEntries.end());
-  _curSizeBytes.Decrement(totalBytesFreed);
-
   // Log prior to setting the next cleanup time to ensure we log our
   // completion prior to another cleanup starting
   Diag (SBCACHE_MGR_TAGID, L"Cleanup",
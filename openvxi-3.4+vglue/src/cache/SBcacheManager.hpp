@@ -27,9 +27,11 @@
 #define _SBCACHE_MANAGER_H__
 
 #include <time.h>             // For time_t
+#include <stdio.h>            // For FILE
 #include <map>                // For STL map template class
 #include <list>
 
+#include "VXItrd.h"           // For VXItrdThread, VXItrdTimer
 #include "SBinetLogger.hpp"   // For SBinetLogger
 #include "SBcacheLog.h"       // For logging defines
 #include "SBcacheMisc.hpp"    // For SBcacheString, SBcacheKey, SBcachePath,
@@ -43,9 +45,14 @@ public:
   SBcacheManager(VXIlogInterface *log, VXIunsigned diagTagBase) : 
     SBinetLogger(MODULE_SBCACHE, log, diagTagBase), 
     _cacheDir(), _curSizeBytes(0), _maxSizeBytes(0), _entryMaxSizeBytes(0),
-    _pathSeqNum(1), 
-    _entryTableMutex(log, diagTagBase + SBCACHE_ET_MUTEX_TAGID), 
-    _refCntMutexPool(), _entryTable() { }
+    _lowWaterBytes(0), _highWaterBytes(0), _pathSeqNum(1), _numEntries(0),
+    _refCntMutexPool(), _indexMutex(), _indexFile(NULL), _indexRecords(0),
+    _indexCompact(false), _cleanerThread(NULL), _cleanerTimer(NULL),
+    _cleanerExit(false), _cleanupShard(0) {
+    for (int i = 0; i < ENTRY_TABLE_SHARDS; i++)
+      _shards[i] = new SBcacheEntryShard (log, diagTagBase +
+					  SBCACHE_ET_MUTEX_TAGID);
+  }
   virtual ~SBcacheManager( );
   
   // Create the manager
@@ -72,6 +79,10 @@ public:
 				    VXIulong             nwritten,
                                     const SBcacheKey    &key);
 
+  // Notification of a completed write, records the entry in the index
+  VXIcacheResult CloseNotification (VXIlogInterface     *log,
+				    const SBcacheKey    &key);
+
   // Unlock an entry
   VXIcacheResult Unlock(VXIlogInterface       *log,
 			const SBcacheKey      &key);
@@ -81,7 +92,8 @@ public:
 			const SBcacheKey      &key,
 			bool                   haveEntryOpen = false);
 
-  // Write out the index file, used to handle abnormal termination
+  // Write out the index file, used to handle abnormal termination.
+  // Compacts the index journal to one record per entry
   VXIcacheResult WriteIndex( );
 
   // Clear log resource to avoid crash during caught abnormal termination
@@ -91,13 +103,31 @@ private:
   // Read the index file, used at startup
   VXIcacheResult ReadIndex(const SBcacheNString  &cacheDir);
 
+  // Rewrite the index from the entry table, see WriteIndex( )
+  VXIcacheResult CompactIndex( );
+
+  // Append to the index journal, entry table shard mutex held for write
+  void AppendIndex(const SBcacheEntry &entry);
+  void AppendIndexDelete(const SBcacheKey &key);
+  void AppendIndexRecord(const SBcacheNString &record);
+
+  // Error logging for the index file
+  VXIlogResult LogIOError (VXIunsigned errorID,
+			   const SBcacheNString &path) const;
+
   // Get a new path for an entry
   SBcachePath GetNewEntryPath(const SBcacheString &moduleName,
 			      const SBcacheKey    &key);
 
   // Clean up the cache to eliminate expired entries and if neccessary
-  // delete other entries to remain within the allocated size
-  VXIcacheResult Cleanup (bool forcedCleanup, const SBcacheKey& writingKey);
+  // delete other entries to remain within the allocated size, only
+  // called from the cleaner thread
+  VXIcacheResult Cleanup( );
+
+  // Cleaner thread, and waking it when the cache is over its high
+  // water mark
+  static VXITRD_DEFINE_THREAD_FUNC(CleanerThread, userData);
+  void WakeCleaner( );
 
   // Disable the copy constructor and assignment operator
   SBcacheManager(const SBcacheManager &manager);
@@ -108,10 +138,29 @@ private:
   void EntryAdded();
   void EntryRemoved();
 
-  // Synchronize LRU list and lookup map
-  bool InsertEntry(SBcacheEntry& entry);
-  void RemoveEntry(const SBcacheEntry& entry);
-  void TouchEntry(const SBcacheEntry& entry);
+private:
+  // The entry table is split into shards by a hash of the key, each
+  // with its own lock and LRU list
+  enum { ENTRY_TABLE_SHARDS = 16 };
+
+  typedef std::map<SBcacheKey, SBcacheEntry> SBcacheEntryTable;
+  typedef std::list<SBcacheEntry> SBcacheEntryList;
+
+  struct SBcacheEntryShard {
+    SBcacheEntryShard(VXIlogInterface *log, VXIunsigned diagTagBase) :
+      mutex(log, diagTagBase), table(), lruList() { }
+
+    SBcacheReaderWriterMutex  mutex;
+    SBcacheEntryTable         table;
+    SBcacheEntryList          lruList;
+  };
+
+  SBcacheEntryShard & GetShard(const SBcacheKey& key) const;
+
+  // Synchronize LRU list and lookup map, shard mutex held for write
+  bool InsertEntry(SBcacheEntryShard& shard, SBcacheEntry& entry);
+  void RemoveEntry(SBcacheEntryShard& shard, const SBcacheEntry& entry);
+  void TouchEntry(SBcacheEntryShard& shard, const SBcacheEntry& entry);
 
 private:
   SBcacheNString           _cacheDir;
@@ -119,15 +168,25 @@ private:
   VXIulong                 _maxSizeBytes;
   VXIulong                 _entryMaxSizeBytes;
   VXIulong                 _lowWaterBytes;
+  VXIulong                 _highWaterBytes;
 
   SBcacheCounter           _pathSeqNum;
+  SBcacheCounter           _numEntries;
 
-  SBcacheReaderWriterMutex _entryTableMutex;
+  SBcacheEntryShard       *_shards[ENTRY_TABLE_SHARDS];
   SBcacheMutexPool         _refCntMutexPool;
-  typedef std::map<SBcacheKey, SBcacheEntry> SBcacheEntryTable;
-  typedef std::list<SBcacheEntry> SBcacheEntryList;
-  SBcacheEntryTable        _entryTable;
-  SBcacheEntryList          _entryLRUList;
+
+  // Index journal, one record per line, see SBcacheManager.cpp
+  SBcacheMutex             _indexMutex;
+  FILE                    *_indexFile;
+  VXIulong                 _indexRecords;
+  volatile bool            _indexCompact;
+
+  // Cleaner thread, sleeps on the timer between cleanups
+  VXItrdThread            *_cleanerThread;
+  VXItrdTimer             *_cleanerTimer;
+  volatile bool            _cleanerExit;
+  int                      _cleanupShard;
 
   // Reverse memory allocator, see note in .cpp file.
   struct SBcacheEntryEstimate { SBcacheEntryEstimate* next; char dummy[2048]; };
@@ -74,6 +74,10 @@ public:
   const SBcacheNString & str( ) const { return _path; }
   const char * const c_str( ) const { return _path.c_str( ); }
 
+  // Path relative to the base, as recorded in the cache index
+  SBcacheNString relative( ) const {
+    return (_path.length( ) > _baseLen ? _path.substr (_baseLen + 1) : ""); }
+
 private:
   SBcacheNString::size_type  _baseLen;
   SBcacheNString             _path;
@@ -104,6 +108,9 @@ public:
   // Close
   virtual VXIcacheResult Close(bool invalidate) = 0;
 
+  // Get the mode the stream was opened in
+  virtual VXIcacheOpenMode GetMode( ) const = 0;
+
   // Get the key name
   const SBcacheKey &GetKey( ) const { return _key; }
 
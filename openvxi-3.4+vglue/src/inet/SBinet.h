@@ -203,6 +203,37 @@ extern "C" {
  */
 #define SBINET_PERSISTENT_CONNECTIONS L"com.vocalocity.inet.usePersistentConnections"
 
+/**
+ * Property enabling the native HTTP client.  If this property is a
+ * VXIInteger with a non-zero value, http:// and https:// documents opened
+ * with INET_MODE_READ are fetched directly by SBinet over persistent
+ * connections, using the VXIcache interface passed to
+ * SBinetCreateResource( ) to store documents and revalidate them with
+ * conditional requests.  Otherwise, and for INET_MODE_FILE, documents
+ * are fetched through the voiceglue HTTP cache.  Cookies are not sent by
+ * the native client.  Defaults to 0.
+ */
+#define SBINET_NATIVE_HTTP L"com.vocalocity.inet.nativeHttp"
+
+/**
+ * Maximum number of idle persistent connections the native HTTP client
+ * keeps open per server (or proxy), shared by all resources.  This value
+ * must be a VXIInteger, 0 closes connections after each request.
+ * Defaults to 4.
+ */
+#define SBINET_CONNECTION_POOL_SIZE L"com.vocalocity.inet.connectionPoolSize"
+/** Default value for SBINET_CONNECTION_POOL_SIZE */
+#define SBINET_CONNECTION_POOL_SIZE_DEFAULT 4
+
+/**
+ * Number of seconds an idle persistent connection is kept for reuse by the
+ * native HTTP client, it should be below the keep-alive timeout of the
+ * servers.  This value must be a VXIInteger.  Defaults to 4.
+ */
+#define SBINET_CONNECTION_IDLE_TIMEOUT L"com.vocalocity.inet.connectionIdleTimeout"
+/** Default value for SBINET_CONNECTION_IDLE_TIMEOUT */
+#define SBINET_CONNECTION_IDLE_TIMEOUT_DEFAULT 4
+
 /** 
  * Default MIME type returned when it was not possible to determine the
  * MIME type of a file URI from its extension or when an HTTP server
@@ -55,6 +55,7 @@
 #include "SBinetProxyMatcher.hpp"
 #include "SBinetUtils.hpp"
 #include "SBinetHttpConnection.hpp"
+#include "SBinetHttpConnectionPool.hpp"
 #include "SBinetSSLsocket.hpp"
 
 #include <SWIList.hpp>
@@ -115,6 +116,8 @@ VXIint32 SBinetChannel::_pageLoadTimeout = SBINET_PAGE_LOADING_TIMEOUT_DEFAULT;
 VXIint32 SBinetChannel::_postContinueTimeout = SBINET_POST_CONTINUE_TIMEOUT_DEFAULT;
 SWIList SBinetChannel::_proxyMatcherList;
 bool SBinetChannel::_usePersistentConnections = true;
+bool SBinetChannel::_useNativeHttp = false;
+SBinetHttpConnectionPool *SBinetChannel::_connectionPool = NULL;
 SBinetString *SBinetChannel::_defaultMimeType = NULL;
 VXItrdMutex *SBinetChannel::_globalMapMutex = NULL;
 VXItrdMutex *SBinetChannel::_globalMD5Mutex = NULL;
@@ -125,7 +128,7 @@ SBinetChannel::SBinetChannel( VXIlogInterface* pVXILog,
 			      VXIunsigned diagLogBase,
                               VXIcacheInterface *pVXIcache):
   SWIutilLogger(MODULE_SBINET, pVXILog, diagLogBase), _cookieList(),
-  _jarChanged(true), _cookiesEnabled(false),
+  _jarChanged(true), _cookiesEnabled(false), _setCookieSeen(false),
   _connectionCount(0), _pVXILog(pVXILog), _pVXICache(pVXIcache),
   _echoStream(NULL)
 {
@@ -215,6 +218,28 @@ static VXIinetResult parseURL(const VXIchar *pszName,
   return rc;
 }
 
+// Gets the maximum age and staleness in seconds a cached copy may have
+// for the request, -1 when not specified.
+static void getCacheLimits(const VXIMap *properties,
+                           long& maxAge, long& maxStale)
+{
+  const VXIchar *caching = SBinetUtils::getString(properties, INET_CACHING);
+  if (caching != NULL && ::wcscmp(caching, INET_CACHING_SAFE) == 0)
+  {
+    maxAge = 0;
+    maxStale = 0;
+    return;
+  }
+
+  VXIint32 value;
+  maxAge = -1;
+  maxStale = -1;
+  if (SBinetUtils::getInteger(properties, INET_CACHE_CONTROL_MAX_AGE, value))
+    maxAge = value;
+  if (SBinetUtils::getInteger(properties, INET_CACHE_CONTROL_MAX_STALE, value))
+    maxStale = value;
+}
+
 
 /*
  * Prefetch: For now punt, eventually spawn thread to call Open() into /dev/null
@@ -300,13 +325,14 @@ VXIinetStream* SBinetChannel::createHttpStream(SBinetURL *url,
 
     url->appendQueryArgsToURL(queryArgs);
 
-    //  Because caching is broken, must not use it
-    /*
-    stream = new SBinetHttpCacheStream(url, method, this, getCache(),
-                                       GetLog(), GetDiagBase());
-    */
-    stream = new SBinetHttpStream(url, method, this, NULL,
-				  GetLog(), GetDiagBase());
+    // Documents are stored in the cache and revalidated with conditional
+    // requests once stale
+    if (getCache() != NULL)
+      stream = new SBinetHttpCacheStream(url, method, this, getCache(),
+                                         GetLog(), GetDiagBase());
+    else
+      stream = new SBinetHttpStream(url, method, this, NULL,
+                                    GetLog(), GetDiagBase());
   }
   else
   {
@@ -394,17 +420,87 @@ SBinetChannel::open(const VXIchar*   pszModuleName,
   const VXIchar *methodStr =
       SBinetUtils::getString(pProperties, INET_SUBMIT_METHOD);
   if (methodStr == NULL) {methodStr = INET_SUBMIT_METHOD_DEFAULT;};
+  bool readGet = ((eMode == INET_MODE_READ) &&
+		  (::wcscasecmp(methodStr, INET_SUBMIT_METHOD_GET) == 0));
+
+  //  Fetch http documents natively when enabled, voiceglue httpcache
+  //  still handles INET_MODE_FILE since it builds the parse trees.
+  //  Native requests carry no cookies, the call's cookie jar is kept
+  //  by voiceglue, so only GETs of calls without cookies go native.
+  if ((_useNativeHttp) && readGet && (!voiceglue_ipc_call_has_cookies()) &&
+      ((url->getProtocol() == SBinetURL::HTTP_PROTOCOL) ||
+       (url->getProtocol() == SBinetURL::HTTPS_PROTOCOL)))
+  {
+      _setCookieSeen = false;
+      rc = openNative(url, nFlags, pProperties, pmapStreamInfo, ppStream);
+      if (!_setCookieSeen)
+	return rc;
+
+      //  The response set a cookie that voiceglue's jar must keep, so
+      //  drop it unread (keeping it out of the cache) and fetch the
+      //  document again through voiceglue
+      if (voiceglue_loglevel() >= LOG_DEBUG)
+      {
+	  std::ostringstream logstring;
+	  logstring << "SBinetChannel::open(" << VXIchar_to_Std_String(pszName)
+		    << ") native response set a cookie, refetching";
+	  voiceglue_log ((char) LOG_DEBUG, logstring);
+      };
+      if (*ppStream != NULL)
+      {
+	  (*ppStream)->Close();
+	  delete (*ppStream);
+	  *ppStream = NULL;
+      };
+      rc = ::parseURL(pszName, pProperties, this, url);
+      if (rc != VXIinet_RESULT_SUCCESS)
+	return rc;
+  };
+
+  //  Reads and closes go to cachefile_fd when there is no stream
+  if (ppStream) *ppStream = NULL;
   const VXIMap *postdata_map =
       (const VXIMap *) VXIMapGetProperty (pProperties, INET_URL_QUERY_ARGS);
 
-  //  Use voiceglue httpcache
+  //  Use voiceglue httpcache, unless it recently reported the URL fresh
   std::string cachefile;
   std::string content_type;
   std::string parse_tree_addr;
-  voiceglue_http_get
-      (methodStr, url->getAbsolute(), postdata_map,
-       ((eMode == INET_MODE_FILE) ? 1 : 0),
-       cachefile, content_type, parse_tree_addr);
+  long maxAge, maxStale;
+  getCacheLimits(pProperties, maxAge, maxStale);
+  if (readGet &&
+      ((postdata_map == NULL) || (VXIMapNumProperties(postdata_map) == 0)) &&
+      voiceglue_http_fresh_lookup
+      (url->getAbsolute(), maxAge, maxStale, cachefile, content_type))
+  {
+      if (voiceglue_loglevel() >= LOG_DEBUG)
+      {
+	  std::ostringstream logstring;
+	  logstring << "SBinetChannel::open() using fresh cachefile=\""
+		    << cachefile << "\" for "
+		    << VXIchar_to_Std_String(url->getAbsolute());
+	  voiceglue_log ((char) LOG_DEBUG, logstring);
+      };
+  }
+  else if (readGet)
+  {
+      //  Concurrent GETs of the same URL by calls without cookies share
+      //  one fetch when voiceglue may cache it, a thread fetches by
+      //  itself if the shared one takes longer than its open timeout
+      VXIint32 timeoutOpen;
+      if (!SBinetUtils::getInteger(pProperties, INET_TIMEOUT_OPEN, timeoutOpen))
+	timeoutOpen = INET_TIMEOUT_OPEN_DEFAULT;
+      voiceglue_http_get_shared
+	  (url->getAbsolute(), postdata_map, timeoutOpen,
+	   cachefile, content_type);
+  }
+  else
+  {
+      voiceglue_http_get
+	  (methodStr, url->getAbsolute(), postdata_map,
+	   ((eMode == INET_MODE_FILE) ? 1 : 0),
+	   cachefile, content_type, parse_tree_addr);
+  };
 
   if (voiceglue_loglevel() >= LOG_DEBUG)
   {
@@ -486,33 +582,37 @@ SBinetChannel::open(const VXIchar*   pszModuleName,
 
   if( url ) delete url;    
   return VXIinet_RESULT_SUCCESS;
+}
 
-  /*
+
+/*
+ * Open through the native HTTP client, the stream takes ownership of url
+ */
+VXIinetResult
+SBinetChannel::openNative(SBinetURL*       url,
+                          VXIint32         nFlags,
+                          const VXIMap*    pProperties,
+                          VXIMap*          pmapStreamInfo,
+                          VXIinetStream**  ppStream)
+{
   if(!ppStream)
   {
     Error(200, L"%s%s%s%s", L"Operation", L"Open",
-          L"URL", (pszName != NULL) ? pszName : L"NULL");
+          L"URL", url->getAbsolute());
+    delete url;
     return(VXIinet_RESULT_INVALID_ARGUMENT);
   }
 
   Diag (MODULE_SBINET_CHANNEL_TAGID, L"SBinetChannel::Open",
-	L"(%s)", pszName != NULL ? pszName : L"NULL");
+	L"(%s) native", url->getAbsolute());
 
-  rc = createStream(url, pProperties, *ppStream);
+  SBinetString absoluteURL = url->getAbsolute();
+  VXIinetResult rc = createStream(url, pProperties, *ppStream);
   if (rc != VXIinet_RESULT_SUCCESS)
-    return rc;
-
-  //  Log to voiceglue
-  if (voiceglue_loglevel() >= LOG_DEBUG)
   {
-      std::ostringstream logstring;
-      logstring << "SBinetChannel::open:createStream("
-		<< VXIchar_to_Std_String(url->getAbsolute())
-		<< ") returns VXIinetStream="
-		<< Pointer_to_Std_String(*ppStream)
-		<< ", calling its VXIinetStream::Open()";
-      voiceglue_log ((char) LOG_DEBUG, logstring);
-  };
+    *ppStream = NULL;
+    return rc;
+  }
 
   rc = (*ppStream)->Open(nFlags, pProperties, pmapStreamInfo);
 
@@ -520,9 +620,9 @@ SBinetChannel::open(const VXIchar*   pszModuleName,
   if (voiceglue_loglevel() >= LOG_DEBUG)
   {
       std::ostringstream logstring;
-      logstring << "SBinetChannel::open("
-		<< VXIchar_to_Std_String(url->getAbsolute())
-		<< ") finished";
+      logstring << "SBinetChannel::openNative("
+		<< VXIchar_to_Std_String(absoluteURL.c_str())
+		<< ") returns " << rc;
       voiceglue_log ((char) LOG_DEBUG, logstring);
   };
 
@@ -536,11 +636,11 @@ SBinetChannel::open(const VXIchar*   pszModuleName,
      // no logging to perform.
      break;
    case VXIinet_RESULT_FETCH_TIMEOUT:
-     Error(228, L"%s%s", L"URL", url->getAbsolute());
+     Error(228, L"%s%s", L"URL", absoluteURL.c_str());
      // no break: intentional
    default:
      Error(204, L"%s%s%s%d",
-           L"URL", url->getAbsolute(),
+           L"URL", absoluteURL.c_str(),
            L"rc",rc);
      break;
   }
@@ -549,7 +649,6 @@ SBinetChannel::open(const VXIchar*   pszModuleName,
   *ppStream = NULL;
 
   return rc;
-  */
 }
 
 
@@ -564,36 +663,21 @@ SBinetChannel::close(VXIinetStream**  ppStream)
 		<< ") called";
       voiceglue_log ((char) LOG_DEBUG, logstring);
   };
+  //  Streams come from the native HTTP client
+  if ((ppStream != NULL) && (*ppStream != NULL))
+  {
+    VXIinetStream* st = *ppStream;
+    VXIinetResult err = st->Close();
+    delete st;
+    *ppStream = NULL;
+    return(err);
+  }
+
   if (cachefile_fd != -1)
   {
       ::close (cachefile_fd);
   };
   return VXIinet_RESULT_SUCCESS;
-
-  /*
-  if (ppStream == NULL)
-  {
-    Error(200, L"%s%s", L"Operation", L"Close");
-    return(VXIinet_RESULT_INVALID_ARGUMENT);
-  }
-  VXIinetStream* st = *ppStream;
-
-  VXIinetResult err;
-  if(st != NULL)
-  {
-    err = st->Close();
-    delete st;
-    st = NULL;
-  }
-  else
-  {
-    Error(200, L"%s%s", L"Operation", L"Close");
-    err = VXIinet_RESULT_INVALID_ARGUMENT;
-  }
-
-  *ppStream = NULL;
-  return(err);
-  */
 }
 
 
@@ -1456,6 +1540,29 @@ SBinetChannel::staticRead(/* [IN]  */ VXIinetInterface*      pThis,
     return VXIinet_RESULT_INVALID_ARGUMENT;
   }
 
+  //  Streams come from the native HTTP client
+  if (pStream != NULL)
+  {
+    VXIinetResult rc = (pStream->Read)(pBuffer, nBuflen, pnRead);
+
+    switch (rc)
+    {
+     case VXIinet_RESULT_SUCCESS:
+     case VXIinet_RESULT_WOULD_BLOCK:
+     case VXIinet_RESULT_END_OF_STREAM:
+       // no logging to perform.
+       break;
+     case VXIinet_RESULT_FETCH_TIMEOUT:
+       chan->Error(228, NULL);
+       // no break: intentional
+     default:
+       chan->Error(206, L"%s%d", L"rc", rc);
+       break;
+    }
+
+    return (rc);
+  }
+
   if (chan->cachefile_fd == -1)
   {
       return VXIinet_RESULT_INVALID_ARGUMENT;
@@ -1489,64 +1596,6 @@ SBinetChannel::staticRead(/* [IN]  */ VXIinetInterface*      pThis,
       return VXIinet_RESULT_END_OF_STREAM;
   };
   return VXIinet_RESULT_SUCCESS;
-
-  /*
-  VXIinetResult rc = VXIinet_RESULT_SUCCESS;
-  SBinetLogFunc apiTrace (chan->GetLog(), chan->GetDiagBase() +
-			  MODULE_SBINET_API_TAGID,
-			  L"SBinetChannel::Read", (int *) &rc,
-			  L"entering: 0x%p, 0x%p, %lu, %lu, 0x%p",
-			  pThis, pBuffer, nBuflen, pnRead, pStream);
-
-  if (pStream == NULL)
-  {
-    chan->Error(200, L"%s%s", L"Operation", L"Read");
-    return (rc = VXIinet_RESULT_INVALID_ARGUMENT);
-  }
-
-  //  Log to voiceglue
-  if (voiceglue_loglevel() >= LOG_INFO)
-  {
-      std::ostringstream logstring;
-      logstring << "SBinetChannel::staticRead("
-		<< Pointer_to_Std_String(pStream)
-		<< ","
-		<< nBuflen
-		<< ") started";
-      voiceglue_log ((char) LOG_INFO, logstring);
-  };
-
-  rc = (pStream->Read)(pBuffer,nBuflen, pnRead);
-
-  switch (rc)
-  {
-   case VXIinet_RESULT_SUCCESS:
-   case VXIinet_RESULT_WOULD_BLOCK:
-   case VXIinet_RESULT_END_OF_STREAM:
-     // no logging to perform.
-     break;
-   case VXIinet_RESULT_FETCH_TIMEOUT:
-     chan->Error(228, NULL);
-     // no break: intentional
-   default:
-     chan->Error(206, L"%s%d", L"rc", rc);
-     break;
-  }
-
-  //  Log to voiceglue
-  if (voiceglue_loglevel() >= LOG_INFO)
-  {
-      std::ostringstream logstring;
-      logstring << "SBinetChannel::staticRead("
-		<< Pointer_to_Std_String(pStream)
-		<< ","
-		<< nBuflen
-		<< ") finished";
-      voiceglue_log ((char) LOG_INFO, logstring);
-  };
-
-  return (rc);
-  */
 }
 
 
@@ -1796,6 +1845,18 @@ VXIinetResult SBinetChannel::init(const VXIMap *configParams, const SWIutilLogge
   SBinetUtils::getInteger(configParams, SBINET_PERSISTENT_CONNECTIONS, itmp);
   setUsePersistentConnections(itmp != 0);
 
+  itmp = 0;
+  SBinetUtils::getInteger(configParams, SBINET_NATIVE_HTTP, itmp);
+  setUseNativeHttp(itmp != 0);
+
+  VXIint32 poolSize = SBINET_CONNECTION_POOL_SIZE_DEFAULT;
+  SBinetUtils::getInteger(configParams, SBINET_CONNECTION_POOL_SIZE, poolSize);
+  VXIint32 idleTimeout = SBINET_CONNECTION_IDLE_TIMEOUT_DEFAULT;
+  SBinetUtils::getInteger(configParams, SBINET_CONNECTION_IDLE_TIMEOUT,
+                          idleTimeout);
+  if (_connectionPool == NULL)
+    _connectionPool = new SBinetHttpConnectionPool(poolSize, idleTimeout);
+
   if (SBinetSSLsocket::initialize() == 0)
     return VXIinet_RESULT_SUCCESS;
   else
@@ -1845,6 +1906,10 @@ void SBinetChannel::shutdown()
   // Destroy global MD5 mutex
   if( _globalMD5Mutex ) VXItrdMutexDestroy(&_globalMD5Mutex);
   _globalMD5Mutex = NULL;
+
+  // Close idle persistent connections
+  delete _connectionPool;
+  _connectionPool = NULL;
   
   SBinetSSLsocket::shutdown();
 }
@@ -2105,6 +2170,16 @@ bool SBinetChannel::getUsePersistentConnections()
   return _usePersistentConnections;
 }
 
+void SBinetChannel::setUseNativeHttp(bool flag)
+{
+  _useNativeHttp = flag;
+}
+
+bool SBinetChannel::getUseNativeHttp()
+{
+  return _useNativeHttp;
+}
+
 bool SBinetChannel::setPageLoadTimeout(VXIint32 timeout)
 {
   if (timeout <= 0)
@@ -2239,16 +2314,13 @@ SBinetHttpConnection *SBinetChannel::getHttpConnection(const SBinetURL *url,
 
   SWIipAddress remoteAddress(hostname, port, this);
 
-  // FIXME: This code should be protected by a Mutex once we have the cleaning
-  // thread
-  SBinetHttpConnection *conn = (SBinetHttpConnection *) _connectionMap.remove(remoteAddress);
+  // Idle connections are shared by all channels, the pool does the locking.
+  SBinetHttpConnection *conn = NULL;
+  if (!newConnection && _connectionPool != NULL)
+    conn = _connectionPool->get(url->getProtocol(), remoteAddress, usesProxy);
 
-  if (newConnection && conn)
-  {
-    delete conn;
-    conn = NULL;
-  }
-  // FIXME: End of code section that should be protected.
+  if (conn)
+    conn->setChannel(this);
 
   if (!conn)
   {
@@ -2272,15 +2344,10 @@ void SBinetChannel::putHttpConnection(SBinetHttpConnection *connection)
   };
 
   // Ideally, we should check whether we own the connection.
-
-  // FIXME: This code should be protected by a Mutex once we have the cleaning  thread
-  const SWIipAddress *addr = connection->getRemoteAddress();
-
-  SBinetHttpConnection *oldconn = (SBinetHttpConnection *)
-    _connectionMap.putValue(*addr, connection);
-  // FIXME: End of code section that should be protected.
-
-  delete oldconn;
+  if (_connectionPool != NULL)
+    _connectionPool->put(connection);
+  else
+    delete connection;
 }
 
 void SBinetChannel::closeHttpConnections()
@@ -2293,10 +2360,6 @@ void SBinetChannel::closeHttpConnections()
       voiceglue_log ((char) LOG_DEBUG, logstring);
   };
 
-  // Iterate saved connections and dispose of them all
-  SWIHashMap::Iterator it(_connectionMap);
-  while (it.hasNext()) {
-    const SBinetHttpConnection *conn = static_cast<const SBinetHttpConnection*>(it.next()->getValue());
-    delete conn;
-  }
+  // Connections handed back by putHttpConnection() are in the pool, they
+  // outlive the channel and are closed on SBinetShutDown().
 }
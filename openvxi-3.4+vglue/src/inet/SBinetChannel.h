@@ -45,6 +45,7 @@ class SWIoutputStream;
 class SWIinputStream;
 class SWIdataOutputStream;
 class SBinetHttpConnection;
+class SBinetHttpConnectionPool;
 class SBinetHttpCacheStream;
 class SBinetMD5;
 class VXItrdMutexRef;
@@ -79,6 +80,9 @@ class SBinetChannel : public VXIinetInterface, public SWIutilLogger
 
   bool cookiesEnabled() { return _cookiesEnabled; }
 
+  // Records that a native response tried to set a cookie
+  void setCookieSeen() { _setCookieSeen = true; }
+
   SBinetHttpConnection *getHttpConnection(const SBinetURL *url,
                                           const VXIMap *properties);
 
@@ -114,6 +118,9 @@ class SBinetChannel : public VXIinetInterface, public SWIutilLogger
   static bool getUsePersistentConnections();
   static void setUsePersistentConnections(bool f);
 
+  static bool getUseNativeHttp();
+  static void setUseNativeHttp(bool f);
+
   VXIinetResult closeAllStreams();
 
   VXIinetResult prefetch(/* [IN]  */ const VXIchar*   pszModuleName,
@@ -229,6 +236,12 @@ class SBinetChannel : public VXIinetInterface, public SWIutilLogger
 
   VXIinetStream* createHttpStream(SBinetURL *url, const VXIMap *properties);
 
+  VXIinetResult openNative(SBinetURL *url,
+                           VXIint32 nFlags,
+                           const VXIMap *pProperties,
+                           VXIMap *pmapStreamInfo,
+                           VXIinetStream **ppStream);
+
   VXIlogResult echoStreamWrite(const void *buffer, size_t buflen);
 
   //void eraseCookie(CookieList::iterator &vi);
@@ -238,13 +251,13 @@ class SBinetChannel : public VXIinetInterface, public SWIutilLogger
   static SWIList _proxyMatcherList;
   bool _jarChanged; // For GetCookieJar()
   bool _cookiesEnabled; // Enable or diable cookie usage
+  bool _setCookieSeen; // Native response set a cookie, see openNative
 
   VXIlogInterface *_pVXILog;
   VXIcacheInterface *_pVXICache;
 
   VXIlogStream *_echoStream;
 
-  SWIHashMap _connectionMap;
   int _connectionCount;
 
   std::string cachefile;
@@ -260,6 +273,8 @@ class SBinetChannel : public VXIinetInterface, public SWIutilLogger
   static VXIMap *_extensionRules;
   static SBinetNString *_userAgent;
   static bool _usePersistentConnections;
+  static bool _useNativeHttp;
+  static SBinetHttpConnectionPool *_connectionPool;
   static SBinetString *_defaultMimeType;
   
  private:  
@@ -0,0 +1,413 @@
+
+/****************License************************************************
+ * Vocalocity OpenVXI
+ * Copyright (C) 2004-2005 by Vocalocity, Inc. All Rights Reserved.
+ * vglue mods Copyright 2006,2007 Ampersand Inc., Doug Campbell
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ * Vocalocity, the Vocalocity logo, and VocalOS are trademarks or
+ * registered trademarks of Vocalocity, Inc.
+ * OpenVXI is a trademark of Scansoft, Inc. and used under license
+ * by Vocalocity.
+ ***********************************************************************/
+
+// Loopback test for the native HTTP path of SBinetChannel.  Two channels
+// fetch the same document from a local server: the connection opened by
+// the first is pooled and reused by the second, and the stale cached copy
+// is revalidated with a conditional request.  Documents that set a
+// cookie, and every document once the call has cookies, are fetched
+// through a stand-in for voiceglue instead.
+//
+//   SBinetChannelTest [cacheDir]
+
+#include "VXIlog.h"
+#include "VXIcache.h"
+#include "VXIinet.h"
+#include "VXItrd.h"
+#include "SBcache.h"
+#include "SBinet.h"
+#include <vglue_ipc.h>
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <wchar.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+static unsigned long failures = 0;
+
+#define CHECK(cond, what) \
+  do { if (!(cond)) { \
+    fprintf(stderr, "%s\n", what); \
+    failures++; } } while (0)
+
+static const char BODY[] = "<vxml version=\"2.0\"/>";
+static const char ETAG[] = "\"v1\"";
+static const char VGLUE_BODY[] = "<vxml version=\"2.0\"><!-- vg --></vxml>";
+
+// ............................................................ Log stub
+
+static VXIlogResult LogVError(VXIlogInterface *, const VXIchar *moduleName,
+                              VXIunsigned errorID, const VXIchar *format,
+                              va_list args)
+{
+  fprintf(stderr, "error %ls %u\n", moduleName, errorID);
+  return VXIlog_RESULT_SUCCESS;
+}
+
+static VXIlogResult LogError(VXIlogInterface *, const VXIchar *moduleName,
+                             VXIunsigned errorID, const VXIchar *format, ...)
+{
+  fprintf(stderr, "error %ls %u\n", moduleName, errorID);
+  return VXIlog_RESULT_SUCCESS;
+}
+
+static VXIlogResult LogVDiagnostic(VXIlogInterface *, VXIunsigned tagID,
+                                   const VXIchar *subtag,
+                                   const VXIchar *format, va_list args)
+{
+  return VXIlog_RESULT_SUCCESS;
+}
+
+static VXIlogResult LogDiagnostic(VXIlogInterface *, VXIunsigned tagID,
+                                  const VXIchar *subtag,
+                                  const VXIchar *format, ...)
+{
+  return VXIlog_RESULT_SUCCESS;
+}
+
+static VXIbool LogDiagnosticIsEnabled(VXIlogInterface *, VXIunsigned tagID)
+{
+  return FALSE;
+}
+
+static VXIint32 LogGetVersion(void)
+{
+  return VXI_CURRENT_VERSION;
+}
+
+// ...................................................... Loopback server
+
+struct Server {
+  int listener;
+  int connections;     // accepted connections
+  int requests;        // requests served
+  int notModified;     // 304 responses
+};
+
+// Reads one request from fd, returns false once the client closed it
+static bool ServeRequest(Server *server, int fd)
+{
+  char request[4096];
+  int len = 0;
+  while (len < (int) sizeof(request) - 1) {
+    int n = recv(fd, request + len, sizeof(request) - 1 - len, 0);
+    if (n <= 0) return false;
+    len += n;
+    request[len] = '\0';
+    if (strstr(request, "\r\n\r\n") != NULL) break;
+  }
+
+  char response[512];
+  server->requests++;
+  if (strstr(request, "If-None-Match: \"v1\"") != NULL) {
+    server->notModified++;
+    sprintf(response,
+            "HTTP/1.1 304 Not Modified\r\n"
+            "ETag: %s\r\n"
+            "Cache-Control: max-age=0\r\n"
+            "\r\n", ETAG);
+  }
+  else if (strncmp(request, "GET /cookie", 11) == 0) {
+    sprintf(response,
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: application/voicexml+xml\r\n"
+            "Content-Length: %d\r\n"
+            "Set-Cookie: session=1; path=/\r\n"
+            "Cache-Control: max-age=0\r\n"
+            "\r\n%s", (int) strlen(BODY), BODY);
+  }
+  else {
+    sprintf(response,
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: application/voicexml+xml\r\n"
+            "Content-Length: %d\r\n"
+            "ETag: %s\r\n"
+            "Cache-Control: max-age=0\r\n"
+            "\r\n%s", (int) strlen(BODY), ETAG, BODY);
+  }
+  send(fd, response, strlen(response), 0);
+  return true;
+}
+
+// Serves keep-alive connections until the listener is shut down
+static VXITRD_DEFINE_THREAD_FUNC(ServerThread, userData)
+{
+  Server *server = (Server *) userData;
+  int clients[16];
+  int numClients = 0;
+
+  for (;;) {
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(server->listener, &fds);
+    int maxfd = server->listener;
+    for (int i = 0; i < numClients; ++i) {
+      FD_SET(clients[i], &fds);
+      if (clients[i] > maxfd) maxfd = clients[i];
+    }
+    if (select(maxfd + 1, &fds, NULL, NULL, NULL) <= 0) break;
+
+    if (FD_ISSET(server->listener, &fds)) {
+      int fd = accept(server->listener, NULL, NULL);
+      if (fd < 0) break;
+      if (numClients < 16) {
+        clients[numClients++] = fd;
+        server->connections++;
+      }
+      else
+        close(fd);
+    }
+
+    for (int i = 0; i < numClients; ) {
+      if (FD_ISSET(clients[i], &fds) && !ServeRequest(server, clients[i])) {
+        close(clients[i]);
+        clients[i] = clients[--numClients];
+      }
+      else
+        ++i;
+    }
+  }
+
+  for (int i = 0; i < numClients; ++i) close(clients[i]);
+  VXItrdThreadExit(0);
+  return 0;
+}
+
+// .................................................... voiceglue stand-in
+
+struct Voiceglue {
+  int fd;              // our end of the interpreter's IPC socket
+  const char *path;    // file returned for every HttpGet
+  int requests;        // HttpGet requests answered
+};
+
+// Answers each HttpGet with path, telling the interpreter first that
+// the call now has cookies as voiceglue does once its jar fills.  An
+// empty message ends the call.
+static VXITRD_DEFINE_THREAD_FUNC(VoiceglueThread, userData)
+{
+  Voiceglue *vg = (Voiceglue *) userData;
+  char request[4096];
+  int len = 0;
+  bool done = false;
+
+  while (!done) {
+    int n = recv(vg->fd, request + len, sizeof(request) - 1 - len, 0);
+    if (n <= 0) break;
+    len += n;
+    request[len] = '\0';
+    char *eol;
+    while (!done && (eol = strchr(request, '\n')) != NULL) {
+      if (eol == request) {
+        done = true;
+        break;
+      }
+      char reply[512];
+      snprintf(reply, sizeof(reply), "%s%s text/plain\n",
+               (vg->requests++ == 0) ? "HttpCookies\n" : "", vg->path);
+      send(vg->fd, reply, strlen(reply), 0);
+      len -= (eol + 1 - request);
+      memmove(request, eol + 1, len + 1);
+    }
+  }
+
+  VXItrdThreadExit(0);
+  return 0;
+}
+
+// ............................................................... Fetch
+
+// Opens url on the channel and returns what was read into buf
+static VXIinetResult Fetch(VXIinetInterface *inet, const VXIchar *url,
+                           char *buf, VXIulong buflen)
+{
+  VXIMap *streamInfo = VXIMapCreate();
+  VXIinetStream *stream = NULL;
+  VXIinetResult rc = inet->Open(inet, L"SBinetChannelTest", url,
+                                INET_MODE_READ, 0, NULL, streamInfo,
+                                &stream);
+  VXIMapDestroy(&streamInfo);
+  buf[0] = '\0';
+  if (rc != VXIinet_RESULT_SUCCESS)
+    return rc;
+
+  VXIulong total = 0, nread = 0;
+  do {
+    nread = 0;
+    rc = inet->Read(inet, (VXIbyte *) buf + total, buflen - 1 - total,
+                    &nread, stream);
+    total += nread;
+  } while (rc == VXIinet_RESULT_SUCCESS && total < buflen - 1);
+  buf[total] = '\0';
+
+  inet->Close(inet, &stream);
+  return (rc == VXIinet_RESULT_END_OF_STREAM) ? VXIinet_RESULT_SUCCESS : rc;
+}
+
+
+int main(int argc, char *argv[])
+{
+  const VXIchar *cacheDir = L"SBinetChannelTestCache";
+  wchar_t dirArg[256];
+  if (argc > 1) {
+    swprintf(dirArg, 256, L"%hs", argv[1]);
+    cacheDir = dirArg;
+  }
+
+  VXIlogInterface log;
+  memset(&log, 0, sizeof(log));
+  log.GetVersion = LogGetVersion;
+  log.Error = LogError;
+  log.VError = LogVError;
+  log.Diagnostic = LogDiagnostic;
+  log.VDiagnostic = LogVDiagnostic;
+  log.DiagnosticIsEnabled = LogDiagnosticIsEnabled;
+
+  // (1) Loopback server on an ephemeral port
+  Server server;
+  memset(&server, 0, sizeof(server));
+  server.listener = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addrlen = sizeof(addr);
+  if (bind(server.listener, (struct sockaddr *) &addr, addrlen) != 0 ||
+      listen(server.listener, 5) != 0 ||
+      getsockname(server.listener, (struct sockaddr *) &addr, &addrlen) != 0) {
+    fprintf(stderr, "cannot listen on loopback\n");
+    return 1;
+  }
+
+  VXItrdThread *thread = NULL;
+  VXItrdThreadCreate(&thread, ServerThread, &server);
+
+  // (2) SBcache and SBinet with the native HTTP client
+  VXIMap *config = VXIMapCreate();
+  VXIMapSetProperty(config, SBINET_NATIVE_HTTP,
+                    (VXIValue *) VXIIntegerCreate(1));
+  VXIMapSetProperty(config, SBINET_CONNECTION_POOL_SIZE,
+                    (VXIValue *) VXIIntegerCreate(2));
+
+  VXIcacheInterface *cache = NULL;
+  VXIinetInterface *first = NULL, *second = NULL;
+  if (SBcacheInit(&log, 0, cacheDir, 10, 1, 3600, TRUE, 5) !=
+        VXIcache_RESULT_SUCCESS ||
+      SBcacheCreateResource(&log, &cache) != VXIcache_RESULT_SUCCESS ||
+      SBinetInitEx(&log, 0, config) != VXIinet_RESULT_SUCCESS ||
+      SBinetCreateResource(&log, cache, &first) != VXIinet_RESULT_SUCCESS ||
+      SBinetCreateResource(&log, cache, &second) != VXIinet_RESULT_SUCCESS) {
+    fprintf(stderr, "initialization failed\n");
+    return 1;
+  }
+  VXIMapDestroy(&config);
+
+  wchar_t url[128];
+  swprintf(url, 128, L"http://127.0.0.1:%d/doc.vxml", ntohs(addr.sin_port));
+  char buf[1024];
+
+  // (3) First fetch goes over the wire and fills the cache
+  CHECK(Fetch(first, url, buf, sizeof(buf)) == VXIinet_RESULT_SUCCESS,
+        "first fetch failed");
+  CHECK(strcmp(buf, BODY) == 0, "wrong body on first fetch");
+
+  // (4) The second channel revalidates over the pooled connection
+  CHECK(Fetch(second, url, buf, sizeof(buf)) == VXIinet_RESULT_SUCCESS,
+        "second fetch failed");
+  CHECK(strcmp(buf, BODY) == 0, "wrong body on revalidated fetch");
+
+  CHECK(server.requests == 2, "wrong request count");
+  CHECK(server.notModified == 1, "not revalidated with If-None-Match");
+  CHECK(server.connections == 1, "connection not reused across channels");
+
+  // (5) A document that sets a cookie is fetched again through
+  //     voiceglue, which keeps the call's cookie jar
+  int ipc[2];
+  char vgPath[256];
+  snprintf(vgPath, sizeof(vgPath), "%ls/vglue.vxml", cacheDir);
+  FILE *vgFile = fopen(vgPath, "w");
+  if (vgFile == NULL ||
+      fputs(VGLUE_BODY, vgFile) < 0 || fclose(vgFile) != 0 ||
+      socketpair(AF_UNIX, SOCK_STREAM, 0, ipc) != 0) {
+    fprintf(stderr, "cannot set up voiceglue stand-in\n");
+    return 1;
+  }
+  Voiceglue vg;
+  memset(&vg, 0, sizeof(vg));
+  vg.fd = ipc[1];
+  vg.path = vgPath;
+  VXItrdThread *vgThread = NULL;
+  VXItrdThreadCreate(&vgThread, VoiceglueThread, &vg);
+  voiceglue_registeripcfd(ipc[0], 1);
+
+  wchar_t cookieUrl[128];
+  swprintf(cookieUrl, 128, L"http://127.0.0.1:%d/cookie.vxml",
+           ntohs(addr.sin_port));
+  CHECK(Fetch(first, cookieUrl, buf, sizeof(buf)) == VXIinet_RESULT_SUCCESS,
+        "cookie fetch failed");
+  CHECK(strcmp(buf, VGLUE_BODY) == 0, "cookie fetch not refetched");
+  CHECK(server.requests == 3, "cookie fetch not tried natively");
+  CHECK(vg.requests == 1, "cookie fetch not sent to voiceglue");
+
+  // (6) Once the call has cookies nothing is fetched natively
+  CHECK(Fetch(first, url, buf, sizeof(buf)) == VXIinet_RESULT_SUCCESS,
+        "fetch with cookies failed");
+  CHECK(strcmp(buf, VGLUE_BODY) == 0, "fetch with cookies not via voiceglue");
+  CHECK(server.requests == 3, "fetch with cookies went native");
+  CHECK(vg.requests == 2, "fetch with cookies not sent to voiceglue");
+
+  voiceglue_unregisteripcfd();
+  close(ipc[0]);
+  VXItrdThreadArg vgStatus;
+  VXItrdThreadJoin(vgThread, &vgStatus, 5000);
+  VXItrdThreadDestroyHandle(&vgThread);
+  close(ipc[1]);
+  unlink(vgPath);
+
+  // (7) Pooled connections are closed on shutdown
+  SBinetDestroyResource(&first);
+  SBinetDestroyResource(&second);
+  SBinetShutDown(&log);
+  SBcacheDestroyResource(&cache);
+  SBcacheShutDown(&log);
+
+  shutdown(server.listener, SHUT_RDWR);
+  VXItrdThreadArg status;
+  VXItrdThreadJoin(thread, &status, 5000);
+  VXItrdThreadDestroyHandle(&thread);
+  close(server.listener);
+
+  if (failures > 0) {
+    fprintf(stderr, "%lu failures\n", failures);
+    return 1;
+  }
+  printf("SBinetChannelTest: all tests passed\n");
+  return 0;
+}
@@ -130,3 +130,19 @@ const SWIipAddress* SBinetHttpConnection::getRemoteAddress()
 {
   return &_remoteAddress;
 }
+
+void SBinetHttpConnection::setChannel(SBinetChannel *channel)
+{
+  _channel = channel;
+  _remoteAddress.setLogger(channel);
+  if (_socket != NULL)
+    _socket->setLogger(channel);
+}
+
+bool SBinetHttpConnection::isIdle()
+{
+  if (_socket == NULL) return false;
+
+  SWIinputStream *input = getInputStream();
+  return input != NULL && input->waitReady(0) == SWIstream::TIMED_OUT;
+}
@@ -70,6 +70,25 @@ class SBinetHttpConnection
     return _usesProxy;
   }
 
+  SBinetURL::Protocol getProtocol() const
+  {
+    return _protocol;
+  }
+
+  /**
+   * Hands the connection over to another channel, errors are logged
+   * through it.  NULL detaches the connection while it sits in the
+   * connection pool.
+   **/
+  void setChannel(SBinetChannel *channel);
+
+  /**
+   * Returns true if the connection is open with no pending input, as a
+   * persistent connection should be between requests.  An idle
+   * connection the server has closed reads as end of file.
+   **/
+  bool isIdle();
+
   /**
    * Destructor.
    **/
@@ -0,0 +1,150 @@
+
+/****************License************************************************
+ * Vocalocity OpenVXI
+ * Copyright (C) 2004-2005 by Vocalocity, Inc. All Rights Reserved.
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ * Vocalocity, the Vocalocity logo, and VocalOS are trademarks or
+ * registered trademarks of Vocalocity, Inc.
+ * OpenVXI is a trademark of Scansoft, Inc. and used under license
+ * by Vocalocity.
+ ***********************************************************************/
+
+#if _MSC_VER >= 1100    // Visual C++ 5.x
+#pragma warning( disable : 4786 4503 )
+#endif
+
+#include "SBinetHttpConnectionPool.hpp"
+#include "SBinetHttpConnection.hpp"
+#include <SWIipAddress.hpp>
+#include <stdio.h>
+
+// SBinetHttpConnectionPool::SBinetHttpConnectionPool
+// Refer to SBinetHttpConnectionPool.hpp for doc.
+SBinetHttpConnectionPool::SBinetHttpConnectionPool(int maxIdle,
+                                                   time_t idleTimeout):
+  _mutex(NULL), _idle(), _maxIdle(maxIdle), _idleTimeout(idleTimeout)
+{
+  VXItrdMutexCreate(&_mutex);
+}
+
+// SBinetHttpConnectionPool::~SBinetHttpConnectionPool
+// Refer to SBinetHttpConnectionPool.hpp for doc.
+SBinetHttpConnectionPool::~SBinetHttpConnectionPool()
+{
+  clear();
+  if (_mutex) VXItrdMutexDestroy(&_mutex);
+}
+
+std::string SBinetHttpConnectionPool::getKey(SBinetURL::Protocol protocol,
+                                             const SWIipAddress& remoteAddress,
+                                             bool usesProxy)
+{
+  const sockaddr_in *addr = &remoteAddress;
+  char key[64];
+  sprintf(key, "%d:%d:%lu:%d", (int) protocol, (int) usesProxy,
+          (unsigned long) ntohl(addr->sin_addr.s_addr),
+          remoteAddress.getport());
+  return key;
+}
+
+SBinetHttpConnection *
+SBinetHttpConnectionPool::get(SBinetURL::Protocol protocol,
+                              const SWIipAddress& remoteAddress,
+                              bool usesProxy)
+{
+  SBinetHttpConnection *conn = NULL;
+  IdleList discarded;
+  time_t now = time(NULL);
+
+  if (_mutex == NULL || VXItrdMutexLock(_mutex) != VXItrd_RESULT_SUCCESS)
+    return NULL;
+
+  IdleMap::iterator i = _idle.find(getKey(protocol, remoteAddress, usesProxy));
+  if (i != _idle.end())
+  {
+    // Take the most recently used connection still open, those idle for
+    // too long or closed by the server are closed outside the lock.
+    IdleList &idle = (*i).second;
+    while (conn == NULL && !idle.empty())
+    {
+      IdleConnection entry = idle.back();
+      idle.pop_back();
+      if (now - entry.idleSince <= _idleTimeout && entry.connection->isIdle())
+        conn = entry.connection;
+      else
+        discarded.push_back(entry);
+    }
+
+    if (idle.empty())
+      _idle.erase(i);
+  }
+
+  VXItrdMutexUnlock(_mutex);
+
+  for (IdleList::iterator d = discarded.begin(); d != discarded.end(); ++d)
+    delete (*d).connection;
+
+  return conn;
+}
+
+void SBinetHttpConnectionPool::put(SBinetHttpConnection *connection)
+{
+  SBinetHttpConnection *oldest = NULL;
+
+  // The last channel may go away while the connection is idle.
+  connection->setChannel(NULL);
+
+  if (_maxIdle <= 0 || _mutex == NULL ||
+      VXItrdMutexLock(_mutex) != VXItrd_RESULT_SUCCESS)
+  {
+    delete connection;
+    return;
+  }
+
+  IdleConnection entry;
+  entry.connection = connection;
+  entry.idleSince = time(NULL);
+
+  IdleList &idle = _idle[getKey(connection->getProtocol(),
+                                *connection->getRemoteAddress(),
+                                connection->usesProxy())];
+  idle.push_back(entry);
+  if ((int) idle.size() > _maxIdle)
+  {
+    oldest = idle.front().connection;
+    idle.pop_front();
+  }
+
+  VXItrdMutexUnlock(_mutex);
+
+  delete oldest;
+}
+
+void SBinetHttpConnectionPool::clear()
+{
+  IdleMap idle;
+
+  if (_mutex == NULL || VXItrdMutexLock(_mutex) != VXItrd_RESULT_SUCCESS)
+    return;
+  idle.swap(_idle);
+  VXItrdMutexUnlock(_mutex);
+
+  for (IdleMap::iterator i = idle.begin(); i != idle.end(); ++i)
+  {
+    IdleList &list = (*i).second;
+    for (IdleList::iterator d = list.begin(); d != list.end(); ++d)
+      delete (*d).connection;
+  }
+}
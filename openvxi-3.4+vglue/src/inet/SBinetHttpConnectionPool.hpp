@@ -0,0 +1,118 @@
+#ifndef SBINETHTTPCONNECTIONPOOL_HPP
+#define SBINETHTTPCONNECTIONPOOL_HPP
+
+/****************License************************************************
+ * Vocalocity OpenVXI
+ * Copyright (C) 2004-2005 by Vocalocity, Inc. All Rights Reserved.
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ * Vocalocity, the Vocalocity logo, and VocalOS are trademarks or
+ * registered trademarks of Vocalocity, Inc.
+ * OpenVXI is a trademark of Scansoft, Inc. and used under license
+ * by Vocalocity.
+ ***********************************************************************/
+
+#include "VXItrd.h"
+#include "SBinetURL.h"
+#include <time.h>
+#include <list>
+#include <map>
+#include <string>
+
+class SBinetHttpConnection;
+class SWIipAddress;
+
+/**
+ * Persistent HTTP connections kept open between requests, shared by
+ * all channels.
+ * @doc <p>
+ * Idle connections are keyed by protocol, remote address (that of the
+ * proxy when one is used) and whether they go through a proxy.  At most
+ * maxIdle connections are kept per key, the most recently used are
+ * handed out first, and those idle for more than idleTimeout seconds or
+ * closed by the server are discarded instead.  Pooled connections are
+ * detached from the channel that used them last.
+ **/
+
+class SBinetHttpConnectionPool
+{
+  // ................. CONSTRUCTORS, DESTRUCTOR  ............
+  //
+  // ------------------------------------------------------------
+  /**
+   * Default constructor.
+   **/
+ public:
+  SBinetHttpConnectionPool(int maxIdle, time_t idleTimeout);
+
+  /**
+   * Destructor, closes all idle connections.
+   **/
+ public:
+  virtual ~SBinetHttpConnectionPool();
+
+ public:
+  /**
+   * Removes an idle connection to the address from the pool and returns
+   * it, or NULL if there is none.  The caller owns the connection.
+   **/
+  SBinetHttpConnection *get(SBinetURL::Protocol protocol,
+                            const SWIipAddress& remoteAddress,
+                            bool usesProxy);
+
+  /**
+   * Returns a connection to the pool, the pool takes ownership.  The
+   * least recently used connection is closed if the pool is full.
+   **/
+  void put(SBinetHttpConnection *connection);
+
+  /**
+   * Closes all idle connections.
+   **/
+  void clear();
+
+  /**
+   * Disabled copy constructor.
+   **/
+ private:
+  SBinetHttpConnectionPool(const SBinetHttpConnectionPool&);
+
+  /**
+   * Disabled assignment operator.
+   **/
+ private:
+  SBinetHttpConnectionPool& operator=(const SBinetHttpConnectionPool&);
+
+ private:
+  struct IdleConnection
+  {
+    SBinetHttpConnection *connection;
+    time_t idleSince;
+  };
+
+  typedef std::list<IdleConnection> IdleList;
+  typedef std::map<std::string, IdleList> IdleMap;
+
+  static std::string getKey(SBinetURL::Protocol protocol,
+                            const SWIipAddress& remoteAddress,
+                            bool usesProxy);
+
+ private:
+  VXItrdMutex *_mutex;
+  IdleMap _idle;
+  int _maxIdle;
+  time_t _idleTimeout;
+};
+
+#endif
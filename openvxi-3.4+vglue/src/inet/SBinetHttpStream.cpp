@@ -786,6 +786,7 @@ void SBinetHttpStream::setCookieHandler(HeaderInfo *headerInfo,
                                         SBinetHttpStream *httpStream,
                                         VXIMap *streamInfo)
 {
+  httpStream->_channel->setCookieSeen();
   if (!httpStream->_channel->cookiesEnabled())
     return;
 
@@ -809,6 +810,7 @@ void SBinetHttpStream::setCookie2Handler(HeaderInfo *headerInfo,
                                          SBinetHttpStream *httpStream,
                                          VXIMap *streamInfo)
 {
+  httpStream->_channel->setCookieSeen();
   if (!httpStream->_channel->cookiesEnabled())
     return;
 
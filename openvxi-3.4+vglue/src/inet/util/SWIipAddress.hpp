@@ -126,6 +126,11 @@ class SWIUTIL_API_CLASS SWIipAddress : public sockaddr_in, public SWIHashable
  public:
   int setport(const char* sn, const char* pn="tcp");
   int sethostname(const char* hn);
+
+  void setLogger(SWIutilLogger *logger)
+  {
+    _logger = logger;
+  }
  protected:
   void herror(const char*) const;
 
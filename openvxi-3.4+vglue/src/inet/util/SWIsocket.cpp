@@ -376,6 +376,15 @@ SWIstream::Result SWIsocket::close()
   return SWIstream::SUCCESS;
 }
 
+void SWIsocket::setLogger(SWIutilLogger *logger)
+{
+  _logger = logger;
+  if (_remoteAddress != NULL)
+    _remoteAddress->setLogger(logger);
+  if (_localAddress != NULL)
+    _localAddress->setLogger(logger);
+}
+
 
 SWIinputStream *SWIsocket::getInputStream()
 {
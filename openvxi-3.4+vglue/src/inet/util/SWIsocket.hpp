@@ -275,6 +275,13 @@ class SWIUTIL_API_CLASS SWIsocket
  public:
   virtual SWIstream::Result close();
 
+  /**
+   * Changes the logger errors are reported to, for a socket handed over
+   * to a new owner.  NULL disables error reporting.
+   */
+ public:
+  void setLogger(SWIutilLogger *logger);
+
  protected:
   void error (const VXIchar *func, VXIunsigned errorId, int errorCode) const;
   void error (const VXIchar *func, VXIunsigned errorId,
@@ -48,6 +48,28 @@ class VXILong;
 extern "C" struct VXItrdMutex;
 #endif
 
+#include <stddef.h>                  // For size_t
+
+// Memory for values and their storage, taken from the calling thread's
+// arena while VXIValueArenaBegin( ) is in effect, else from the heap.
+// VXIValueAllocate( ) returns NULL on failure. See ValueArena.cpp.
+void *VXIValueAllocate (size_t size);
+void  VXIValueFree (void *ptr);
+
+// Atomic reference count updates for storage shared between threads,
+// WIN32 sources must include windows.h
+#ifdef WIN32
+#define REFCOUNT_INCREMENT(c)  InterlockedIncrement (&(c))
+#define REFCOUNT_DECREMENT(c)  InterlockedDecrement (&(c))
+#define REFCOUNT_ADD(c, n)     (InterlockedExchangeAdd (&(c), (n)) + (n))
+#define REFCOUNT_VALUE(c)      InterlockedCompareExchange (&(c), 0, 0)
+#else
+#define REFCOUNT_INCREMENT(c)  __sync_add_and_fetch (&(c), 1)
+#define REFCOUNT_DECREMENT(c)  __sync_sub_and_fetch (&(c), 1)
+#define REFCOUNT_ADD(c, n)     __sync_add_and_fetch (&(c), (n))
+#define REFCOUNT_VALUE(c)      __sync_fetch_and_add (&(c), 0)
+#endif
+
 
 /**
  * VXIValue base class
@@ -58,6 +80,11 @@ class VXIValue {
   VXIValue (VXIvalueType t) : type(t) { }
   virtual ~VXIValue( ) { }
 
+  // All values are allocated with VXIValueAllocate( ), NULL on failure
+  static void *operator new (size_t size) throw( ) {
+    return VXIValueAllocate (size); }
+  static void operator delete (void *ptr) { VXIValueFree (ptr); }
+
   // Get the value type
   VXIvalueType GetType( ) const { return type; }
 
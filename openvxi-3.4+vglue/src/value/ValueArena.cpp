@@ -0,0 +1,201 @@
+
+/****************License************************************************
+ * Vocalocity OpenVXI
+ * Copyright (C) 2004-2005 by Vocalocity, Inc. All Rights Reserved.
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ * Vocalocity, the Vocalocity logo, and VocalOS are trademarks or 
+ * registered trademarks of Vocalocity, Inc. 
+ * OpenVXI is a trademark of Scansoft, Inc. and used under license 
+ * by Vocalocity.
+ ***********************************************************************/
+
+#include <stdlib.h>
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>                 // For InterlockedIncrement/Decrement
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+#define VXIVALUE_EXPORTS
+#include "Value.hpp"
+
+
+/**
+ * Value allocation arenas
+ *
+ * While a thread has an arena scope open, small value allocations are
+ * carved sequentially out of large chunks instead of each going to
+ * the heap. Every allocation is preceded by a header naming its chunk
+ * (NULL for heap allocations). Frees from any thread atomically
+ * decrement the chunk's live count, which goes negative while the
+ * chunk is current; the owning thread counts its allocations privately
+ * and adds them in once when it retires the chunk. Whichever update
+ * brings the count to zero returns the chunk to the heap in one piece.
+ * Values that outlive the scope, or are freed by another thread, are
+ * thus safe, but each keeps its whole chunk around until destroyed;
+ * long lived values are created with the arena paused instead.
+ */
+
+// Chunk size, and the largest allocation taken from a chunk
+static const size_t ARENA_CHUNK_SIZE = 32768;
+static const size_t ARENA_MAX_ALLOCATION = 2048;
+
+struct VXIArenaChunk {
+  long    live;       // Allocations less frees, see above
+  long    allocated;  // Allocations, counted by the owner until retired
+  size_t  used;       // Bytes of the chunk handed out so far
+};
+
+union VXIArenaHeader {
+  VXIArenaChunk *chunk;       // Chunk holding the allocation, or NULL
+  double         align;       // Keeps what follows suitably aligned
+};
+
+// Round sizes up so that every header stays aligned
+#define ARENA_ROUND(n) \
+  (((n) + sizeof (VXIArenaHeader) - 1) & ~(sizeof (VXIArenaHeader) - 1))
+
+static const size_t ARENA_CHUNK_START = ARENA_ROUND (sizeof (VXIArenaChunk));
+
+// Per thread arena state
+static THREAD_LOCAL VXIArenaChunk *arenaChunk = NULL;
+static THREAD_LOCAL int            arenaDepth = 0;
+static THREAD_LOCAL int            arenaPaused = 0;
+
+
+// Owner is done allocating from the chunk
+static void RetireChunk (VXIArenaChunk *chunk)
+{
+  if (( chunk ) && ( REFCOUNT_ADD (chunk->live, chunk->allocated) == 0 ))
+    free (chunk);
+}
+
+
+void *VXIValueAllocate (size_t size)
+{
+  size_t need = sizeof (VXIArenaHeader) + ARENA_ROUND (size);
+  VXIArenaHeader *h;
+
+  if (( arenaDepth > 0 ) && ( arenaPaused == 0 ) &&
+      ( need <= ARENA_MAX_ALLOCATION )) {
+    if (( arenaChunk == NULL ) ||
+	( arenaChunk->used + need > ARENA_CHUNK_SIZE )) {
+      RetireChunk (arenaChunk);
+      arenaChunk = (VXIArenaChunk *) malloc (ARENA_CHUNK_SIZE);
+      if ( arenaChunk ) {
+	arenaChunk->live = 0;
+	arenaChunk->allocated = 0;
+	arenaChunk->used = ARENA_CHUNK_START;
+      }
+    }
+
+    // Falls back to the heap if no chunk could be allocated
+    if ( arenaChunk ) {
+      h = (VXIArenaHeader *) ((char *) arenaChunk + arenaChunk->used);
+      arenaChunk->used += need;
+      arenaChunk->allocated++;
+      h->chunk = arenaChunk;
+      return h + 1;
+    }
+  }
+
+  h = (VXIArenaHeader *) malloc (need);
+  if ( h == NULL )
+    return NULL;
+  h->chunk = NULL;
+  return h + 1;
+}
+
+
+void VXIValueFree (void *ptr)
+{
+  if ( ptr == NULL )
+    return;
+
+  VXIArenaHeader *h = ((VXIArenaHeader *) ptr) - 1;
+  if ( h->chunk ) {
+    if ( REFCOUNT_DECREMENT (h->chunk->live) == 0 )
+      free (h->chunk);
+  } else
+    free (h);
+}
+
+
+/**
+ * Begin a value allocation arena scope for the calling thread
+ *
+ * Until the matching VXIValueArenaEnd( ), values created by this
+ * thread are allocated from an arena that is released in bulk. Scopes
+ * may be nested, only the outermost one has an effect.
+ *
+ * @return   VXIvalue_RESULT_SUCCESS on success
+ */
+VXIVALUE_API VXIvalueResult VXIValueArenaBegin(void)
+{
+  arenaDepth++;
+  return VXIvalue_RESULT_SUCCESS;
+}
+
+
+/**
+ * End a value allocation arena scope for the calling thread
+ *
+ * @return   VXIvalue_RESULT_SUCCESS on success, VXIvalue_RESULT_FAILURE
+ *           if no scope is open
+ */
+VXIVALUE_API VXIvalueResult VXIValueArenaEnd(void)
+{
+  if ( arenaDepth <= 0 )
+    return VXIvalue_RESULT_FAILURE;
+
+  if ( --arenaDepth == 0 ) {
+    RetireChunk (arenaChunk);
+    arenaChunk = NULL;
+  }
+  return VXIvalue_RESULT_SUCCESS;
+}
+
+
+/**
+ * Suspend the calling thread's arena scope, if any
+ *
+ * Until the matching VXIValueArenaResume( ), values created by this
+ * thread come from the heap. Pauses may be nested.
+ *
+ * @return   VXIvalue_RESULT_SUCCESS on success
+ */
+VXIVALUE_API VXIvalueResult VXIValueArenaPause(void)
+{
+  arenaPaused++;
+  return VXIvalue_RESULT_SUCCESS;
+}
+
+
+/**
+ * Resume the calling thread's arena scope after VXIValueArenaPause( )
+ *
+ * @return   VXIvalue_RESULT_SUCCESS on success, VXIvalue_RESULT_FAILURE
+ *           if the arena is not paused
+ */
+VXIVALUE_API VXIvalueResult VXIValueArenaResume(void)
+{
+  if ( arenaPaused <= 0 )
+    return VXIvalue_RESULT_FAILURE;
+
+  arenaPaused--;
+  return VXIvalue_RESULT_SUCCESS;
+}
@@ -0,0 +1,1479 @@
+
+/****************License************************************************
+ * Vocalocity OpenVXI
+ * Copyright (C) 2004-2005 by Vocalocity, Inc. All Rights Reserved.
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ * Vocalocity, the Vocalocity logo, and VocalOS are trademarks or 
+ * registered trademarks of Vocalocity, Inc. 
+ * OpenVXI is a trademark of Scansoft, Inc. and used under license 
+ * by Vocalocity.
+ ***********************************************************************/
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>                 // For InterlockedIncrement/Decrement
+#endif
+
+#define VXIVALUE_EXPORTS
+#include "Value.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+// STL headers
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <new>
+
+// STL allocator drawing from VXIValueAllocate( ), so that string and
+// vector storage comes from the thread's value arena like the values
+template <class T>
+class VXIValueAllocator {
+ public:
+  typedef T          value_type;
+  typedef T *        pointer;
+  typedef const T *  const_pointer;
+  typedef T &        reference;
+  typedef const T &  const_reference;
+  typedef size_t     size_type;
+  typedef ptrdiff_t  difference_type;
+  template <class U> struct rebind { typedef VXIValueAllocator<U> other; };
+
+  VXIValueAllocator( ) { }
+  template <class U> VXIValueAllocator (const VXIValueAllocator<U> &) { }
+
+  pointer address (reference x) const { return &x; }
+  const_pointer address (const_reference x) const { return &x; }
+  size_type max_size( ) const { return ((size_type) -1) / sizeof (T); }
+
+  pointer allocate (size_type n, const void * = 0) {
+    void *p = ( n <= max_size( ) ? VXIValueAllocate (n * sizeof (T)) : NULL );
+    if ( p == NULL )
+      throw std::bad_alloc( );
+    return (pointer) p;
+  }
+  void deallocate (pointer p, size_type) { VXIValueFree (p); }
+  void construct (pointer p, const T &v) { new ((void *) p) T (v); }
+  void destroy (pointer p) { p->~T( ); }
+};
+
+template <class T, class U>
+bool operator== (const VXIValueAllocator<T> &, const VXIValueAllocator<U> &)
+{ return true; }
+template <class T, class U>
+bool operator!= (const VXIValueAllocator<T> &, const VXIValueAllocator<U> &)
+{ return false; }
+
+// Definition of string to use, based on VXIchar choice
+#define STL_STRING  std::basic_string<VXIchar, std::char_traits<VXIchar>, \
+                                      VXIValueAllocator<VXIchar> >
+#define STRNCPY     wcsncpy
+
+/**
+ * Real VXIString class
+ */
+
+class VXIString : public VXIValue {
+ public:
+  // Constructor and destructor
+  VXIString (const STL_STRING &v) : VXIValue (VALUE_STRING), value(v) { }
+  VXIString (const VXIchar * v, VXIunsigned u)
+    : VXIValue (VALUE_STRING), value(v, u) { }
+  virtual ~VXIString( ) { }
+
+  // Get the length of the string
+  VXIunsigned GetLength( ) const { return value.length( ); }
+
+  // Get and set the value
+  const STL_STRING &GetValue( ) const { return value; }
+  void SetValue (const STL_STRING &v) { value = v; }
+
+ private:
+  STL_STRING  value;
+};
+
+
+/**
+ * Shared map and vector bodies
+ *
+ * VXIMap and VXIVector are handles onto a reference counted body, in
+ * the same way VXIContent shares its VXIContentData.  Cloning a map or
+ * vector only adds a reference, the first modification through a
+ * handle whose body is shared copies that one level (cloning nested
+ * maps and vectors, which again only adds references), so cloning
+ * property trees costs nothing until one of the copies is written.
+ * Empty handles have no body at all.
+ *
+ * This relies on callers honoring the read-only contract of
+ * VXIMapGetProperty( ) and VXIVectorGetElement( ), nested values may
+ * be shared with other clones and must not be modified through casts.
+ */
+
+/**
+ * Real VXIMap and supporting classes
+ *
+ * Properties are held in a flat array of entries rather than a tree.
+ * Maps of up to INLINE_ENTRIES properties (the common case for
+ * property maps) keep that array inside the map body itself and are
+ * searched linearly, comparing hashes before keys.  Larger maps move
+ * the entries to the heap and add an open-addressing (linear probing)
+ * index from key hash to entry, kept at most half full.  Iteration
+ * still returns properties in key order, as the other backends do.
+ */
+
+struct VXIMapEntry {
+  const VXIchar *key;       // NULL terminated, an interned key or a copy
+  VXIunsigned    keyLen;    // Length of key in characters
+  VXIunsigned    hash;      // Hash of key, see HashKey( )
+  bool           ownsKey;   // Whether key is a copy to delete
+  VXIValue      *value;     // Owned value
+};
+
+
+// 32-bit FNV-1a over the characters of a key, also returning its length
+static VXIunsigned HashKey (const VXIchar *key, VXIunsigned *len)
+{
+  VXIunsigned h = 2166136261U;
+  const VXIchar *p;
+  for (p = key; *p; p++)
+    h = (h ^ (VXIunsigned) *p) * 16777619U;
+  *len = p - key;
+  return h;
+}
+
+
+/**
+ * Interned keys
+ *
+ * Well known property names registered with VXIMapInternKeys( ) are
+ * stored in maps by pointer instead of being copied, and lookups that
+ * pass the registered pointer itself match by pointer identity before
+ * any hashing or character comparison. The table is an open-addressing
+ * set written only during initialization, so reads are not locked.
+ */
+
+struct VXIInternKey {
+  const VXIchar *key;       // Caller's string, never freed
+  VXIunsigned    keyLen;
+  VXIunsigned    hash;
+};
+
+static VXIInternKey *internKeys = NULL;
+static VXIunsigned   internMask = 0;
+static VXIunsigned   internCount = 0;
+
+
+// Find the interned pointer for a key, NULL if it is not interned
+static const VXIchar *FindInternKey (const VXIchar *key, VXIunsigned len,
+				     VXIunsigned hash)
+{
+  if ( internKeys == NULL )
+    return NULL;
+
+  for (VXIunsigned s = hash & internMask; internKeys[s].key;
+       s = (s + 1) & internMask) {
+    const VXIInternKey &k = internKeys[s];
+    if (( k.key == key ) ||
+	(( k.hash == hash ) && ( k.keyLen == len ) &&
+	 ( wmemcmp (k.key, key, len) == 0 )))
+      return k.key;
+  }
+  return NULL;
+}
+
+// Helper class for VXIMap, the shared body
+class VXIMapData {
+ public:
+  enum { INLINE_ENTRIES = 8 };
+
+  // Constructor and destructor
+  VXIMapData( ) : refCount(1), entries(inlineEntries), count(0),
+    capacity(INLINE_ENTRIES), index(NULL), indexMask(0) { }
+  ~VXIMapData( );
+
+  // Copy constructor, on failure the copy has fewer entries
+  VXIMapData (const VXIMapData &m);
+
+  // Allocated with VXIValueAllocate( ), NULL on failure
+  static void *operator new (size_t size) throw( ) {
+    return VXIValueAllocate (size); }
+  static void operator delete (void *ptr) { VXIValueFree (ptr); }
+
+  // Add and remove references
+  static void AddRef  (VXIMapData *data);
+  static void Release (VXIMapData **data);
+  bool IsShared( ) { return ( REFCOUNT_VALUE (refCount) > 1 ); }
+
+  // Find the value for a key, NULL if not present
+  VXIValue *Get (const VXIchar *key) const;
+
+  // Set the value for a key, destroying any existing value. Interned
+  // keys are referenced, others are copied.
+  VXIvalueResult Set (const VXIchar *key, VXIValue *val);
+
+  // Delete the value for a key, VXIvalue_RESULT_FAILURE if not present
+  VXIvalueResult Delete (const VXIchar *key);
+
+  // Access properties by position, in no particular order
+  VXIunsigned Size( ) const { return count; }
+  const VXIMapEntry &Entry (VXIunsigned n) const { return entries[n]; }
+
+ private:
+  VXIunsigned FindPointer (const VXIchar *key) const;
+  VXIunsigned Find (const VXIchar *key, VXIunsigned len,
+		    VXIunsigned hash, VXIunsigned *slot) const;
+  bool Reserve (VXIunsigned n);
+  void IndexInsert (VXIunsigned n);
+  void IndexErase (VXIunsigned slot);
+
+  // Stub to prevent assignment operator use, use the copy constructor
+  VXIMapData & operator= (const VXIMapData &m);
+
+ private:
+  long           refCount;
+  VXIMapEntry   *entries;     // inlineEntries, or a heap array
+  VXIunsigned    count;       // Entries in use
+  VXIunsigned    capacity;    // Entries allocated
+  VXIunsigned   *index;       // NULL while entries are inline, else
+                              // indexMask + 1 slots, each 0 (empty) or
+                              // an entry number plus one
+  VXIunsigned    indexMask;
+  VXIMapEntry    inlineEntries[INLINE_ENTRIES];
+};
+
+static const VXIunsigned NOT_FOUND = (VXIunsigned) -1;
+
+
+VXIMapData::~VXIMapData( )
+{
+  // Must manually deep destroy values
+  for (VXIunsigned i = 0; i < count; i++) {
+    delete entries[i].value;
+    if ( entries[i].ownsKey )
+      VXIValueFree (const_cast<VXIchar *>(entries[i].key));
+  }
+  if ( entries != inlineEntries )
+    VXIValueFree (entries);
+  VXIValueFree (index);
+}
+
+
+VXIMapData::VXIMapData (const VXIMapData &m) : refCount(1),
+  entries(inlineEntries), count(0), capacity(INLINE_ENTRIES), index(NULL),
+  indexMask(0)
+{
+  if ( ! Reserve (m.count) )
+    return;
+
+  // Clone the values, which for maps and vectors only adds references
+  // to their bodies, and copy keys that are not interned. The index
+  // can usually be copied as is since entries keep their positions.
+  for (VXIunsigned i = 0; i < m.count; i++) {
+    const VXIMapEntry &src = m.entries[i];
+    VXIValue *v = VXIValueClone (src.value);
+    VXIchar *k = NULL;
+    if ( src.ownsKey ) {
+      k = (VXIchar *) VXIValueAllocate ((src.keyLen + 1) * sizeof (VXIchar));
+      if ( k )
+	wmemcpy (k, src.key, src.keyLen + 1);
+    }
+    if (( v == NULL ) || (( src.ownsKey ) && ( k == NULL ))) {
+      delete v;
+      VXIValueFree (k);
+      // Leave what was copied, indexing just that
+      if ( index )
+	for (VXIunsigned j = 0; j < count; j++)
+	  IndexInsert (j);
+      return;
+    }
+    entries[i] = src;
+    if ( k )
+      entries[i].key = k;
+    entries[i].value = v;
+    count++;
+  }
+  if (( index ) && ( indexMask == m.indexMask ))
+    memcpy (index, m.index, (indexMask + 1) * sizeof (VXIunsigned));
+  else if ( index )
+    for (VXIunsigned i = 0; i < count; i++)
+      IndexInsert (i);
+}
+
+
+void VXIMapData::AddRef (VXIMapData *data)
+{
+  if ( data )
+    REFCOUNT_INCREMENT (data->refCount);
+}
+
+
+void VXIMapData::Release (VXIMapData **data)
+{
+  if (( data ) && ( *data )) {
+    if ( REFCOUNT_DECREMENT ((*data)->refCount) == 0 )
+      delete *data;
+    *data = NULL;
+  }
+}
+
+
+VXIunsigned VXIMapData::FindPointer (const VXIchar *key) const
+{
+  // Interned keys are stored by pointer, so small maps can be searched
+  // for them without hashing. Large maps compare pointers in Find( ).
+  if ( index == NULL )
+    for (VXIunsigned i = 0; i < count; i++)
+      if ( entries[i].key == key )
+	return i;
+  return NOT_FOUND;
+}
+
+
+VXIunsigned VXIMapData::Find (const VXIchar *key, VXIunsigned len,
+			      VXIunsigned hash, VXIunsigned *slot) const
+{
+  if ( index == NULL ) {
+    for (VXIunsigned i = 0; i < count; i++) {
+      const VXIMapEntry &e = entries[i];
+      if (( e.hash == hash ) && ( e.keyLen == len ) &&
+	  (( e.key == key ) || ( wmemcmp (e.key, key, len) == 0 )))
+	return i;
+    }
+    return NOT_FOUND;
+  }
+
+  for (VXIunsigned s = hash & indexMask; index[s]; s = (s + 1) & indexMask) {
+    const VXIMapEntry &e = entries[index[s] - 1];
+    if (( e.key == key ) ||
+	(( e.hash == hash ) && ( e.keyLen == len ) &&
+	 ( wmemcmp (e.key, key, len) == 0 ))) {
+      if ( slot ) *slot = s;
+      return index[s] - 1;
+    }
+  }
+  return NOT_FOUND;
+}
+
+
+bool VXIMapData::Reserve (VXIunsigned n)
+{
+  if ( n <= capacity )
+    return true;
+
+  VXIunsigned newCapacity = capacity;
+  while ( newCapacity < n )
+    newCapacity *= 2;
+
+  VXIMapEntry *newEntries = (VXIMapEntry *)
+    VXIValueAllocate (newCapacity * sizeof (VXIMapEntry));
+  VXIunsigned *newIndex = (VXIunsigned *)
+    VXIValueAllocate (newCapacity * 2 * sizeof (VXIunsigned));
+  if (( newEntries == NULL ) || ( newIndex == NULL )) {
+    VXIValueFree (newEntries);
+    VXIValueFree (newIndex);
+    return false;
+  }
+
+  memcpy (newEntries, entries, count * sizeof (VXIMapEntry));
+  if ( entries != inlineEntries )
+    VXIValueFree (entries);
+  VXIValueFree (index);
+  entries = newEntries;
+  capacity = newCapacity;
+  index = newIndex;
+  indexMask = newCapacity * 2 - 1;
+  for (VXIunsigned s = 0; s <= indexMask; s++)
+    index[s] = 0;
+  for (VXIunsigned i = 0; i < count; i++)
+    IndexInsert (i);
+  return true;
+}
+
+
+void VXIMapData::IndexInsert (VXIunsigned n)
+{
+  VXIunsigned s = entries[n].hash & indexMask;
+  while ( index[s] )
+    s = (s + 1) & indexMask;
+  index[s] = n + 1;
+}
+
+
+void VXIMapData::IndexErase (VXIunsigned slot)
+{
+  // Backward shift deletion, so that no tombstones are needed: move
+  // up any later entry in the probe run that may not skip the hole
+  VXIunsigned hole = slot, s = slot;
+  for (;;) {
+    s = (s + 1) & indexMask;
+    if ( index[s] == 0 )
+      break;
+    VXIunsigned home = entries[index[s] - 1].hash & indexMask;
+    bool stays = ( hole <= s ) ? (( hole < home ) && ( home <= s )) :
+                                 (( hole < home ) || ( home <= s ));
+    if ( stays )
+      continue;
+    index[hole] = index[s];
+    hole = s;
+  }
+  index[hole] = 0;
+}
+
+
+VXIValue *VXIMapData::Get (const VXIchar *key) const
+{
+  VXIunsigned n = FindPointer (key);
+  if ( n == NOT_FOUND ) {
+    VXIunsigned len, hash = HashKey (key, &len);
+    n = Find (key, len, hash, NULL);
+  }
+  return ( n == NOT_FOUND ) ? NULL : entries[n].value;
+}
+
+
+VXIvalueResult VXIMapData::Set (const VXIchar *key, VXIValue *val)
+{
+  VXIunsigned len = 0, hash = 0;
+  VXIunsigned n = FindPointer (key);
+  if ( n == NOT_FOUND ) {
+    hash = HashKey (key, &len);
+    n = Find (key, len, hash, NULL);
+  }
+  if ( n != NOT_FOUND ) {
+    // Replace the value, the key stays where it is
+    delete entries[n].value;
+    entries[n].value = val;
+    return VXIvalue_RESULT_SUCCESS;
+  }
+
+  if (( count == capacity ) && ( ! Reserve (count + 1) ))
+    return VXIvalue_RESULT_OUT_OF_MEMORY;
+
+  const VXIchar *k = FindInternKey (key, len, hash);
+  bool ownsKey = ( k == NULL );
+  if ( ownsKey ) {
+    VXIchar *copy = (VXIchar *) VXIValueAllocate ((len + 1) * sizeof (VXIchar));
+    if ( copy == NULL )
+      return VXIvalue_RESULT_OUT_OF_MEMORY;
+    wmemcpy (copy, key, len + 1);
+    k = copy;
+  }
+
+  VXIMapEntry &e = entries[count];
+  e.key = k;
+  e.keyLen = len;
+  e.hash = hash;
+  e.ownsKey = ownsKey;
+  e.value = val;
+  if ( index )
+    IndexInsert (count);
+  count++;
+  return VXIvalue_RESULT_SUCCESS;
+}
+
+
+VXIvalueResult VXIMapData::Delete (const VXIchar *key)
+{
+  VXIunsigned len, hash = HashKey (key, &len), slot = 0;
+  VXIunsigned n = Find (key, len, hash, &slot);
+  if ( n == NOT_FOUND )
+    return VXIvalue_RESULT_FAILURE;
+
+  delete entries[n].value;
+  if ( entries[n].ownsKey )
+    VXIValueFree (const_cast<VXIchar *>(entries[n].key));
+  if ( index )
+    IndexErase (slot);
+
+  // Fill the gap with the last entry, repointing its index slot
+  VXIunsigned last = count - 1;
+  if ( n != last ) {
+    entries[n] = entries[last];
+    if ( index ) {
+      VXIunsigned s = entries[n].hash & indexMask;
+      while ( index[s] != last + 1 )
+	s = (s + 1) & indexMask;
+      index[s] = n + 1;
+    }
+  }
+  count--;
+  return VXIvalue_RESULT_SUCCESS;
+}
+
+
+class VXIMap : public VXIValue {
+ public:
+  // Constructor and destructor
+  VXIMap( ) : VXIValue (VALUE_MAP), data(NULL) { }
+  virtual ~VXIMap( ) { VXIMapData::Release (&data); }
+
+  // Copy constructor, shares the body
+  VXIMap (const VXIMap &m) : VXIValue (VALUE_MAP), data(m.data) {
+    VXIMapData::AddRef (data); }
+
+  // Read access
+  VXIValue *Get (const VXIchar *key) const {
+    return ( data ? data->Get (key) : NULL ); }
+  VXIunsigned Size( ) const { return ( data ? data->Size( ) : 0 ); }
+  const VXIMapEntry &Entry (VXIunsigned n) const { return data->Entry (n); }
+
+  // Write access, these first give this map a body of its own
+  VXIvalueResult Set (const VXIchar *key, VXIValue *val);
+  VXIvalueResult Delete (const VXIchar *key);
+  void Clear( ) { VXIMapData::Release (&data); }
+
+ private:
+  bool Unshare( );
+
+  // Stub to prevent assignment operator use, use the copy constructor
+  VXIMap & operator= (const VXIMap &m);
+
+ private:
+  VXIMapData  *data;         // NULL while empty
+};
+
+
+bool VXIMap::Unshare( )
+{
+  if ( data == NULL )
+    return (( data = new VXIMapData ) != NULL );
+  if ( ! data->IsShared( ) )
+    return true;
+
+  VXIMapData *copy = new VXIMapData (*data);
+  if (( copy == NULL ) || ( copy->Size( ) != data->Size( ) )) {
+    VXIMapData::Release (&copy);
+    return false;
+  }
+  VXIMapData::Release (&data);
+  data = copy;
+  return true;
+}
+
+
+VXIvalueResult VXIMap::Set (const VXIchar *key, VXIValue *val)
+{
+  if ( ! Unshare( ) )
+    return VXIvalue_RESULT_OUT_OF_MEMORY;
+  return data->Set (key, val);
+}
+
+
+VXIvalueResult VXIMap::Delete (const VXIchar *key)
+{
+  // Avoid copying a shared body when there is nothing to delete
+  if ( Get (key) == NULL )
+    return VXIvalue_RESULT_FAILURE;
+  if ( ! Unshare( ) )
+    return VXIvalue_RESULT_OUT_OF_MEMORY;
+  return data->Delete (key);
+}
+
+
+// Orders entry numbers of a map by key, for iteration
+class VXIMapKeyLess {
+ public:
+  VXIMapKeyLess (const VXIMap *m) : map(m) { }
+  bool operator() (VXIunsigned a, VXIunsigned b) const {
+    return wcscmp (map->Entry(a).key, map->Entry(b).key) < 0;
+  }
+ private:
+  const VXIMap *map;
+};
+
+
+class VXIMapIterator {
+ public:
+  // Constructor and destructor
+  VXIMapIterator(const VXIMap *m) : 
+    map(m), order(inlineOrder), pos(0), size(m->Size( )) {
+    if (( size > VXIMapData::INLINE_ENTRIES ) &&
+	( (order = new VXIunsigned [size]) == NULL )) {
+      order = inlineOrder;
+      size = 0;
+    }
+    for (VXIunsigned i = 0; i < size; i++)
+      order[i] = i;
+    std::sort (order, order + size, VXIMapKeyLess (map));
+  }
+  virtual ~VXIMapIterator( ) {
+    if ( order != inlineOrder )
+      delete [] order;
+  }
+
+  // Get the key and value at the iterator's position
+  VXIvalueResult GetKeyValue (const VXIchar **key, 
+			      const VXIValue **value) const {
+    if (( pos >= size ) || ( order[pos] >= map->Size( ) )) {
+      *key = NULL;
+      *value = NULL;
+      return VXIvalue_RESULT_FAILURE;
+    }
+
+    const VXIMapEntry &e = map->Entry (order[pos]);
+    *key = e.key;
+    *value = e.value;
+    return VXIvalue_RESULT_SUCCESS;
+  }
+
+  // Increment the iterator
+  VXIMapIterator &operator++(int) { 
+    if ( pos < size )
+      pos++; 
+    return *this; }
+
+ private:
+  // Stubs to prevent copy constructor and assignment operator use
+  VXIMapIterator (const VXIMapIterator &it);
+  VXIMapIterator & operator= (const VXIMapIterator &it);
+
+ private:
+  const VXIMap  *map;
+  VXIunsigned   *order;       // Entry numbers in key order
+  VXIunsigned    pos;
+  VXIunsigned    size;
+  VXIunsigned    inlineOrder[VXIMapData::INLINE_ENTRIES];
+};
+
+
+/**
+ * Real VXIVector and supporting classes
+ */
+
+// Helper class for VXIVector, the shared body
+class VXIVectorData {
+ public:
+  // Constructor and destructor
+  VXIVectorData( ) : container( ), refCount(1) { }
+  ~VXIVectorData( );
+
+  // Copy constructor, on failure the copy has fewer elements
+  VXIVectorData (const VXIVectorData &v);
+
+  // Allocated with VXIValueAllocate( ), NULL on failure
+  static void *operator new (size_t size) throw( ) {
+    return VXIValueAllocate (size); }
+  static void operator delete (void *ptr) { VXIValueFree (ptr); }
+
+  // Add and remove references
+  static void AddRef  (VXIVectorData *data);
+  static void Release (VXIVectorData **data);
+  bool IsShared( ) { return ( REFCOUNT_VALUE (refCount) > 1 ); }
+
+ public:
+  typedef std::vector<VXIValue *, VXIValueAllocator<VXIValue *> > VECTOR;
+  VECTOR container;
+
+ private:
+  // Stub to prevent assignment operator use, use the copy constructor
+  VXIVectorData & operator= (const VXIVectorData &v);
+
+ private:
+  long  refCount;
+};
+
+
+VXIVectorData::~VXIVectorData( )
+{
+  // Must manually deep destroy values
+  VECTOR::iterator vi;
+  for (vi = container.begin( ); vi != container.end( ); vi++)
+    delete *vi;
+}
+
+
+VXIVectorData::VXIVectorData (const VXIVectorData &v) : container(),
+  refCount(1)
+{
+  // Clone the values, which for maps and vectors only adds references
+  // to their bodies
+  container.reserve (v.container.size( ));
+  VECTOR::const_iterator vi;
+  for (vi = v.container.begin( ); vi != v.container.end( ); vi++) {
+    VXIValue *v = VXIValueClone (*vi);
+    if ( v ) {
+      container.push_back(v);
+    } else {
+      return;
+    }
+  }
+}
+
+
+void VXIVectorData::AddRef (VXIVectorData *data)
+{
+  if ( data )
+    REFCOUNT_INCREMENT (data->refCount);
+}
+
+
+void VXIVectorData::Release (VXIVectorData **data)
+{
+  if (( data ) && ( *data )) {
+    if ( REFCOUNT_DECREMENT ((*data)->refCount) == 0 )
+      delete *data;
+    *data = NULL;
+  }
+}
+
+
+class VXIVector : public VXIValue {
+ public:
+  // Constructor and destructor
+  VXIVector( ) : VXIValue (VALUE_VECTOR), data(NULL) { }
+  virtual ~VXIVector( ) { VXIVectorData::Release (&data); }
+
+  // Copy constructor, shares the body
+  VXIVector (const VXIVector &v) : VXIValue (VALUE_VECTOR), data(v.data) {
+    VXIVectorData::AddRef (data); }
+
+  // Read access
+  VXIunsigned Length( ) const {
+    return ( data ? data->container.size( ) : 0 ); }
+  VXIValue *Get (VXIunsigned n) const { return data->container[n]; }
+
+  // Write access, these first give this vector a body of its own
+  VXIvalueResult Add (VXIValue *val);
+  VXIvalueResult Set (VXIunsigned n, VXIValue *val);
+
+ private:
+  bool Unshare( );
+
+  // Stub to prevent assignment operator use, use the copy constructor
+  VXIVector & operator= (const VXIVector &v);
+
+ private:
+  VXIVectorData  *data;      // NULL while empty
+};
+
+
+bool VXIVector::Unshare( )
+{
+  if ( data == NULL )
+    return (( data = new VXIVectorData ) != NULL );
+  if ( ! data->IsShared( ) )
+    return true;
+
+  VXIVectorData *copy = new VXIVectorData (*data);
+  if (( copy == NULL ) ||
+      ( copy->container.size( ) != data->container.size( ) )) {
+    VXIVectorData::Release (&copy);
+    return false;
+  }
+  VXIVectorData::Release (&data);
+  data = copy;
+  return true;
+}
+
+
+VXIvalueResult VXIVector::Add (VXIValue *val)
+{
+  if ( ! Unshare( ) )
+    return VXIvalue_RESULT_OUT_OF_MEMORY;
+  data->container.push_back (val);
+  return VXIvalue_RESULT_SUCCESS;
+}
+
+
+VXIvalueResult VXIVector::Set (VXIunsigned n, VXIValue *val)
+{
+  if ( ! Unshare( ) )
+    return VXIvalue_RESULT_OUT_OF_MEMORY;
+  delete data->container[n];
+  data->container[n] = val;
+  return VXIvalue_RESULT_SUCCESS;
+}
+
+
+/**
+ * Create a String from a null-terminated character array
+ *
+ * @param   str   NULL-terminated character array
+ * @return        String with the specified value on success, 
+ *                NULL otherwise
+ */
+VXIVALUE_API VXIString *VXIStringCreate(const VXIchar *str)
+{
+  if ( str == NULL )
+    return NULL;
+
+  return new VXIString (str);
+}
+
+
+/**
+ * Create a String from a known-length character array
+ *
+ * @param   str   Character array (null characters may be embedded in 
+ *                the array)
+ * @param   len   Number of characters which will be copied.
+ * @return        String with the specified value on success, 
+ *                NULL otherwise
+ */
+VXIVALUE_API VXIString *VXIStringCreateN(const VXIchar *str, VXIunsigned len)
+{
+  if ( str == NULL )
+    return NULL;
+
+  return new VXIString (str, len);
+}
+
+
+/**
+ * String destructor
+ *
+ * @param   s   String to destroy
+ */
+VXIVALUE_API void VXIStringDestroy(VXIString **s)
+{
+  if (( s ) && ( *s ) && ( (*s)->GetType( ) == VALUE_STRING )) {
+    delete *s;
+    *s = NULL;
+  }
+}
+
+
+/**
+ * String clone
+ *
+ * Note: functionally redundant with VXIValueClone( ), but provided to
+ * reduce the need for C casts for this common operation
+ *
+ * @param    s   String to clone
+ * @return       Clone of the string on success, NULL otherwise
+ */
+VXIVALUE_API VXIString *VXIStringClone(const VXIString *s)
+{
+  if (( s == NULL ) || ( s->GetType( ) != VALUE_STRING ))
+    return NULL;
+
+  return new VXIString (*s);
+}
+
+
+/**
+ * Set the value of a String from a null-terminated character array
+ *
+ * Note: this functionality is provided to allow defining interfaces
+ * where the caller passes in a VXIString from VXIStringCreate( )
+ * (typically with an empty string as its value) with the interface
+ * changing that value to return a string as output. This avoids
+ * having to define interfaces where the client has to provide a
+ * fixed length buffer (and thus worry about "buffer too small" errors
+ * and complicated handling).
+ *
+ * @param   s     String to change the value of
+ * @param   str   NULL-terminated character array
+ * @return        VXIvalue_RESULT_SUCCESS on success 
+ */
+VXIVALUE_API VXIvalueResult VXIStringSetValue(VXIString      *s, 
+					      const VXIchar  *str)
+{
+  if (( s == NULL ) || ( s->GetType( ) != VALUE_STRING ) || 
+      ( str == NULL ))
+    return VXIvalue_RESULT_INVALID_ARGUMENT;
+
+  s->SetValue (str);
+  return VXIvalue_RESULT_SUCCESS;
+}
+
+
+/**
+ * Get the value of a String
+ *
+ * @param   s     String to access
+ * @param   buf   Character buffer to copy the value into as a
+ *                NULL-terminated character array.  The buffer size must be
+ *                at least VXIStringLength() + 1.
+ * @param   len   Size of the buffer, in characters
+ * @return        Pointer to buf on success, NULL on failure (most likely
+ *                buffer too small) 
+ */
+VXIVALUE_API VXIchar *VXIStringValue(const VXIString  *s, 
+				     VXIchar          *buf, 
+				     VXIunsigned       len)
+{
+  if (( s == NULL ) || ( s->GetType( ) != VALUE_STRING ) || 
+      ( buf == NULL ))
+    return NULL;
+
+  // Make sure the buffer is large enough
+  if ( len < s->GetLength( ) + 1 ) return NULL;
+
+  const STL_STRING & str = s->GetValue();
+  unsigned int length = s->GetLength();
+  for (unsigned int i = 0; i < length; ++i)
+    *(buf + i) = str[i];
+
+  *(buf + length) = L'\0';
+
+  return buf;
+}
+
+
+/**
+ * Get direct access to the NULL-terminated character value
+ *
+ * Note: the returned buffer must never be modified, and is only
+ * provided for transient use (i.e. immediately logging it, comparing
+ * it, etc. rather than storing or returning the pointer for longer
+ * term access).
+ *
+ * @param   s   String to retrieve the data from
+ * @return      Pointer to the NULL-terminated character array retrieved
+ */
+VXIVALUE_API const VXIchar* VXIStringCStr(const VXIString *s)
+{
+  if (( s == NULL ) || ( s->GetType( ) != VALUE_STRING ))
+    return NULL;
+  return s->GetValue( ).c_str( );
+}
+
+
+/**
+ * Get the number of characters in a String's value
+ *
+ * Note: Add one byte for the NULL terminator when using this to determine
+ * the length of the array required for a VXIStringValue( ) call.
+ *
+ * @param   s   String to access
+ * @return      Length of the string, in characters
+ */
+VXIVALUE_API VXIunsigned VXIStringLength(const VXIString *s)
+{
+  if (( s == NULL ) || ( s->GetType( ) != VALUE_STRING ))
+    return 0;
+  return s->GetLength( );
+}
+
+
+/**
+ * Compares two Strings
+ *
+ * @param   s1   First String to compare
+ * @param   s2   Second String to compare
+ * @return       Returns a value that is less than, equal to, or greater
+ *               than zero depending on whether s1 is lexicographically
+ *               less than, equal to, or greater than s2
+ */
+VXIVALUE_API VXIint VXIStringCompare(const VXIString *s1, 
+				     const VXIString *s2)
+{
+  if (( s1 == NULL ) || ( s1->GetType( ) != VALUE_STRING ))
+    return -1;
+  if (( s2 == NULL ) || ( s2->GetType( ) != VALUE_STRING ))
+    return 1;
+  return s1->GetValue( ).compare (s2->GetValue( ));
+}
+
+
+/**
+ * Compares a String to a NULL-terminated character array
+ *
+ * @param   str   String to compare
+ * @param   buf   NULL-terminated character array to compare
+ * @return        Returns a value that is less than, equal to, or greater
+ *                than zero depending on whether str is lexicographically
+ *                less than, equal to, or greater than buf
+ */
+VXIVALUE_API VXIint VXIStringCompareC(const VXIString *str, 
+				      const VXIchar   *buf)
+{
+  if (( str == NULL ) || ( str->GetType( ) != VALUE_STRING ))
+    return -1;
+  if ( buf == NULL )
+    return 1;
+  return str->GetValue( ).compare (buf);
+}
+
+
+/**
+ * Create an empty Map
+ *
+ * @return   New map on success, NULL otherwise
+ */
+VXIVALUE_API VXIMap *VXIMapCreate(void)
+{
+  return new VXIMap;
+}
+
+
+/**
+ * Clear the content of the map and return an empty Map
+ *
+ * @return   None
+ */
+VXIVALUE_API void VXIMapClear(VXIMap *m)
+{
+  if ( m  && ( m->GetType( ) == VALUE_MAP ))
+    m->Clear( );
+}
+
+
+/**
+ * Map destructor
+ *
+ * Note: this recursively destroys all the values contained within the
+ * Map, including all the values of Maps and Vectors stored
+ * within this map. However, for Ptr values the user is
+ * responsible for freeing the held memory if appropriate.
+ *
+ * @param m   Map to destroy 
+ */
+VXIVALUE_API void VXIMapDestroy(VXIMap **m)
+{
+  if (( m ) && ( *m ) && ( (*m)->GetType( ) == VALUE_MAP )) {
+    delete *m;
+    *m = NULL;
+  }
+}
+
+
+/**
+ * Map clone
+ *
+ * Recursively copies all values contained within the map,
+ * including all the values of Maps and Vectors stored within this
+ * map. The copy shares storage with the original until either is
+ * modified, so this is a constant time operation.
+ *
+ * Note: functionally redundant with VXIValueClone( ), but provided to
+ * reduce the need for C casts for this common operation
+ *
+ * @param    m   Map to clone
+ * @return       Clone of the Map on success, NULL otherwise 
+ */
+VXIVALUE_API VXIMap *VXIMapClone(const VXIMap *m)
+{
+  if (( m == NULL ) || ( m->GetType( ) != VALUE_MAP ))
+    return NULL;
+
+  return new VXIMap (*m);
+}
+
+
+/**
+ * Set a named property on an Map
+ *
+ * The value can be an Map so a tree can be constructed.
+ *
+ * If the property already exists, the existing value is first
+ * destroyed using VXIValueDestroy( ) (thus recursively deleting held
+ * values within it if it is an Map or Vector), then does the
+ * set operation with the new value.
+ *
+ * @param   m     Map to access
+ * @param   key   NULL terminated property name
+ * @param   val   Value to set the property to, ownership is passed
+ *                to the Map (a simple pointer copy is done), so on
+ *                success the user must not delete, modify, or otherwise
+ *                use this. Also be careful to not add a Map as a
+ *                property of itself (directly or indirectly), otherwise
+ *                infinite loops may occur on access or deletion.
+ * @return        VXIvalue_RESULT_SUCCESS on success
+ */
+VXIVALUE_API VXIvalueResult VXIMapSetProperty(VXIMap         *m, 
+					      const VXIchar  *key,
+					      VXIValue       *val)
+{
+  if (( m == NULL ) || ( m->GetType( ) != VALUE_MAP ) ||
+      ( key == NULL ) || ( key[0] == 0 ) || ( val == NULL ))
+    return VXIvalue_RESULT_INVALID_ARGUMENT;
+
+  // Replaces and destroys any existing element with that key
+  return m->Set (key, val);
+}
+
+
+/**
+ * Get a named property from an Map
+ *
+ * The property value is returned for read-only access and is
+ * invalidated if the Map is modified. The client must clone it if
+ * they wish to perform modifications or wish to retain the value even
+ * afer modifying this Map.
+ *
+ * @param   m     Map to access
+ * @param   key   NULL terminated property name
+ * @return        On success the value of the property for read-only 
+ *                access (invalidated if the Map is modified), NULL
+ *                if the property was never set or was deleted 
+ */
+VXIVALUE_API const VXIValue *VXIMapGetProperty(const VXIMap    *m, 
+					       const VXIchar   *key)
+{
+  if (( m == NULL ) || ( m->GetType( ) != VALUE_MAP ) || 
+      ( key == NULL ) || ( key[0] == 0 ))
+    return NULL;
+
+  // Find the element with that key
+  return m->Get (key);
+}
+
+
+/**
+ * Delete a named property from an Map
+ *
+ * This does a VXIValueDestroy( ) on the value for the named property
+ * (thus recursively deleting held values within it if it is an Map
+ * or Vector). However, for Ptr properties the user is responsible for
+ * freeing the held memory if appropriate.
+ *
+ * @param   m     Map to access
+ * @param   key   NULL terminated property name
+ * @return        VXIvalue_RESULT_SUCCESS on success 
+ */
+VXIVALUE_API VXIvalueResult VXIMapDeleteProperty(VXIMap         *m, 
+						 const VXIchar  *key)
+{
+  if (( m == NULL ) || ( m->GetType( ) != VALUE_MAP ) || 
+      ( key == NULL ) || ( key[0] == 0 ))
+    return VXIvalue_RESULT_INVALID_ARGUMENT;
+
+  // Destroy any existing element with that key
+  return m->Delete (key);
+}
+
+
+/**
+ * Return the number of properties for an Map
+ *
+ * Note: this only returns the number of properties that are direct
+ * children of the Map, it does not include the number of properties
+ * held in Maps and Vectors stored within this map.
+ *
+ * @param   m   Map to access
+ * @return      Number of properties stored in the Map
+ */
+VXIVALUE_API VXIunsigned VXIMapNumProperties(const VXIMap *m)
+{
+  if (( m == NULL ) || ( m->GetType( ) != VALUE_MAP ))
+    return 0;
+
+  return m->Size( );
+}
+
+
+/**
+ * Get the first property of an Map and an iterator
+ *
+ * Note: this is used to traverse all the properties within an map,
+ * there is no guarantee on what order the properties will be
+ * returned. The iterator must be eventually freed with
+ * VXIMapIteratorDestroy( ), and is invalidated if the Map is
+ * modified in any way.
+ *
+ * @param   m      Map to access
+ * @param   key    Set to point at the property name for read-only 
+ *                 access (must not be modified)                 
+ * @param   value  Set to point at the property value for read-only 
+ *                 access (must not be modified)
+ * @return         Pointer to an iterator that may be used to get
+ *                 additional properties via VXIMapGetNextProperty( ),
+ *                 or NULL on failure (typically no properties in the map)
+ */
+VXIVALUE_API 
+VXIMapIterator *VXIMapGetFirstProperty(const VXIMap     *m,
+				       const VXIchar   **key,
+				       const VXIValue  **value)
+{
+  if (( m == NULL ) || ( m->GetType( ) != VALUE_MAP ) ||
+      ( m->Size( ) == 0 ) || ( key == NULL ) || ( value == NULL ))
+    return NULL;
+
+  // Allocate an iterator map
+  VXIMapIterator *it = new VXIMapIterator (m);
+  if ( it == NULL )
+    return NULL;
+  
+  // Get the first property
+  it->GetKeyValue (key, value);
+  return it;
+}
+
+
+/**
+ * Get the next property of an Map based on an iterator
+ *
+ * Note: this is used to traverse all the properties within an map,
+ * there is no gaurantee on what order the properties will be
+ * returned.
+ *
+ * @param   it     Iterator used to access the map as obtained
+ *                 from VXIMapGetFirstProperty( ), this operation
+ *                 will advance the iterator to the next property on
+ *                 success
+ * @param   key    Set to point at the property name for read-only 
+ *                 access (must not be modified, invalidated if the
+ *                 Map is modified)                 
+ * @param   value  Set to point at the property value for read-only 
+ *                 access (must not be modified, invalidated if the
+ *                 Map is modified)
+ * @return         VXIvalue_RESULT_SUCCESS on success (property name 
+ *                 and value returned, iterator advanced), 
+ *                 VXIvalue_RESULT_FAILURE if there are no more properties
+ *                 to read, or a VXIvalueResult error code for severe errors
+ */
+VXIVALUE_API VXIvalueResult VXIMapGetNextProperty(VXIMapIterator  *it,
+						  const VXIchar  **key,
+						  const VXIValue **value)
+{
+  if (( it == NULL ) || ( key == NULL ) || ( value == NULL ))
+    return VXIvalue_RESULT_INVALID_ARGUMENT;
+
+  (*it)++;
+  return it->GetKeyValue (key, value);
+}
+
+
+/**
+ * Destroy an iterator
+ *
+ * @param   it     Iterator to destroy as obtained from 
+ *                 VXIMapGetFirstProperty( )
+ */
+VXIVALUE_API void VXIMapIteratorDestroy(VXIMapIterator **it)
+{
+  if (( it ) && ( *it )) {
+    delete *it;
+    *it = NULL;
+  }
+}
+
+
+/**
+ * Register well known map keys for interning
+ *
+ * Maps reference these keys rather than copying them, and lookups
+ * that pass one of these pointers compare it before the characters.
+ * Registering a key with the same characters as one already registered
+ * has no effect.
+ *
+ * Note: this is meant for string constants. The keys must remain
+ * valid for as long as any map may use them, and this must be called
+ * during initialization, before maps are used by multiple threads.
+ *
+ * @param   keys      Array of NULL terminated keys
+ * @param   numKeys   Number of keys in the array
+ * @return            VXIvalue_RESULT_SUCCESS on success
+ */
+VXIVALUE_API VXIvalueResult VXIMapInternKeys(const VXIchar *const *keys,
+					     VXIunsigned           numKeys)
+{
+  if (( keys == NULL ) && ( numKeys > 0 ))
+    return VXIvalue_RESULT_INVALID_ARGUMENT;
+  for (VXIunsigned i = 0; i < numKeys; i++)
+    if (( keys[i] == NULL ) || ( keys[i][0] == 0 ))
+      return VXIvalue_RESULT_INVALID_ARGUMENT;
+
+  // Grow the table to stay at most half full, rehashing what is there
+  VXIunsigned size = ( internKeys ? internMask + 1 : 0 );
+  if ( size < (internCount + numKeys) * 2 ) {
+    VXIunsigned newSize = 64;
+    while ( newSize < (internCount + numKeys) * 2 )
+      newSize *= 2;
+    VXIInternKey *newKeys = new VXIInternKey [newSize];
+    if ( newKeys == NULL )
+      return VXIvalue_RESULT_OUT_OF_MEMORY;
+    memset (newKeys, 0, newSize * sizeof (VXIInternKey));
+    for (VXIunsigned s = 0; s < size; s++) {
+      if ( internKeys[s].key == NULL )
+	continue;
+      VXIunsigned t = internKeys[s].hash & (newSize - 1);
+      while ( newKeys[t].key )
+	t = (t + 1) & (newSize - 1);
+      newKeys[t] = internKeys[s];
+    }
+    delete [] internKeys;
+    internKeys = newKeys;
+    internMask = newSize - 1;
+  }
+
+  for (VXIunsigned i = 0; i < numKeys; i++) {
+    VXIunsigned len, hash = HashKey (keys[i], &len);
+    if ( FindInternKey (keys[i], len, hash) )
+      continue;
+    VXIunsigned s = hash & internMask;
+    while ( internKeys[s].key )
+      s = (s + 1) & internMask;
+    internKeys[s].key = keys[i];
+    internKeys[s].keyLen = len;
+    internKeys[s].hash = hash;
+    internCount++;
+  }
+
+  return VXIvalue_RESULT_SUCCESS;
+}
+
+
+/**
+ * Create an empty Vector
+ *
+ * @return   New vector on success, NULL otherwise
+ */
+VXIVALUE_API VXIVector *VXIVectorCreate(void)
+{
+  return new VXIVector;
+}
+
+
+/**
+ * Vector destructor
+ *
+ * Note: this recursively destroys all the values contained within the
+ * Vector, including all the values of Vectors stored within this
+ * vector. However, for Ptr values the user is responsible for
+ * freeing the held memory if appropriate.
+ *
+ * @param   v   Vector to destroy 
+ */
+VXIVALUE_API void VXIVectorDestroy(VXIVector **v)
+{
+  if (( v ) && ( *v ) && ( (*v)->GetType( ) == VALUE_VECTOR )) {
+    delete *v;
+    *v = NULL;
+  }
+}
+
+
+/**
+ * Vector clone
+ *
+ * Recursively copies all values contained within the vector,
+ * including all the values of Vectors and Maps stored within this
+ * vector. The copy shares storage with the original until either is
+ * modified, so this is a constant time operation.
+ *
+ * Note: functionally redundant with VXIValueClone( ), but provided to
+ * reduce the need for C casts for this common operation
+ *
+ * @param    v   Vector to clone
+ * @return Clone of the Vector on success, NULL otherwise */
+VXIVALUE_API VXIVector *VXIVectorClone(const VXIVector *v)
+{
+  if (( v == NULL ) || ( v->GetType( ) != VALUE_VECTOR ))
+    return NULL;
+
+  return new VXIVector (*v);
+}
+
+
+/**
+ * Adds an element to the end of the Vector
+ *
+ * The value can be a Vector so frames can be implemented.
+ *
+ * @param   v    Vector to access
+ * @param   val  Value to append to the vector, ownership is passed
+ *               to the Vector (a simple pointer copy is done), so on
+ *               success the user must not delete, modify, or otherwise
+ *               use this. Also be careful to not add a Vector as a
+ *               element of itself (directly or indirectly), otherwise
+ *               infinite loops may occur on access or deletion.
+ * @return       VXIvalue_RESULT_SUCCESS on success
+ */
+VXIVALUE_API VXIvalueResult VXIVectorAddElement(VXIVector      *v, 
+						VXIValue       *val)
+{
+  if (( v == NULL ) || ( v->GetType( ) != VALUE_VECTOR ) || 
+      ( val == NULL ))
+    return VXIvalue_RESULT_INVALID_ARGUMENT;
+
+  // Insert the new element
+  return v->Add (val);
+}
+
+
+/**
+ * Set an indexed vector element
+ *
+ * Overwrites the specified element with the new value. The existing
+ * value is first destroyed using VXIValueDestroy( ) (thus recursively
+ * deleting held values within it if it is an Map or Vector), then
+ * does the set operation with the new value.
+ *
+ * The value can be a Vector so frames can be implemented.
+ *
+ * @param   v     Vector to access
+ * @param   n     Element index to set, it is an error to pass a
+ *                index that is greater then the number of values
+ *                currently in the vector
+ * @param   val   Value to set the element to, ownership is passed
+ *                to the Vector (a simple pointer copy is done), so on
+ *                success the user must not delete, modify, or otherwise
+ *                use this. Also be careful to not add a Vector as a
+ *                element of itself (directly or indirectly), otherwise
+ *                infinite loops may occur on access or deletion.
+ * @return        VXIvalue_RESULT_SUCCESS on success
+ */
+VXIVALUE_API VXIvalueResult VXIVectorSetElement(VXIVector      *v, 
+						VXIunsigned     n, 
+						VXIValue       *val)
+{
+  if (( v == NULL ) || ( v->GetType( ) != VALUE_VECTOR ) || 
+      ( val == NULL ) || ( n >= v->Length( ) ))
+    return VXIvalue_RESULT_INVALID_ARGUMENT;
+
+  // Set the element
+  return v->Set (n, val);
+}
+
+
+/**
+ * Get an indexed vector element
+ *
+ * The element value is returned for read-only access and is
+ * invalidated if the Vector is modified. The client must clone it if
+ * they wish to perform modifications or wish to retain the value even
+ * after modifying this Vector.
+ *
+ * @param   v     Vector to access
+ * @param   n     Element index to set, it is an error to pass a
+ *                index that is greater or equal to then the number of values
+ *                currently in the vector (i.e. range is 0 to length-1)
+ * @return        On success the value of the property for read-only 
+ *                access (invalidated if the Vector is modified), NULL
+ *                on error 
+ */
+VXIVALUE_API const VXIValue *VXIVectorGetElement(const VXIVector *v, 
+						 VXIunsigned      n)
+{
+  if (( v == NULL ) || ( v->GetType( ) != VALUE_VECTOR ) ||
+      ( n >= v->Length( ) ))
+    return NULL;
+
+  return v->Get (n);
+}
+
+
+/**
+ * Return number of elements in a Vector
+ *
+ * This computes only the length of the Vector, elements within
+ * Vectors and Maps within it are not counted.
+ *
+ * @param   v    Vector to access
+ * @return       Number of elements stored in the Vector
+ */
+VXIVALUE_API VXIunsigned VXIVectorLength(const VXIVector *v)
+{
+  if (( v == NULL ) || ( v->GetType( ) != VALUE_VECTOR ))
+    return 0;
+
+  return v->Length( );
+}
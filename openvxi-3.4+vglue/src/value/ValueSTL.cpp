@@ -663,6 +663,29 @@ VXIVALUE_API void VXIMapIteratorDestroy(VXIMapIterator **it)
 }
 
 
+/**
+ * Register well known map keys for interning
+ *
+ * This implementation always copies keys, so there is nothing to do
+ * beyond validating the arguments.
+ *
+ * @param   keys      Array of NULL terminated keys
+ * @param   numKeys   Number of keys in the array
+ * @return            VXIvalue_RESULT_SUCCESS on success
+ */
+VXIVALUE_API VXIvalueResult VXIMapInternKeys(const VXIchar *const *keys,
+					     VXIunsigned           numKeys)
+{
+  if (( keys == NULL ) && ( numKeys > 0 ))
+    return VXIvalue_RESULT_INVALID_ARGUMENT;
+  for (VXIunsigned i = 0; i < numKeys; i++)
+    if (( keys[i] == NULL ) || ( keys[i][0] == 0 ))
+      return VXIvalue_RESULT_INVALID_ARGUMENT;
+
+  return VXIvalue_RESULT_SUCCESS;
+}
+
+
 /**
  * Create an empty Vector
  *
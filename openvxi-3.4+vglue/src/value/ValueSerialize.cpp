@@ -0,0 +1,680 @@
+
+/****************License************************************************
+ * Vocalocity OpenVXI
+ * Copyright (C) 2004-2005 by Vocalocity, Inc. All Rights Reserved.
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ * Vocalocity, the Vocalocity logo, and VocalOS are trademarks or 
+ * registered trademarks of Vocalocity, Inc. 
+ * OpenVXI is a trademark of Scansoft, Inc. and used under license 
+ * by Vocalocity.
+ ***********************************************************************/
+
+#define VXIVALUE_EXPORTS
+#include "VXIvalue.h"                    // Header for this function
+
+#include <string.h>                      // For memcpy( )
+#include <wchar.h>                       // For wcslen( )
+
+// Serialized stream header: three magic bytes followed by the format
+// version. The version is bumped whenever the encoding changes in a
+// way older readers cannot handle.
+static const VXIbyte SERIALIZE_MAGIC[3] = { 'V', 'X', 'V' };
+static const VXIbyte SERIALIZE_VERSION  = 1;
+
+// Maximum nesting of maps and vectors, bounds the recursion on both
+// encode and decode
+#define SERIALIZE_MAX_DEPTH 64
+
+// Strings up to this many characters are decoded without a heap
+// allocation
+#define SERIALIZE_INLINE_CHARS 64
+
+// Tag byte written ahead of every value. These are part of the wire
+// format, never renumber them.
+enum SerializeTag {
+  TAG_INTEGER    = 1,
+  TAG_FLOAT      = 2,
+  TAG_STRING     = 3,
+  TAG_MAP        = 4,
+  TAG_VECTOR     = 5,
+  TAG_CONTENT    = 6,
+  TAG_FALSE      = 7,
+  TAG_TRUE       = 8,
+  TAG_DOUBLE     = 9,
+  TAG_LONG       = 10,
+  TAG_ULONG      = 11
+};
+
+
+// Returns true when the host stores multi-byte numbers least
+// significant byte first
+static inline bool IsLittleEndian( )
+{
+  const VXIunsigned one = 1;
+  return ( *((const VXIbyte *) &one) == 1 );
+}
+
+// ZigZag mapping so small negative numbers also encode to short varints
+static inline VXIulong ZigZagEncode(VXIlong v)
+{
+  return ((VXIulong) v << 1) ^ (VXIulong) (v < 0 ? -1L : 0L);
+}
+
+static inline VXIlong ZigZagDecode(VXIulong v)
+{
+  return (VXIlong) (v >> 1) ^ -((VXIlong) (v & 1));
+}
+
+// Fetches the next Unicode code point from a VXIchar string, joining
+// UTF-16 surrogate pairs on platforms where VXIchar is 16 bits wide.
+// Unpaired surrogates are passed through unchanged so that any
+// VXIchar string round trips exactly.
+static inline VXIunsigned NextCodePoint(const VXIchar *&src,
+					const VXIchar *end)
+{
+  VXIunsigned c = (VXIunsigned) *src++;
+  if (( sizeof(VXIchar) == 2 ) && ( c >= 0xD800 ) && ( c <= 0xDBFF ) &&
+      ( src < end )) {
+    VXIunsigned low = (VXIunsigned) *src;
+    if (( low >= 0xDC00 ) && ( low <= 0xDFFF )) {
+      src++;
+      c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+    }
+  }
+  return c;
+}
+
+// Number of UTF-8 bytes used for a code point, 0 if it cannot be
+// represented
+static inline VXIunsigned UTF8Length(VXIunsigned c)
+{
+  if ( c < 0x80 )       return 1;
+  if ( c < 0x800 )      return 2;
+  if ( c < 0x10000 )    return 3;
+  if ( c < 0x200000 )   return 4;
+  if ( c < 0x4000000 )  return 5;
+  if ( c < 0x80000000 ) return 6;
+  return 0;
+}
+
+
+// Output stream for the encoder. Constructed without a buffer it only
+// counts bytes, which lets the same code size the output in a first
+// pass and fill a single exactly sized allocation in the second.
+class SerializeWriter {
+public:
+  SerializeWriter(VXIbyte *b, VXIulong cap) :
+    buf(b), capacity(cap), pos(0), result(VXIvalue_RESULT_SUCCESS) { }
+
+  VXIulong Size( ) const { return pos; }
+  VXIvalueResult Result( ) const { return result; }
+  bool Failed( ) const { return ( result != VXIvalue_RESULT_SUCCESS ); }
+  void Fail(VXIvalueResult rc) { if ( ! Failed( ) ) result = rc; }
+
+  void Byte(VXIbyte b) {
+    if ( Room(1) ) buf[pos] = b;
+    pos++;
+  }
+
+  void Bytes(const VXIbyte *b, VXIulong n) {
+    if (( n > 0 ) && ( Room(n) )) memcpy(buf + pos, b, n);
+    pos += n;
+  }
+
+  void Varint(VXIulong v) {
+    while ( v >= 0x80 ) {
+      Byte((VXIbyte) (v | 0x80));
+      v >>= 7;
+    }
+    Byte((VXIbyte) v);
+  }
+
+  // Floating point values are written as little endian IEEE 754
+  void Number(const void *v, VXIunsigned n) {
+    const VXIbyte *src = (const VXIbyte *) v;
+    if ( IsLittleEndian( ) ) {
+      Bytes(src, n);
+    } else {
+      for (VXIunsigned i = n; i > 0; i--)
+	Byte(src[i - 1]);
+    }
+  }
+
+  // Strings are a varint byte length followed by UTF-8
+  void String(const VXIchar *str, VXIunsigned len) {
+    const VXIchar *end = str + len;
+    VXIulong bytes = 0;
+    for (const VXIchar *p = str; p < end; ) {
+      VXIunsigned n = UTF8Length(NextCodePoint(p, end));
+      if ( n == 0 ) {
+	Fail(VXIvalue_RESULT_INVALID_ARGUMENT);
+	return;
+      }
+      bytes += n;
+    }
+
+    Varint(bytes);
+    if ( buf == NULL ) {
+      pos += bytes;
+      return;
+    }
+
+    static const VXIbyte firstByteMark[7] =
+      { 0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC };
+    for (const VXIchar *p = str; p < end; ) {
+      VXIunsigned c = NextCodePoint(p, end);
+      VXIunsigned n = UTF8Length(c);
+      VXIbyte out[6];
+      for (VXIunsigned i = n - 1; i > 0; i--) {
+	out[i] = (VXIbyte) ((c & 0x3F) | 0x80);
+	c >>= 6;
+      }
+      out[0] = (VXIbyte) (c | firstByteMark[n]);
+      Bytes(out, n);
+    }
+  }
+
+private:
+  bool Room(VXIulong n) {
+    if ( buf == NULL ) return false;
+    if ( n > capacity - pos ) {
+      // The value changed between the sizing and the writing pass
+      Fail(VXIvalue_RESULT_FAILURE);
+      buf = NULL;
+      return false;
+    }
+    return true;
+  }
+
+  VXIbyte        *buf;
+  VXIulong        capacity;
+  VXIulong        pos;
+  VXIvalueResult  result;
+};
+
+
+// Encode a single value, recursing into maps and vectors
+static bool WriteValue(SerializeWriter &w, const VXIValue *v, int depth)
+{
+  switch ( VXIValueGetType(v) ) {
+  case VALUE_BOOLEAN:
+    w.Byte(VXIBooleanValue((const VXIBoolean *) v) ? TAG_TRUE : TAG_FALSE);
+    break;
+
+  case VALUE_INTEGER:
+    w.Byte(TAG_INTEGER);
+    w.Varint(ZigZagEncode(VXIIntegerValue((const VXIInteger *) v)));
+    break;
+
+  case VALUE_LONG:
+    w.Byte(TAG_LONG);
+    w.Varint(ZigZagEncode(VXILongValue((const VXILong *) v)));
+    break;
+
+  case VALUE_ULONG:
+    w.Byte(TAG_ULONG);
+    w.Varint(VXIULongValue((const VXIULong *) v));
+    break;
+
+  case VALUE_FLOAT: {
+    VXIflt32 f = VXIFloatValue((const VXIFloat *) v);
+    w.Byte(TAG_FLOAT);
+    w.Number(&f, sizeof(f));
+  } break;
+
+  case VALUE_DOUBLE: {
+    VXIflt64 d = VXIDoubleValue((const VXIDouble *) v);
+    w.Byte(TAG_DOUBLE);
+    w.Number(&d, sizeof(d));
+  } break;
+
+  case VALUE_STRING: {
+    const VXIString *s = (const VXIString *) v;
+    w.Byte(TAG_STRING);
+    w.String(VXIStringCStr(s), VXIStringLength(s));
+  } break;
+
+  case VALUE_CONTENT: {
+    const VXIchar *type = NULL;
+    const VXIbyte *data = NULL;
+    VXIulong size = 0;
+    if ( VXIContentValue((const VXIContent *) v, &type, &data, &size) !=
+	 VXIvalue_RESULT_SUCCESS ) {
+      w.Fail(VXIvalue_RESULT_FAILURE);
+      return false;
+    }
+    const VXIchar *encoding =
+      VXIContentGetTransferEncoding((const VXIContent *) v);
+    if ( type == NULL ) type = L"";
+    if ( encoding == NULL ) encoding = L"";
+
+    w.Byte(TAG_CONTENT);
+    w.String(type, wcslen(type));
+    w.String(encoding, wcslen(encoding));
+    w.Varint(size);
+    w.Bytes(data, size);
+  } break;
+
+  case VALUE_MAP: {
+    if ( depth >= SERIALIZE_MAX_DEPTH ) {
+      w.Fail(VXIvalue_RESULT_UNSUPPORTED);
+      return false;
+    }
+
+    const VXIMap *m = (const VXIMap *) v;
+    w.Byte(TAG_MAP);
+    w.Varint(VXIMapNumProperties(m));
+
+    const VXIchar *key;
+    const VXIValue *value;
+    VXIMapIterator *it = VXIMapGetFirstProperty(m, &key, &value);
+    if ( it == NULL )
+      break;
+    do {
+      w.String(key, wcslen(key));
+      if ( ! WriteValue(w, value, depth + 1) )
+	break;
+    } while ( VXIMapGetNextProperty(it, &key, &value) ==
+	      VXIvalue_RESULT_SUCCESS );
+    VXIMapIteratorDestroy(&it);
+  } break;
+
+  case VALUE_VECTOR: {
+    if ( depth >= SERIALIZE_MAX_DEPTH ) {
+      w.Fail(VXIvalue_RESULT_UNSUPPORTED);
+      return false;
+    }
+
+    const VXIVector *vec = (const VXIVector *) v;
+    VXIunsigned len = VXIVectorLength(vec);
+    w.Byte(TAG_VECTOR);
+    w.Varint(len);
+    for (VXIunsigned i = 0; ( i < len ) && ( ! w.Failed( ) ); i++)
+      WriteValue(w, VXIVectorGetElement(vec, i), depth + 1);
+  } break;
+
+  default:
+    // VXIPtr values are process local and cannot be serialized
+    w.Fail(VXIvalue_RESULT_UNSUPPORTED);
+    return false;
+  }
+
+  return ( ! w.Failed( ) );
+}
+
+
+// Input stream for the decoder, every read is checked against the
+// remaining input
+class SerializeReader {
+public:
+  SerializeReader(const VXIbyte *data, VXIulong size) :
+    pos(data), end(data + size) { }
+
+  VXIulong Remaining( ) const { return (VXIulong) (end - pos); }
+
+  bool Byte(VXIbyte &b) {
+    if ( pos >= end ) return false;
+    b = *pos++;
+    return true;
+  }
+
+  bool Bytes(const VXIbyte *&b, VXIulong n) {
+    if ( n > Remaining( ) ) return false;
+    b = pos;
+    pos += n;
+    return true;
+  }
+
+  bool Varint(VXIulong &v) {
+    v = 0;
+    for (unsigned int shift = 0; shift < sizeof(VXIulong) * 8; shift += 7) {
+      VXIbyte b;
+      if ( ! Byte(b) ) return false;
+      VXIulong bits = (VXIulong) (b & 0x7F);
+      // Reject values that do not fit in a VXIulong on this platform
+      if (( bits << shift ) >> shift != bits ) return false;
+      v |= bits << shift;
+      if (( b & 0x80 ) == 0 ) return true;
+    }
+    return false;
+  }
+
+  bool Number(void *v, VXIunsigned n) {
+    const VXIbyte *src;
+    if ( ! Bytes(src, n) ) return false;
+    VXIbyte *dst = (VXIbyte *) v;
+    for (VXIunsigned i = 0; i < n; i++)
+      dst[IsLittleEndian( ) ? i : n - 1 - i] = src[i];
+    return true;
+  }
+
+private:
+  const VXIbyte *pos;
+  const VXIbyte *end;
+};
+
+
+// Decoded string buffer, short strings stay on the stack
+class SerializeChars {
+public:
+  SerializeChars( ) : str(inlineBuf), len(0) { }
+  ~SerializeChars( ) { if ( str != inlineBuf ) delete [] str; }
+
+  const VXIchar *CStr( ) const { return str; }
+  VXIunsigned Length( ) const { return len; }
+
+  // Decode a varint length prefixed UTF-8 string
+  VXIvalueResult Read(SerializeReader &r) {
+    VXIulong bytes;
+    const VXIbyte *src;
+    if (( ! r.Varint(bytes) ) || ( ! r.Bytes(src, bytes) ))
+      return VXIvalue_RESULT_FAILURE;
+
+    // Each UTF-8 sequence yields at most as many VXIchars as it has
+    // bytes, so the input size bounds the allocation
+    if ( str != inlineBuf ) delete [] str;
+    str = inlineBuf;
+    if ( bytes >= SERIALIZE_INLINE_CHARS ) {
+      str = new VXIchar [bytes + 1];
+      if ( str == NULL ) {
+	str = inlineBuf;
+	return VXIvalue_RESULT_OUT_OF_MEMORY;
+      }
+    }
+
+    static const VXIunsigned minValue[7] =
+      { 0, 0, 0x80, 0x800, 0x10000, 0x200000, 0x4000000 };
+    const VXIbyte *end = src + bytes;
+    len = 0;
+    while ( src < end ) {
+      VXIunsigned c = *src++;
+      VXIunsigned n;
+      if ( c < 0x80 )      n = 1;
+      else if ( c < 0xC0 ) return VXIvalue_RESULT_FAILURE;
+      else if ( c < 0xE0 ) { n = 2; c &= 0x1F; }
+      else if ( c < 0xF0 ) { n = 3; c &= 0x0F; }
+      else if ( c < 0xF8 ) { n = 4; c &= 0x07; }
+      else if ( c < 0xFC ) { n = 5; c &= 0x03; }
+      else if ( c < 0xFE ) { n = 6; c &= 0x01; }
+      else                 return VXIvalue_RESULT_FAILURE;
+
+      if ( (VXIulong) (end - src) < n - 1 )
+	return VXIvalue_RESULT_FAILURE;
+      for (VXIunsigned i = 1; i < n; i++) {
+	VXIbyte b = *src++;
+	if (( b & 0xC0 ) != 0x80 ) return VXIvalue_RESULT_FAILURE;
+	c = (c << 6) | (b & 0x3F);
+      }
+      if (( n > 1 ) && ( c < minValue[n] ))
+	return VXIvalue_RESULT_FAILURE;  // Overlong encoding
+
+      if ( sizeof(VXIchar) == 2 ) {
+	if ( c > 0x10FFFF ) return VXIvalue_RESULT_FAILURE;
+	if ( c >= 0x10000 ) {
+	  c -= 0x10000;
+	  str[len++] = (VXIchar) (0xD800 + (c >> 10));
+	  c = 0xDC00 + (c & 0x3FF);
+	}
+      }
+      str[len++] = (VXIchar) c;
+    }
+    str[len] = L'\0';
+    return VXIvalue_RESULT_SUCCESS;
+  }
+
+private:
+  VXIchar     *str;
+  VXIunsigned  len;
+  VXIchar      inlineBuf[SERIALIZE_INLINE_CHARS + 1];
+};
+
+
+// Destroy callback for content created by the encoder or decoder
+static void DestroyBytes(VXIbyte **content, void *)
+{
+  if (( content ) && ( *content )) {
+    delete [] *content;
+    *content = NULL;
+  }
+}
+
+
+// Decode a single value, recursing into maps and vectors
+static VXIvalueResult ReadValue(SerializeReader &r, int depth,
+				VXIValue **result)
+{
+  *result = NULL;
+
+  VXIbyte tag;
+  if ( ! r.Byte(tag) )
+    return VXIvalue_RESULT_FAILURE;
+
+  switch ( tag ) {
+  case TAG_FALSE:
+  case TAG_TRUE:
+    *result = (VXIValue *) VXIBooleanCreate(tag == TAG_TRUE ? TRUE : FALSE);
+    break;
+
+  case TAG_INTEGER: {
+    VXIulong raw;
+    if ( ! r.Varint(raw) ) return VXIvalue_RESULT_FAILURE;
+    VXIlong v = ZigZagDecode(raw);
+    if (( v < -2147483647L - 1 ) || ( v > 2147483647L ))
+      return VXIvalue_RESULT_FAILURE;
+    *result = (VXIValue *) VXIIntegerCreate((VXIint32) v);
+  } break;
+
+  case TAG_LONG: {
+    VXIulong raw;
+    if ( ! r.Varint(raw) ) return VXIvalue_RESULT_FAILURE;
+    *result = (VXIValue *) VXILongCreate(ZigZagDecode(raw));
+  } break;
+
+  case TAG_ULONG: {
+    VXIulong v;
+    if ( ! r.Varint(v) ) return VXIvalue_RESULT_FAILURE;
+    *result = (VXIValue *) VXIULongCreate(v);
+  } break;
+
+  case TAG_FLOAT: {
+    VXIflt32 f;
+    if ( ! r.Number(&f, sizeof(f)) ) return VXIvalue_RESULT_FAILURE;
+    *result = (VXIValue *) VXIFloatCreate(f);
+  } break;
+
+  case TAG_DOUBLE: {
+    VXIflt64 d;
+    if ( ! r.Number(&d, sizeof(d)) ) return VXIvalue_RESULT_FAILURE;
+    *result = (VXIValue *) VXIDoubleCreate(d);
+  } break;
+
+  case TAG_STRING: {
+    SerializeChars s;
+    VXIvalueResult rc = s.Read(r);
+    if ( rc != VXIvalue_RESULT_SUCCESS ) return rc;
+    *result = (VXIValue *) VXIStringCreateN(s.CStr( ), s.Length( ));
+  } break;
+
+  case TAG_CONTENT: {
+    SerializeChars type, encoding;
+    VXIvalueResult rc = type.Read(r);
+    if ( rc == VXIvalue_RESULT_SUCCESS )
+      rc = encoding.Read(r);
+    if ( rc != VXIvalue_RESULT_SUCCESS ) return rc;
+
+    // Content always has a type and at least one byte
+    VXIulong size;
+    const VXIbyte *src;
+    if (( type.Length( ) == 0 ) || ( ! r.Varint(size) ) || ( size == 0 ) ||
+	( ! r.Bytes(src, size) ))
+      return VXIvalue_RESULT_FAILURE;
+
+    VXIbyte *data = new VXIbyte [size];
+    if ( data == NULL )
+      return VXIvalue_RESULT_OUT_OF_MEMORY;
+    memcpy(data, src, size);
+
+    VXIContent *c = VXIContentCreate(type.CStr( ), data, size,
+				     DestroyBytes, NULL);
+    if ( c == NULL ) {
+      delete [] data;
+      return VXIvalue_RESULT_OUT_OF_MEMORY;
+    }
+    if ( encoding.Length( ) > 0 )
+      VXIContentSetTransferEncoding(c, encoding.CStr( ));
+    *result = (VXIValue *) c;
+  } break;
+
+  case TAG_MAP: {
+    VXIulong count;
+    if (( depth >= SERIALIZE_MAX_DEPTH ) || ( ! r.Varint(count) ) ||
+	( count > r.Remaining( ) / 2 ))  // Each entry is at least 2 bytes
+      return VXIvalue_RESULT_FAILURE;
+
+    VXIMap *m = VXIMapCreate( );
+    if ( m == NULL )
+      return VXIvalue_RESULT_OUT_OF_MEMORY;
+
+    SerializeChars key;
+    VXIvalueResult rc = VXIvalue_RESULT_SUCCESS;
+    for (VXIulong i = 0; ( i < count ) && ( rc == VXIvalue_RESULT_SUCCESS );
+	 i++) {
+      VXIValue *value = NULL;
+      rc = key.Read(r);
+      if (( rc == VXIvalue_RESULT_SUCCESS ) &&
+	  (( key.Length( ) == 0 ) || ( wcslen(key.CStr( )) != key.Length( ))))
+	rc = VXIvalue_RESULT_FAILURE;  // Empty key or embedded NUL
+      if ( rc == VXIvalue_RESULT_SUCCESS )
+	rc = ReadValue(r, depth + 1, &value);
+      if ( rc == VXIvalue_RESULT_SUCCESS ) {
+	rc = VXIMapSetProperty(m, key.CStr( ), value);
+	if ( rc != VXIvalue_RESULT_SUCCESS )
+	  VXIValueDestroy(&value);
+      }
+    }
+    if ( rc != VXIvalue_RESULT_SUCCESS ) {
+      VXIMapDestroy(&m);
+      return rc;
+    }
+    *result = (VXIValue *) m;
+  } break;
+
+  case TAG_VECTOR: {
+    VXIulong count;
+    if (( depth >= SERIALIZE_MAX_DEPTH ) || ( ! r.Varint(count) ) ||
+	( count > r.Remaining( ) ))  // Each element is at least 1 byte
+      return VXIvalue_RESULT_FAILURE;
+
+    VXIVector *vec = VXIVectorCreate( );
+    if ( vec == NULL )
+      return VXIvalue_RESULT_OUT_OF_MEMORY;
+
+    VXIvalueResult rc = VXIvalue_RESULT_SUCCESS;
+    for (VXIulong i = 0; ( i < count ) && ( rc == VXIvalue_RESULT_SUCCESS );
+	 i++) {
+      VXIValue *value = NULL;
+      rc = ReadValue(r, depth + 1, &value);
+      if ( rc == VXIvalue_RESULT_SUCCESS ) {
+	rc = VXIVectorAddElement(vec, value);
+	if ( rc != VXIvalue_RESULT_SUCCESS )
+	  VXIValueDestroy(&value);
+      }
+    }
+    if ( rc != VXIvalue_RESULT_SUCCESS ) {
+      VXIVectorDestroy(&vec);
+      return rc;
+    }
+    *result = (VXIValue *) vec;
+  } break;
+
+  default:
+    return VXIvalue_RESULT_FAILURE;
+  }
+
+  return ( *result ? VXIvalue_RESULT_SUCCESS :
+	   VXIvalue_RESULT_OUT_OF_MEMORY );
+}
+
+
+/**
+ * Serialize a VXIValue tree to the compact binary format
+ */
+VXIVALUE_API VXIvalueResult VXIValueSerialize(const VXIValue  *v,
+					      VXIContent     **result)
+{
+  if (( v == NULL ) || ( result == NULL ))
+    return VXIvalue_RESULT_INVALID_ARGUMENT;
+  *result = NULL;
+
+  // Size pass
+  SerializeWriter sizer(NULL, 0);
+  sizer.Bytes(SERIALIZE_MAGIC, sizeof(SERIALIZE_MAGIC));
+  sizer.Byte(SERIALIZE_VERSION);
+  if ( ! WriteValue(sizer, v, 0) )
+    return sizer.Result( );
+
+  // Write pass into a single allocation
+  VXIulong size = sizer.Size( );
+  VXIbyte *data = new VXIbyte [size];
+  if ( data == NULL )
+    return VXIvalue_RESULT_OUT_OF_MEMORY;
+
+  SerializeWriter writer(data, size);
+  writer.Bytes(SERIALIZE_MAGIC, sizeof(SERIALIZE_MAGIC));
+  writer.Byte(SERIALIZE_VERSION);
+  if (( ! WriteValue(writer, v, 0) ) || ( writer.Size( ) != size )) {
+    delete [] data;
+    return ( writer.Failed( ) ? writer.Result( ) : VXIvalue_RESULT_FAILURE );
+  }
+
+  *result = VXIContentCreate(VXI_MIME_VXIVALUE, data, size,
+			     DestroyBytes, NULL);
+  if ( *result == NULL ) {
+    delete [] data;
+    return VXIvalue_RESULT_OUT_OF_MEMORY;
+  }
+  return VXIvalue_RESULT_SUCCESS;
+}
+
+
+/**
+ * Rebuild a VXIValue tree from the compact binary format
+ */
+VXIVALUE_API VXIvalueResult VXIValueDeserialize(const VXIbyte  *data,
+						VXIulong        size,
+						VXIValue      **result)
+{
+  if (( data == NULL ) || ( result == NULL ))
+    return VXIvalue_RESULT_INVALID_ARGUMENT;
+  *result = NULL;
+
+  SerializeReader r(data, size);
+  const VXIbyte *magic;
+  VXIbyte version;
+  if (( ! r.Bytes(magic, sizeof(SERIALIZE_MAGIC)) ) ||
+      ( memcmp(magic, SERIALIZE_MAGIC, sizeof(SERIALIZE_MAGIC)) != 0 ) ||
+      ( ! r.Byte(version) ))
+    return VXIvalue_RESULT_FAILURE;
+  if ( version != SERIALIZE_VERSION )
+    return VXIvalue_RESULT_UNSUPPORTED;
+
+  VXIvalueResult rc = ReadValue(r, 0, result);
+  if (( rc == VXIvalue_RESULT_SUCCESS ) && ( r.Remaining( ) != 0 )) {
+    // Trailing garbage, the stream is not what we wrote
+    VXIValueDestroy(result);
+    rc = VXIvalue_RESULT_FAILURE;
+  }
+  return rc;
+}
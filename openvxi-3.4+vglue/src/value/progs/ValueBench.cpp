@@ -0,0 +1,228 @@
+
+/****************License************************************************
+ * Vocalocity OpenVXI
+ * Copyright (C) 2004-2005 by Vocalocity, Inc. All Rights Reserved.
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ * Vocalocity, the Vocalocity logo, and VocalOS are trademarks or 
+ * registered trademarks of Vocalocity, Inc. 
+ * OpenVXI is a trademark of Scansoft, Inc. and used under license 
+ * by Vocalocity.
+ ***********************************************************************/
+
+// -----1=0-------2=0-------3=0-------4=0-------5=0-------6=0-------7=0-------8
+
+// Micro benchmark for the VXIvalue map implementation, exercising it
+// only through the public API the way the interpreter does: building
+// small property maps, looking properties up, cloning and iterating,
+// first with plain keys and then with the same keys interned, and
+// then serializing a call state sized tree in the binary format next
+// to VXIValueToString( ).
+// Build the library with the default flat map, with STL_MAP=1 or with
+// NO_STL=1 and run this against each to compare the backends.
+//
+//   ValueBench [iterations] [properties per map]
+
+#include "VXIvalue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include <time.h>
+#include <sys/time.h>
+
+static double Now( )
+{
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void Report (const char *name, double start, unsigned long ops)
+{
+  double secs = Now( ) - start;
+  printf ("%-17s %10lu ops %8.3f s %10.1f ns/op\n", name, ops, secs,
+	  ( ops ? secs * 1e9 / ops : 0.0 ));
+}
+
+// Run each benchmark over maps built from the given keys
+static unsigned long RunAll (const char *suffix, const VXIchar *const *keys,
+			     unsigned long iterations, unsigned int props)
+{
+  unsigned long found = 0;
+  char name[32];
+  double start;
+  VXIMap *m = NULL;
+
+  // Build and destroy maps
+  start = Now( );
+  for (unsigned long n = 0; n < iterations; n++) {
+    m = VXIMapCreate( );
+    for (unsigned int i = 0; i < props; i++)
+      VXIMapSetProperty (m, keys[i], (VXIValue *) VXIIntegerCreate (i));
+    VXIMapDestroy (&m);
+  }
+  sprintf (name, "build%s", suffix);
+  Report (name, start, iterations * props);
+
+  m = VXIMapCreate( );
+  for (unsigned int i = 0; i < props; i++)
+    VXIMapSetProperty (m, keys[i], (VXIValue *) VXIIntegerCreate (i));
+
+  // Look up every property, and one that is not there
+  start = Now( );
+  for (unsigned long n = 0; n < iterations; n++) {
+    for (unsigned int i = 0; i < props; i++)
+      if ( VXIMapGetProperty (m, keys[i]) )
+	found++;
+    if ( VXIMapGetProperty (m, L"vxi.property.missing") )
+      found++;
+  }
+  sprintf (name, "lookup%s", suffix);
+  Report (name, start, iterations * (props + 1));
+
+  // Clone and destroy
+  start = Now( );
+  for (unsigned long n = 0; n < iterations; n++) {
+    VXIMap *c = VXIMapClone (m);
+    VXIMapDestroy (&c);
+  }
+  sprintf (name, "clone%s", suffix);
+  Report (name, start, iterations);
+
+  // Clone, modify one property and destroy
+  start = Now( );
+  for (unsigned long n = 0; n < iterations; n++) {
+    VXIMap *c = VXIMapClone (m);
+    VXIMapSetProperty (c, keys[0], (VXIValue *) VXIIntegerCreate (n));
+    VXIMapDestroy (&c);
+  }
+  sprintf (name, "clone+set%s", suffix);
+  Report (name, start, iterations);
+
+  // Iterate in key order
+  start = Now( );
+  for (unsigned long n = 0; n < iterations; n++) {
+    const VXIchar *key;
+    const VXIValue *value;
+    VXIMapIterator *it = VXIMapGetFirstProperty (m, &key, &value);
+    while ( it ) {
+      found++;
+      if ( VXIMapGetNextProperty (it, &key, &value) !=
+	   VXIvalue_RESULT_SUCCESS )
+	break;
+    }
+    VXIMapIteratorDestroy (&it);
+  }
+  sprintf (name, "iterate%s", suffix);
+  Report (name, start, iterations * props);
+
+  VXIMapDestroy (&m);
+  return found;
+}
+
+// Serialize and deserialize a tree shaped like a session snapshot: a
+// map of property maps with strings, numbers and a vector each
+static unsigned long RunSerialize (const VXIchar *const *keys,
+				   unsigned long iterations,
+				   unsigned int props)
+{
+  unsigned long found = 0;
+  double start;
+
+  VXIMap *state = VXIMapCreate( );
+  for (unsigned int i = 0; i < props; i++) {
+    VXIMap *scope = VXIMapCreate( );
+    VXIVector *vec = VXIVectorCreate( );
+    for (unsigned int j = 0; j < props; j++) {
+      VXIMapSetProperty (scope, keys[j],
+			 ( j % 2 ?
+			   (VXIValue *) VXIStringCreate (L"application/srgs+xml") :
+			   (VXIValue *) VXIIntegerCreate (j * 1000) ));
+      VXIVectorAddElement (vec, (VXIValue *) VXIFloatCreate (j * 0.5f));
+    }
+    VXIMapSetProperty (scope, L"vector", (VXIValue *) vec);
+    VXIMapSetProperty (state, keys[i], (VXIValue *) scope);
+  }
+
+  VXIContent *bytes = NULL;
+  start = Now( );
+  for (unsigned long n = 0; n < iterations; n++) {
+    if ( bytes ) VXIContentDestroy (&bytes);
+    VXIValueSerialize ((VXIValue *) state, &bytes);
+  }
+  Report ("serialize", start, iterations);
+
+  const VXIchar *type;
+  const VXIbyte *data = NULL;
+  VXIulong size = 0;
+  if ( bytes )
+    VXIContentValue (bytes, &type, &data, &size);
+  start = Now( );
+  for (unsigned long n = 0; n < iterations; n++) {
+    VXIValue *v = NULL;
+    if ( VXIValueDeserialize (data, size, &v) == VXIvalue_RESULT_SUCCESS )
+      found++;
+    VXIValueDestroy (&v);
+  }
+  Report ("deserialize", start, iterations);
+
+  VXIString *str = NULL;
+  start = Now( );
+  for (unsigned long n = 0; n < iterations; n++) {
+    if ( str ) VXIStringDestroy (&str);
+    str = VXIValueToString ((VXIValue *) state, L"state",
+			    VALUE_FORMAT_URL_QUERY_ARGS);
+  }
+  Report ("tostring", start, iterations);
+
+  printf ("serialized %lu bytes, tostring %u chars\n", size,
+	  ( str ? VXIStringLength (str) : 0 ));
+  if ( str ) VXIStringDestroy (&str);
+  if ( bytes ) VXIContentDestroy (&bytes);
+  VXIMapDestroy (&state);
+  return found;
+}
+
+int main (int argc, char *argv[])
+{
+  unsigned long iterations = ( argc > 1 ? strtoul (argv[1], NULL, 10) :
+			       100000 );
+  unsigned int props = ( argc > 2 ? strtoul (argv[2], NULL, 10) : 12 );
+  if (( iterations == 0 ) || ( props == 0 )) {
+    fprintf (stderr, "usage: %s [iterations] [properties per map]\n",
+	     argv[0]);
+    return 1;
+  }
+
+  // Property names shaped like the interpreter's, e.g. "vxi.rec.timeout"
+  VXIchar **keys = new VXIchar * [props];
+  for (unsigned int i = 0; i < props; i++) {
+    keys[i] = new VXIchar [32];
+    swprintf (keys[i], 32, L"vxi.property.%u", i);
+  }
+
+  // Then again with the same keys interned, as the interpreter does
+  // for its well known property names
+  unsigned long found = RunAll ("", keys, iterations, props);
+  if ( VXIMapInternKeys (keys, props) == VXIvalue_RESULT_SUCCESS )
+    found += RunAll ("-intern", keys, iterations, props);
+  found += RunSerialize (keys, iterations / props + 1, props);
+
+  for (unsigned int i = 0; i < props; i++)
+    delete [] keys[i];
+  delete [] keys;
+
+  // Keeps the lookups from being optimized away
+  return ( found == 0 );
+}
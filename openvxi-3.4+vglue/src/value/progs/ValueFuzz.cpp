@@ -0,0 +1,348 @@
+
+/****************License************************************************
+ * Vocalocity OpenVXI
+ * Copyright (C) 2004-2005 by Vocalocity, Inc. All Rights Reserved.
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ * Vocalocity, the Vocalocity logo, and VocalOS are trademarks or 
+ * registered trademarks of Vocalocity, Inc. 
+ * OpenVXI is a trademark of Scansoft, Inc. and used under license 
+ * by Vocalocity.
+ ***********************************************************************/
+
+// -----1=0-------2=0-------3=0-------4=0-------5=0-------6=0-------7=0-------8
+
+// Randomized round trip test for VXIValueSerialize( ) and
+// VXIValueDeserialize( ). Each iteration builds a random tree of every
+// serializable type, checks that it deserializes to an equal tree that
+// serializes to the same bytes, then feeds truncated and corrupted
+// copies of the bytes to the decoder, which must either reject them or
+// return a tree that serializes again. Run it under a memory checker
+// to catch leaks and out of bounds reads in the decoder.
+//
+//   ValueFuzz [iterations] [seed]
+
+#include "VXIvalue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+static unsigned long iteration = 0;
+static unsigned long failures = 0;
+
+#define CHECK(cond, what) \
+  do { if ( ! (cond) ) { \
+    fprintf (stderr, "iteration %lu: %s\n", iteration, what); \
+    failures++; } } while ( 0 )
+
+// Small deterministic generator so a failing seed can be replayed
+static unsigned long rngState = 1;
+
+static unsigned long Random (unsigned long range)
+{
+  rngState = rngState * 6364136223846793005UL + 1442695040888963407UL;
+  return (unsigned long) ((rngState >> 33) % range);
+}
+
+// Random bits across the full width of a VXIulong, shifted down by a
+// random amount so small magnitudes are common too
+static VXIulong RandomBits( )
+{
+  VXIulong v = 0;
+  for (unsigned int i = 0; i < sizeof(VXIulong) / 2; i++)
+    v = (v << 16) | Random (0x10000);
+  return v >> Random (sizeof(VXIulong) * 8);
+}
+
+static void DestroyData (VXIbyte **content, void *userData)
+{
+  delete [] *content;
+  *content = NULL;
+}
+
+// Random string mixing ASCII, Latin 1, BMP and supplementary
+// characters, optionally with embedded NULs
+static void RandomChars (VXIchar *buf, unsigned int len, bool allowNul)
+{
+  for (unsigned int i = 0; i < len; i++) {
+    switch ( Random (6) ) {
+    case 0:  buf[i] = (VXIchar) (0xA0 + Random (0x60)); break;
+    case 1:  buf[i] = (VXIchar) (0x400 + Random (0x800)); break;
+    case 2:
+      if ( sizeof(VXIchar) > 2 ) {
+	buf[i] = (VXIchar) (0x10000 + Random (0x100000));
+	break;
+      }
+      // Fall through
+    default:
+      buf[i] = (VXIchar) ( allowNul && Random (20) == 0 ? 0 :
+			   'a' + Random (26) );
+    }
+  }
+  buf[len] = L'\0';
+}
+
+static VXIValue *RandomValue (int depth)
+{
+  VXIchar str[40];
+  unsigned int len, n;
+
+  switch ( Random ( depth < 6 ? 11 : 9 ) ) {
+  case 0:
+    return (VXIValue *) VXIBooleanCreate (Random (2) ? TRUE : FALSE);
+  case 1:
+    return (VXIValue *) VXIIntegerCreate ((VXIint32) RandomBits( ));
+  case 2:
+    return (VXIValue *) VXILongCreate ((VXIlong) RandomBits( ));
+  case 3:
+    return (VXIValue *) VXIULongCreate (RandomBits( ));
+  case 4:
+    return (VXIValue *) VXIFloatCreate ((VXIflt32) Random (100000) / 7.0f);
+  case 5:
+    return (VXIValue *) VXIDoubleCreate ((VXIflt64) Random (100000) / -3.0);
+  case 6:
+  case 7:
+    len = Random (sizeof(str) / sizeof(VXIchar) - 1);
+    RandomChars (str, len, true);
+    return (VXIValue *) VXIStringCreateN (str, len);
+  case 8: {
+    len = 1 + Random (300);
+    VXIbyte *data = new VXIbyte [len];
+    for (unsigned int i = 0; i < len; i++)
+      data[i] = (VXIbyte) Random (256);
+    VXIContent *c = VXIContentCreate (VXI_MIME_XML, data, len,
+				      DestroyData, NULL);
+    if ( Random (2) )
+      VXIContentSetTransferEncoding (c, L"base64");
+    return (VXIValue *) c;
+  }
+  case 9: {
+    VXIMap *m = VXIMapCreate( );
+    n = Random (12);
+    for (unsigned int i = 0; i < n; i++) {
+      len = 1 + Random (16);
+      RandomChars (str, len, false);
+      VXIMapSetProperty (m, str, RandomValue (depth + 1));
+    }
+    return (VXIValue *) m;
+  }
+  default: {
+    VXIVector *v = VXIVectorCreate( );
+    n = Random (8);
+    for (unsigned int i = 0; i < n; i++)
+      VXIVectorAddElement (v, RandomValue (depth + 1));
+    return (VXIValue *) v;
+  }
+  }
+}
+
+// Deep comparison through the public API
+static bool Equal (const VXIValue *a, const VXIValue *b)
+{
+  if ( VXIValueGetType (a) != VXIValueGetType (b) )
+    return false;
+
+  switch ( VXIValueGetType (a) ) {
+  case VALUE_BOOLEAN:
+    return ( VXIBooleanValue ((const VXIBoolean *) a) ==
+	     VXIBooleanValue ((const VXIBoolean *) b) );
+  case VALUE_INTEGER:
+    return ( VXIIntegerValue ((const VXIInteger *) a) ==
+	     VXIIntegerValue ((const VXIInteger *) b) );
+  case VALUE_LONG:
+    return ( VXILongValue ((const VXILong *) a) ==
+	     VXILongValue ((const VXILong *) b) );
+  case VALUE_ULONG:
+    return ( VXIULongValue ((const VXIULong *) a) ==
+	     VXIULongValue ((const VXIULong *) b) );
+  case VALUE_FLOAT:
+    return ( VXIFloatValue ((const VXIFloat *) a) ==
+	     VXIFloatValue ((const VXIFloat *) b) );
+  case VALUE_DOUBLE:
+    return ( VXIDoubleValue ((const VXIDouble *) a) ==
+	     VXIDoubleValue ((const VXIDouble *) b) );
+  case VALUE_STRING: {
+    const VXIString *sa = (const VXIString *) a, *sb = (const VXIString *) b;
+    return (( VXIStringLength (sa) == VXIStringLength (sb) ) &&
+	    ( wmemcmp (VXIStringCStr (sa), VXIStringCStr (sb),
+		       VXIStringLength (sa)) == 0 ));
+  }
+  case VALUE_CONTENT: {
+    const VXIchar *ta, *tb;
+    const VXIbyte *da, *db;
+    VXIulong na, nb;
+    VXIContentValue ((const VXIContent *) a, &ta, &da, &na);
+    VXIContentValue ((const VXIContent *) b, &tb, &db, &nb);
+    const VXIchar *ea = VXIContentGetTransferEncoding ((const VXIContent *) a);
+    const VXIchar *eb = VXIContentGetTransferEncoding ((const VXIContent *) b);
+    return (( wcscmp (ta, tb) == 0 ) &&
+	    ( wcscmp (ea ? ea : L"", eb ? eb : L"") == 0 ) &&
+	    ( na == nb ) && (( na == 0 ) || ( memcmp (da, db, na) == 0 )));
+  }
+  case VALUE_MAP: {
+    const VXIMap *ma = (const VXIMap *) a, *mb = (const VXIMap *) b;
+    if ( VXIMapNumProperties (ma) != VXIMapNumProperties (mb) )
+      return false;
+    const VXIchar *key;
+    const VXIValue *value;
+    bool same = true;
+    VXIMapIterator *it = VXIMapGetFirstProperty (ma, &key, &value);
+    while (( it ) && ( same )) {
+      const VXIValue *other = VXIMapGetProperty (mb, key);
+      same = (( other ) && ( Equal (value, other) ));
+      if ( VXIMapGetNextProperty (it, &key, &value) !=
+	   VXIvalue_RESULT_SUCCESS )
+	break;
+    }
+    VXIMapIteratorDestroy (&it);
+    return same;
+  }
+  case VALUE_VECTOR: {
+    const VXIVector *va = (const VXIVector *) a, *vb = (const VXIVector *) b;
+    if ( VXIVectorLength (va) != VXIVectorLength (vb) )
+      return false;
+    for (VXIunsigned i = 0; i < VXIVectorLength (va); i++)
+      if ( ! Equal (VXIVectorGetElement (va, i), VXIVectorGetElement (vb, i)) )
+	return false;
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+static VXIvalueResult Serialize (const VXIValue *v, VXIContent **c,
+				 const VXIbyte **data, VXIulong *size)
+{
+  const VXIchar *type;
+  VXIvalueResult rc = VXIValueSerialize (v, c);
+  if ( rc == VXIvalue_RESULT_SUCCESS )
+    rc = VXIContentValue (*c, &type, data, size);
+  return rc;
+}
+
+// Decode a damaged copy of the stream. It may be accepted only if
+// what comes back is itself a valid tree.
+static void CheckDamaged (const VXIbyte *data, VXIulong size)
+{
+  VXIValue *v = NULL;
+  if ( VXIValueDeserialize (data, size, &v) == VXIvalue_RESULT_SUCCESS ) {
+    VXIContent *c = NULL;
+    CHECK( VXIValueSerialize (v, &c) == VXIvalue_RESULT_SUCCESS,
+	   "accepted damaged input does not serialize again" );
+    VXIContentDestroy (&c);
+    VXIValueDestroy (&v);
+  }
+  CHECK( ( v == NULL ), "result not cleared" );
+}
+
+// Fixed checks of the format limits
+static void CheckLimits( )
+{
+  VXIValue *v = NULL;
+  VXIContent *c = NULL;
+  const VXIbyte *data;
+  VXIulong size;
+
+  VXIPtr *p = VXIPtrCreate (&v);
+  CHECK( VXIValueSerialize ((VXIValue *) p, &c) ==
+	 VXIvalue_RESULT_UNSUPPORTED, "VXIPtr serialized" );
+  VXIPtrDestroy (&p);
+
+  // Nesting just inside and just past the limit
+  VXIVector *inner = VXIVectorCreate( );
+  for (int depth = 1; depth <= 64; depth++) {
+    if ( depth == 64 ) {
+      CHECK( Serialize ((VXIValue *) inner, &c, &data, &size) ==
+	     VXIvalue_RESULT_SUCCESS, "depth 64 rejected" );
+      CHECK( VXIValueDeserialize (data, size, &v) ==
+	     VXIvalue_RESULT_SUCCESS, "depth 64 not decoded" );
+      VXIValueDestroy (&v);
+      VXIContentDestroy (&c);
+    }
+    VXIVector *outer = VXIVectorCreate( );
+    VXIVectorAddElement (outer, (VXIValue *) inner);
+    inner = outer;
+  }
+  CHECK( VXIValueSerialize ((VXIValue *) inner, &c) ==
+	 VXIvalue_RESULT_UNSUPPORTED, "depth 65 serialized" );
+  VXIVectorDestroy (&inner);
+
+  // Version byte and a huge element count with no elements behind it
+  VXIbyte future[] = { 'V', 'X', 'V', 2, 8 };
+  CHECK( VXIValueDeserialize (future, sizeof(future), &v) ==
+	 VXIvalue_RESULT_UNSUPPORTED, "unknown version accepted" );
+  VXIbyte huge[] = { 'V', 'X', 'V', 1, 5, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F };
+  CHECK( VXIValueDeserialize (huge, sizeof(huge), &v) ==
+	 VXIvalue_RESULT_FAILURE, "oversized vector count accepted" );
+}
+
+int main (int argc, char *argv[])
+{
+  unsigned long iterations = ( argc > 1 ? strtoul (argv[1], NULL, 10) :
+			       10000 );
+  rngState = ( argc > 2 ? strtoul (argv[2], NULL, 10) : 1 );
+
+  CheckLimits( );
+
+  for (iteration = 0; iteration < iterations; iteration++) {
+    VXIValue *v = RandomValue (0);
+    VXIContent *c1 = NULL, *c2 = NULL;
+    VXIValue *copy = NULL;
+    const VXIbyte *d1 = NULL, *d2 = NULL;
+    VXIulong n1 = 0, n2 = 0;
+
+    // Round trip
+    CHECK( Serialize (v, &c1, &d1, &n1) == VXIvalue_RESULT_SUCCESS,
+	   "serialize failed" );
+    CHECK( VXIValueDeserialize (d1, n1, &copy) == VXIvalue_RESULT_SUCCESS,
+	   "deserialize failed" );
+    CHECK( ( copy ) && ( Equal (v, copy) ), "round trip differs" );
+    CHECK( ( copy ) &&
+	   ( Serialize (copy, &c2, &d2, &n2) == VXIvalue_RESULT_SUCCESS ) &&
+	   ( n1 == n2 ) && ( memcmp (d1, d2, n1) == 0 ),
+	   "second serialization differs" );
+
+    if ( d1 ) {
+      // Every strict prefix of a stream is incomplete
+      for (VXIulong cut = 0; cut < n1; cut += 1 + Random (n1 / 16 + 1)) {
+	VXIValue *t = NULL;
+	CHECK( VXIValueDeserialize (d1, cut, &t) != VXIvalue_RESULT_SUCCESS,
+	       "truncated input accepted" );
+	VXIValueDestroy (&t);
+      }
+
+      // Random byte corruption, kept in a buffer of exactly the right
+      // size so a memory checker sees any over read
+      VXIbyte *damaged = new VXIbyte [n1];
+      for (int pass = 0; pass < 8; pass++) {
+	memcpy (damaged, d1, n1);
+	unsigned int flips = 1 + Random (4);
+	for (unsigned int i = 0; i < flips; i++)
+	  damaged[Random (n1)] ^= (VXIbyte) (1 + Random (255));
+	CheckDamaged (damaged, n1);
+      }
+      delete [] damaged;
+    }
+
+    if ( c1 ) VXIContentDestroy (&c1);
+    if ( c2 ) VXIContentDestroy (&c2);
+    VXIValueDestroy (&copy);
+    VXIValueDestroy (&v);
+  }
+
+  printf ("%lu iterations, %lu failures\n", iterations, failures);
+  return ( failures != 0 );
+}